@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core/Camera.h"
+#include "Core/Voxel.h"
+
+#include <chrono>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// Every benchmark takes the arguments following its name on the command line and returns the process exit code
+
+int RunLoadBenchmark(const std::vector<std::string>& args);
+int RunCacheBenchmark(const std::vector<std::string>& args);
+int RunTraceBenchmark(const std::vector<std::string>& args);
+int RunSlabBenchmark(const std::vector<std::string>& args);
+int RunBvhBenchmark(const std::vector<std::string>& args);
+int RunLayoutBenchmark(const std::vector<std::string>& args);
+int RunDdaBenchmark(const std::vector<std::string>& args);
+int RunBrickBenchmark(const std::vector<std::string>& args);
+int RunTreeBenchmark(const std::vector<std::string>& args);
+int RunOrderBenchmark(const std::vector<std::string>& args);
+
+// Helpers shared by the benchmarks
+
+// All .vox files in the data directory, sorted by name
+std::vector<std::string> FindScenes(const std::string& dataDir);
+
+// Loader settings from config.toml in the data directory, defaults if there is none
+VoxelLoadSettings ReadLoadSettings(const std::string& dataDir);
+
+// The scene config.toml points at, empty if there is none
+std::string ReadConfigScene(const std::string& dataDir);
+
+// Camera and lighting of a scene from its .toml, read the same way as the app does
+struct SceneSettings
+{
+    Camera View;
+    float LightIntensity = 1.0f;
+    float SkyBrightness = 1.0f;
+};
+
+SceneSettings ReadSceneSettings(const std::string& dataDir, const std::string& scene);
+
+// Milliseconds since the given time point
+double MillisecondsSince(const std::chrono::steady_clock::time_point& start);
+
+// Model space ray for checking the traversals of a model against its AABBs
+struct ModelRay
+{
+    glm::vec3 Origin;
+    glm::vec3 Direction;
+};
+
+// Half of the rays come from outside of the model and are aimed into it, the other half start inside of it like
+// the bounce rays do
+std::vector<ModelRay> MakeModelRays(const glm::vec3& size, uint32_t count, std::mt19937& rng);
+
+// Closest box the ray overlaps, clipped to [tMin, tMax]. Brute force, the reference the traversals are checked against.
+bool IntersectAABBs(std::span<const VoxAABB> aabbs, const ModelRay& ray, float tMin, float tMax, float& outT);
@@ -0,0 +1,72 @@
+#include "Benchmarks.h"
+#include "Core/Brickmap.h"
+#include "Core/VoxelExtract.h"
+#include "ogt_vox.h"
+
+#include <iomanip>
+#include <iostream>
+
+// The brick walk is checked against the voxel grid and the AABBs in Tests/BrickmapTest.cpp
+int RunBrickBenchmark(const std::vector<std::string>& args)
+{
+    std::string dataDir = args.size() > 0 ? args[0] : "Data";
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+    ThreadPool pool(settings.NumThreads);
+
+    auto scenes = FindScenes(dataDir);
+    if (scenes.empty())
+    {
+        std::cout << "No .vox files found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(16) << "Scene" << std::setw(12) << "Bricks" << std::setw(14)
+              << "Voxels/brick" << std::setw(12) << "AABB (MB)" << std::setw(12) << "Brick (MB)" << std::setw(14)
+              << "Bounds (MB)" << "Build (ms)" << std::endl;
+
+    for (auto& scene : scenes)
+    {
+        const ogt_vox_scene* voxScene = ReadVoxScene(dataDir + "/" + scene + ".vox");
+        if (voxScene == nullptr)
+        {
+            std::cout << "Failed to read " << scene << std::endl;
+            continue;
+        }
+
+        VoxelSceneData sceneData;
+        ExtractVoxelModels(voxScene, settings, pool, sceneData);
+        ogt_vox_destroy_scene(voxScene);
+
+        VoxelSceneView view = MakeSceneView(sceneData);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Brickmap> brickmaps(view.Models.size());
+        pool.ParallelFor(view.Models.size(), 1, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++)
+                brickmaps[i] = BuildBrickmap(BuildVoxelGrid(view.Models[i]));
+        });
+        double buildTime = MillisecondsSince(start);
+
+        uint64_t numBricks = 0;
+        uint64_t numVoxels = 0;
+        uint64_t brickSize = 0;
+        for (auto& brickmap : brickmaps)
+        {
+            numBricks += brickmap.Bricks.size();
+            numVoxels += brickmap.Colors.size();
+            brickSize += GetBrickmapMemorySize(brickmap);
+        }
+
+        // The BLAS are built from D3D12_RAYTRACING_AABBs, 24 bytes each
+        const uint64_t boundsSize = numBricks * 6 * sizeof(float);
+
+        std::cout << std::left << std::setw(16) << scene << std::setw(12) << numBricks << std::setw(14) << std::fixed
+                  << std::setprecision(2) << (numBricks ? (double)numVoxels / numBricks : 0.0) << std::setw(12)
+                  << view.NumAABBs * sizeof(VoxAABB) / (1024.0 * 1024.0) << std::setw(12)
+                  << brickSize / (1024.0 * 1024.0) << std::setw(14) << boundsSize / (1024.0 * 1024.0) << buildTime
+                  << std::endl;
+    }
+
+    return 0;
+}
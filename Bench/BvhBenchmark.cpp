@@ -0,0 +1,71 @@
+#include "Benchmarks.h"
+#include "Core/Bvh.h"
+#include "Core/VoxelExtract.h"
+#include "ogt_vox.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+int RunBvhBenchmark(const std::vector<std::string>& args)
+{
+    std::string dataDir = args.size() > 0 ? args[0] : "Data";
+
+    // Best of a few runs, the first run also pays for page faults
+    const uint32_t numRuns = 3;
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+    ThreadPool pool(settings.NumThreads);
+    BvhBuildSettings bvhSettings;
+
+    auto scenes = FindScenes(dataDir);
+    if (scenes.empty())
+    {
+        std::cout << "No .vox files found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    std::cout << "Threads: " << pool.GetThreadCount() << ", Bins: " << bvhSettings.NumBins
+              << ", Max leaf size: " << bvhSettings.MaxLeafSize << std::endl;
+    std::cout << std::left << std::setw(16) << "Scene" << std::setw(12) << "AABBs" << std::setw(14) << "Build (ms)"
+              << std::setw(12) << "Nodes" << std::setw(8) << "Depth" << std::setw(10) << "SAH" << std::setw(12)
+              << "Memory (MB)" << "Instances (nodes, SAH)" << std::endl;
+
+    for (auto& scene : scenes)
+    {
+        const ogt_vox_scene* voxScene = ReadVoxScene(dataDir + "/" + scene + ".vox");
+        if (voxScene == nullptr)
+        {
+            std::cout << "Failed to read " << scene << std::endl;
+            continue;
+        }
+
+        VoxelSceneData sceneData;
+        ExtractVoxelModels(voxScene, settings, pool, sceneData);
+        ogt_vox_destroy_scene(voxScene);
+
+        VoxelSceneView view = MakeSceneView(sceneData);
+
+        double bestTime = 0.0;
+        SceneBvh bvh;
+        for (uint32_t run = 0; run < numRuns; run++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            bvh = BuildSceneBvh(view, bvhSettings, pool);
+            double time = MillisecondsSince(start);
+
+            bestTime = run == 0 ? time : std::min(bestTime, time);
+        }
+
+        BvhStats models = GetModelBvhStats(bvh, bvhSettings);
+        BvhStats top = GetBvhStats(bvh.Top, bvhSettings);
+
+        std::cout << std::left << std::setw(16) << scene << std::setw(12) << sceneData.NumAABBs << std::setw(14)
+                  << std::fixed << std::setprecision(2) << bestTime << std::setw(12) << models.NumNodes << std::setw(8)
+                  << models.MaxDepth << std::setw(10) << models.SAHCost << std::setw(12)
+                  << (models.MemorySize + top.MemorySize) / (1024.0 * 1024.0) << top.NumNodes << ", " << top.SAHCost
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "Benchmarks.h"
+#include "Core/MappedFile.h"
+#include "Core/SceneCache.h"
+#include "ogt_vox.h"
+
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    // Everything LoadAsAABBs does before touching the GPU, with or without the cache
+    bool LoadScene(const std::string& voxFile, const VoxelLoadSettings& settings, bool useCache, ThreadPool& pool,
+                   uint64_t& outNumAABBs)
+    {
+        MappedFile rawVox;
+        if (!rawVox.Open(voxFile))
+            return false;
+
+        auto voxData = rawVox.GetData();
+        const uint64_t sourceHash = HashBytes(voxData.data(), voxData.size());
+
+        if (useCache)
+        {
+            MappedFile cacheData;
+            VoxelSceneView view;
+            if (!cacheData.Open(GetSceneCachePath(voxFile)) ||
+                !OpenSceneCache(cacheData.GetData(), sourceHash, settings, view))
+                return false;
+
+            outNumAABBs = view.NumAABBs;
+            return true;
+        }
+
+        const ogt_vox_scene* voxScene = ogt_vox_read_scene(voxData.data(), (uint32_t)voxData.size());
+        if (voxScene == nullptr)
+            return false;
+
+        VoxelSceneData sceneData;
+        ExtractVoxelModels(voxScene, settings, pool, sceneData);
+        ogt_vox_destroy_scene(voxScene);
+
+        outNumAABBs = sceneData.NumAABBs;
+        return true;
+    }
+} // namespace
+
+int RunCacheBenchmark(const std::vector<std::string>& args)
+{
+    std::string dataDir = args.size() > 0 ? args[0] : "Data";
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+    ThreadPool pool(settings.NumThreads);
+
+    auto scenes = FindScenes(dataDir);
+    if (scenes.empty())
+    {
+        std::cout << "No .vox files found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(16) << "Scene" << std::setw(16) << "No Cache (ms)" << std::setw(16)
+              << "Cached (ms)" << std::setw(16) << "Cache Size (MB)" << "AABBs" << std::endl;
+
+    for (auto& scene : scenes)
+    {
+        const std::string voxFile = dataDir + "/" + scene + ".vox";
+
+        uint64_t numAABBs = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (!LoadScene(voxFile, settings, false, pool, numAABBs))
+        {
+            std::cout << "Failed to load " << scene << std::endl;
+            continue;
+        }
+        double uncachedTime = MillisecondsSince(start);
+
+        // Build the cache for the timed cached load
+        {
+            MappedFile rawVox;
+            rawVox.Open(voxFile);
+            auto voxData = rawVox.GetData();
+
+            const ogt_vox_scene* voxScene = ogt_vox_read_scene(voxData.data(), (uint32_t)voxData.size());
+            VoxelSceneData sceneData;
+            ExtractVoxelModels(voxScene, settings, pool, sceneData);
+            ogt_vox_destroy_scene(voxScene);
+
+            if (!WriteSceneCache(GetSceneCachePath(voxFile), HashBytes(voxData.data(), voxData.size()), settings,
+                                 MakeSceneView(sceneData)))
+            {
+                std::cout << "Failed to write the cache of " << scene << std::endl;
+                continue;
+            }
+        }
+
+        uint64_t numCachedAABBs = 0;
+        start = std::chrono::steady_clock::now();
+        if (!LoadScene(voxFile, settings, true, pool, numCachedAABBs) || numCachedAABBs != numAABBs)
+        {
+            std::cout << "Failed to load the cache of " << scene << std::endl;
+            continue;
+        }
+        double cachedTime = MillisecondsSince(start);
+
+        MappedFile cacheData;
+        cacheData.Open(GetSceneCachePath(voxFile));
+
+        std::cout << std::left << std::setw(16) << scene << std::fixed << std::setprecision(2) << std::setw(16)
+                  << uncachedTime << std::setw(16) << cachedTime << std::setw(16)
+                  << cacheData.GetData().size() / (1024.0 * 1024.0) << numAABBs << std::endl;
+    }
+
+    return 0;
+}
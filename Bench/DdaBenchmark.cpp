@@ -0,0 +1,113 @@
+#include "Benchmarks.h"
+#include "Core/VoxelExtract.h"
+#include "Core/VoxelGrid.h"
+#include "ogt_vox.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+int RunDdaBenchmark(const std::vector<std::string>& args)
+{
+    uint32_t raysPerModel = args.size() > 0 ? std::stoul(args[0]) : 64;
+    std::string dataDir = args.size() > 1 ? args[1] : "Data";
+
+    // The timed walks repeat the checked rays, the brute force reference is too slow for more
+    const uint32_t timedPasses = 64;
+    const float tMax = 10000.0f;
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+    ThreadPool pool(settings.NumThreads);
+
+    auto scenes = FindScenes(dataDir);
+    if (scenes.empty())
+    {
+        std::cout << "No .vox files found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    std::cout << raysPerModel << " rays per model checked against the model's AABBs" << std::endl;
+    std::cout << std::left << std::setw(16) << "Scene" << std::setw(10) << "Models" << std::setw(12) << "AABB (MB)"
+              << std::setw(12) << "Grid (MB)" << std::setw(14) << "Build (ms)" << std::setw(12) << "MRays/s"
+              << "Mismatches" << std::endl;
+
+    bool allMatch = true;
+
+    for (auto& scene : scenes)
+    {
+        const ogt_vox_scene* voxScene = ReadVoxScene(dataDir + "/" + scene + ".vox");
+        if (voxScene == nullptr)
+        {
+            std::cout << "Failed to read " << scene << std::endl;
+            continue;
+        }
+
+        VoxelSceneData sceneData;
+        ExtractVoxelModels(voxScene, settings, pool, sceneData);
+        ogt_vox_destroy_scene(voxScene);
+
+        VoxelSceneView view = MakeSceneView(sceneData);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<VoxelGrid> grids(view.Models.size());
+        pool.ParallelFor(view.Models.size(), 1, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++)
+                grids[i] = BuildVoxelGrid(view.Models[i]);
+        });
+        double buildTime = MillisecondsSince(start);
+
+        uint64_t gridSize = 0;
+        for (auto& grid : grids)
+            gridSize += GetVoxelGridBufferSize(grid);
+
+        std::mt19937 rng(1234);
+        uint64_t mismatches = 0;
+        uint64_t numRays = 0;
+        double traceTime = 0.0;
+
+        for (uint64_t i = 0; i < view.Models.size(); i++)
+        {
+            auto& model = view.Models[i];
+            std::vector<ModelRay> rays = MakeModelRays(model.Size, raysPerModel, rng);
+
+            for (auto& ray : rays)
+            {
+                VoxelGridHit hit;
+                const bool gridHit = TraceVoxelGrid(grids[i], ray.Origin, ray.Direction, 0.0f, tMax, hit);
+
+                float t = 0.0f;
+                const bool boxHit = IntersectAABBs(model.AABBs, ray, 0.0f, tMax, t);
+
+                // The walk accumulates its distances, so allow for a little drift
+                if (gridHit != boxHit || (gridHit && std::abs(hit.T - t) > 1e-3f * std::max(1.0f, t)))
+                    mismatches++;
+            }
+
+            uint32_t numHits = 0;
+            start = std::chrono::steady_clock::now();
+            for (uint32_t pass = 0; pass < timedPasses; pass++)
+            {
+                for (auto& ray : rays)
+                {
+                    VoxelGridHit hit;
+                    numHits += TraceVoxelGrid(grids[i], ray.Origin, ray.Direction, 0.0f, tMax, hit);
+                }
+            }
+            traceTime += MillisecondsSince(start);
+            numRays += (uint64_t)rays.size() * timedPasses;
+
+            // Keeps the timed walks from being optimized away
+            if (numHits == UINT32_MAX)
+                std::cout << std::endl;
+        }
+
+        allMatch &= mismatches == 0;
+
+        std::cout << std::left << std::setw(16) << scene << std::setw(10) << view.Models.size() << std::setw(12)
+                  << std::fixed << std::setprecision(2) << view.NumAABBs * sizeof(VoxAABB) / (1024.0 * 1024.0)
+                  << std::setw(12) << gridSize / (1024.0 * 1024.0) << std::setw(14) << buildTime << std::setw(12)
+                  << numRays / (traceTime * 1000.0) << mismatches << std::endl;
+    }
+
+    return allMatch ? 0 : 1;
+}
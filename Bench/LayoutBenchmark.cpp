@@ -0,0 +1,77 @@
+#include "Benchmarks.h"
+#include "Core/CpuTracer.h"
+#include "Core/VoxelExtract.h"
+#include "ogt_vox.h"
+
+#include <iomanip>
+#include <iostream>
+
+int RunLayoutBenchmark(const std::vector<std::string>& args)
+{
+    uint32_t numFrames = args.size() > 0 ? std::stoul(args[0]) : 4;
+    uint32_t width = args.size() > 1 ? std::stoul(args[1]) : 480;
+    uint32_t height = args.size() > 2 ? std::stoul(args[2]) : 270;
+    std::string dataDir = args.size() > 3 ? args[3] : "Data";
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+    ThreadPool pool(settings.NumThreads);
+
+    auto scenes = FindScenes(dataDir);
+    if (scenes.empty())
+    {
+        std::cout << "No .vox files found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    std::cout << width << "x" << height << ", " << numFrames << " frames, " << pool.GetThreadCount() << " threads"
+              << std::endl;
+    std::cout << std::left << std::setw(16) << "Scene" << std::setw(10) << "Layout" << std::setw(14) << "Build (ms)"
+              << std::setw(14) << "Memory (MB)" << "MRays/s" << std::endl;
+
+    for (auto& scene : scenes)
+    {
+        const ogt_vox_scene* voxScene = ReadVoxScene(dataDir + "/" + scene + ".vox");
+        if (voxScene == nullptr)
+        {
+            std::cout << "Failed to read " << scene << std::endl;
+            continue;
+        }
+
+        VoxelSceneData sceneData;
+        ExtractVoxelModels(voxScene, settings, pool, sceneData);
+        ogt_vox_destroy_scene(voxScene);
+
+        SceneSettings sceneSettings = ReadSceneSettings(dataDir, scene);
+        sceneSettings.View.AspectRatio = (float)width / (float)height;
+
+        for (BvhLayout layout : {BvhLayout::Binary, BvhLayout::Wide})
+        {
+            auto start = std::chrono::steady_clock::now();
+            CpuTracer tracer(MakeSceneView(sceneData), pool, BvhBuildSettings(), layout, settings.MergeVoxels);
+            double buildTime = MillisecondsSince(start);
+
+            std::vector<glm::vec4> accumulation;
+            std::vector<glm::vec4> output;
+
+            // Same frames as the trace benchmark, so both layouts trace the same rays
+            uint64_t totalRays = 0;
+            start = std::chrono::steady_clock::now();
+            for (uint32_t frame = 0; frame < numFrames; frame++)
+            {
+                const float time = (frame + 1) / 60.0f;
+                SceneConstants constants = MakeSceneConstants(
+                    sceneSettings.View, frame, time, sceneSettings.LightIntensity, sceneSettings.SkyBrightness);
+                totalRays += tracer.Render(constants, width, height, pool, accumulation, output);
+            }
+            double traceTime = MillisecondsSince(start);
+
+            std::cout << std::left << std::setw(16) << scene << std::setw(10)
+                      << (layout == BvhLayout::Binary ? "Binary" : "Wide") << std::setw(14) << std::fixed
+                      << std::setprecision(2) << buildTime << std::setw(14)
+                      << tracer.GetBvhMemorySize() / (1024.0 * 1024.0) << totalRays / (traceTime * 1000.0)
+                      << std::endl;
+        }
+    }
+
+    return 0;
+}
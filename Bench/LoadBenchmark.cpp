@@ -0,0 +1,76 @@
+#include "Benchmarks.h"
+#include "Core/VoxelExtract.h"
+#include "ogt_vox.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+int RunLoadBenchmark(const std::vector<std::string>& args)
+{
+    uint32_t maxThreads = args.size() > 0 ? std::stoul(args[0]) : std::max(1u, std::thread::hardware_concurrency());
+    std::string dataDir = args.size() > 1 ? args[1] : "Data";
+
+    // Best of a few runs, the first run also pays for page faults
+    const uint32_t numRuns = 3;
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+
+    auto scenes = FindScenes(dataDir);
+    if (scenes.empty())
+    {
+        std::cout << "No .vox files found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    std::cout << "Merge: " << settings.MergeVoxels << ", Cull: " << settings.CullInteriorVoxels << std::endl;
+    std::cout << std::left << std::setw(16) << "Scene" << std::setw(10) << "Threads" << std::setw(14) << "Parse (ms)"
+              << std::setw(16) << "Extract (ms)" << std::setw(10) << "Speedup" << "AABBs" << std::endl;
+
+    for (auto& scene : scenes)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const ogt_vox_scene* voxScene = ReadVoxScene(dataDir + "/" + scene + ".vox");
+        double parseTime = MillisecondsSince(start);
+
+        if (voxScene == nullptr)
+        {
+            std::cout << "Failed to read " << scene << std::endl;
+            continue;
+        }
+
+        double singleThreadTime = 0.0;
+
+        for (uint32_t threads = 1; threads <= maxThreads; threads++)
+        {
+            ThreadPool pool(threads);
+
+            double bestTime = 0.0;
+            uint64_t numAABBs = 0;
+            for (uint32_t run = 0; run < numRuns; run++)
+            {
+                VoxelSceneData sceneData;
+
+                start = std::chrono::steady_clock::now();
+                ExtractVoxelModels(voxScene, settings, pool, sceneData);
+                double time = MillisecondsSince(start);
+
+                bestTime = run == 0 ? time : std::min(bestTime, time);
+                numAABBs = sceneData.NumAABBs;
+            }
+
+            if (threads == 1)
+                singleThreadTime = bestTime;
+
+            std::cout << std::left << std::setw(16) << scene << std::setw(10) << threads << std::setw(14)
+                      << std::fixed << std::setprecision(2) << parseTime << std::setw(16) << bestTime
+                      << std::setw(10) << singleThreadTime / bestTime << numAABBs << std::endl;
+        }
+
+        ogt_vox_destroy_scene(voxScene);
+    }
+
+    return 0;
+}
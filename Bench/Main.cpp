@@ -0,0 +1,189 @@
+#include "Benchmarks.h"
+#include "Core/MortonOrder.h"
+
+#include <toml++/toml.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+std::vector<std::string> FindScenes(const std::string& dataDir)
+{
+    std::vector<std::string> scenes;
+
+    std::error_code error;
+    for (auto& entry : std::filesystem::directory_iterator(dataDir, error))
+    {
+        if (entry.path().extension() == ".vox")
+            scenes.push_back(entry.path().stem().string());
+    }
+
+    std::sort(scenes.begin(), scenes.end());
+    return scenes;
+}
+
+VoxelLoadSettings ReadLoadSettings(const std::string& dataDir)
+{
+    VoxelLoadSettings settings;
+
+    toml::parse_result config = toml::parse_file(dataDir + "/config.toml");
+    if (!config)
+        return settings;
+
+    settings.MergeVoxels = config["merge_voxels"].value_or(false);
+    settings.CullInteriorVoxels = config["cull_interior_voxels"].value_or(false);
+    settings.AABBOrder = ParseVoxelOrder(config["voxel_order"].value_or(""));
+    settings.NumThreads = config["loader_threads"].value_or(0);
+    settings.UseSceneCache = config["scene_cache"].value_or(false);
+
+    return settings;
+}
+
+std::string ReadConfigScene(const std::string& dataDir)
+{
+    toml::parse_result config = toml::parse_file(dataDir + "/config.toml");
+    if (!config)
+        return {};
+
+    return std::string(config["scene"].value_or(""));
+}
+
+SceneSettings ReadSceneSettings(const std::string& dataDir, const std::string& scene)
+{
+    SceneSettings settings;
+
+    toml::parse_result sceneConfig = toml::parse_file(dataDir + "/" + scene + ".toml");
+    if (!sceneConfig)
+        return settings;
+
+    settings.LightIntensity = sceneConfig["Scene"]["light_intensity"].value_or(1.0);
+    settings.SkyBrightness = sceneConfig["Scene"]["sky_brightness"].value_or(1.0);
+
+    Camera& camera = settings.View;
+    camera.Position.x = sceneConfig["Camera"]["x"].value_or(0.0);
+    camera.Position.y = sceneConfig["Camera"]["y"].value_or(0.0);
+    camera.Position.z = sceneConfig["Camera"]["z"].value_or(0.0);
+    camera.Fov = sceneConfig["Camera"]["fov"].value_or(45.0);
+
+    float pitch = sceneConfig["Camera"]["pitch"].value_or(0.0);
+    float yaw = sceneConfig["Camera"]["yaw"].value_or(0.0);
+    float roll = sceneConfig["Camera"]["roll"].value_or(0.0);
+    camera.SetRotation(pitch, yaw, roll);
+
+    return settings;
+}
+
+double MillisecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+    std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    return duration.count();
+}
+
+std::vector<ModelRay> MakeModelRays(const glm::vec3& size, uint32_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto randomPoint = [&]() { return glm::vec3(unit(rng), unit(rng), unit(rng)) * size - 0.5f; };
+
+    const glm::vec3 center = size * 0.5f - 0.5f;
+    const float radius = glm::length(size);
+
+    std::vector<ModelRay> rays(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec3 origin = randomPoint();
+        if (i % 2 == 0)
+            origin = center + glm::normalize(randomPoint() - center + 0.01f) * radius;
+
+        rays[i] = {origin, glm::normalize(randomPoint() - origin)};
+    }
+    return rays;
+}
+
+bool IntersectAABBs(std::span<const VoxAABB> aabbs, const ModelRay& ray, float tMin, float tMax, float& outT)
+{
+    const glm::vec3 invDir = 1.0f / ray.Direction;
+    bool found = false;
+
+    for (auto& aabb : aabbs)
+    {
+        const glm::vec3 t0 = (aabb.Min - ray.Origin) * invDir;
+        const glm::vec3 t1 = (aabb.Max - ray.Origin) * invDir;
+        const glm::vec3 tLow = glm::min(t0, t1);
+        const glm::vec3 tHigh = glm::max(t0, t1);
+
+        const float tNear = std::max(std::max(std::max(tLow.x, tLow.y), tLow.z), tMin);
+        const float tFar = std::min(std::min(std::min(tHigh.x, tHigh.y), tHigh.z), tMax);
+
+        if (tNear <= tFar)
+        {
+            tMax = tNear;
+            outT = tNear;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    if (args.empty())
+    {
+        std::cout << "Usage: VoxelBench <benchmark> [args...]" << std::endl;
+        std::cout << "  load [max threads] [data dir]   Time the voxel extraction of every scene with 1..N threads"
+                  << std::endl;
+        std::cout << "  cache [data dir]                Time scene loading with and without the scene cache"
+                  << std::endl;
+        std::cout << "  trace [frames] [width] [height] [data dir]" << std::endl;
+        std::cout << "                                  Render the configured scene with the CPU tracer, report rays/s"
+                  << std::endl;
+        std::cout << "  slab [box tests]                Compare the SIMD slab test kernels against the scalar one"
+                  << std::endl;
+        std::cout << "  bvh [data dir]                  Build the CPU BVHs of every scene, report time, nodes and SAH"
+                  << std::endl;
+        std::cout << "  layout [frames] [width] [height] [data dir]" << std::endl;
+        std::cout << "                                  Compare binary and 8-wide BVHs per scene, memory and rays/s"
+                  << std::endl;
+        std::cout << "  dda [rays per model] [data dir] Check the voxel grid walk against the AABBs, memory and rays/s"
+                  << std::endl;
+        std::cout << "  brick [data dir]                Build the 8^3 brickmaps of every scene, memory and build time"
+                  << std::endl;
+        std::cout << "  tree [rays per model] [data dir]" << std::endl;
+        std::cout << "                                  Build sparse 64-trees, check their traversal against the grid"
+                  << std::endl;
+        std::cout << "  order [frames] [width] [height] [data dir]" << std::endl;
+        std::cout << "                                  Compare linear, Morton and Hilbert box orders, build and rays/s"
+                  << std::endl;
+        return 1;
+    }
+
+    const std::string benchmark = args[0];
+    args.erase(args.begin());
+
+    if (benchmark == "load")
+        return RunLoadBenchmark(args);
+    if (benchmark == "cache")
+        return RunCacheBenchmark(args);
+    if (benchmark == "trace")
+        return RunTraceBenchmark(args);
+    if (benchmark == "slab")
+        return RunSlabBenchmark(args);
+    if (benchmark == "bvh")
+        return RunBvhBenchmark(args);
+    if (benchmark == "layout")
+        return RunLayoutBenchmark(args);
+    if (benchmark == "dda")
+        return RunDdaBenchmark(args);
+    if (benchmark == "brick")
+        return RunBrickBenchmark(args);
+    if (benchmark == "tree")
+        return RunTreeBenchmark(args);
+    if (benchmark == "order")
+        return RunOrderBenchmark(args);
+
+    std::cout << "Unknown benchmark: " << benchmark << std::endl;
+    return 1;
+}
@@ -0,0 +1,124 @@
+#include "Benchmarks.h"
+#include "Core/SlabKernel.h"
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// Random small boxes in a 64^3 volume and rays from outside of it aimed into the volume. Like in a voxel model
+// most boxes a ray is tested against are misses
+static std::vector<VoxAABB> MakeRandomBoxes(uint32_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(0.0f, 64.0f);
+    std::uniform_real_distribution<float> extent(1.0f, 4.0f);
+
+    std::vector<VoxAABB> boxes(count);
+    for (auto& box : boxes)
+    {
+        box.Min = glm::vec3(position(rng), position(rng), position(rng));
+        box.Max = box.Min + glm::vec3(extent(rng), extent(rng), extent(rng));
+    }
+    return boxes;
+}
+
+static std::vector<SlabRay> MakeRandomRays(uint32_t count, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+    std::vector<SlabRay> rays(count);
+    for (auto& ray : rays)
+    {
+        glm::vec3 origin = glm::vec3(32.0f) + glm::normalize(glm::vec3(offset(rng), offset(rng), offset(rng))) * 100.0f;
+        glm::vec3 target = glm::vec3(32.0f) + glm::vec3(offset(rng), offset(rng), offset(rng)) * 32.0f;
+        glm::vec3 direction = glm::normalize(target - origin);
+
+        ray = {origin, 1.0f / direction, 0.0f, 1000.0f};
+    }
+    return rays;
+}
+
+int RunSlabBenchmark(const std::vector<std::string>& args)
+{
+    uint64_t testsPerCount = args.size() > 0 ? std::stoull(args[0]) : 1ull << 24;
+
+    const uint32_t boxCounts[] = {8, 64, 512, 4096, 32768};
+    const uint32_t numRays = 256;
+
+    std::vector<SimdLevel> levels = {SimdLevel::Scalar};
+    for (SimdLevel level : {SimdLevel::SSE, SimdLevel::AVX2})
+    {
+        if (level <= GetSupportedSimdLevel() && GetSlabKernel(level) != GetSlabKernel(SimdLevel::Scalar))
+            levels.push_back(level);
+    }
+
+    std::cout << "Best supported kernel: " << GetSimdLevelName(GetSupportedSimdLevel()) << ", about "
+              << testsPerCount << " box tests per run" << std::endl;
+
+    std::mt19937 rng(1234);
+    std::vector<SlabRay> rays = MakeRandomRays(numRays, rng);
+
+    std::cout << std::left << std::setw(10) << "Boxes" << std::setw(10) << "Kernel" << std::setw(14) << "Mboxes/s"
+              << std::setw(10) << "Speedup" << "Hit rate" << std::endl;
+
+    bool allMatch = true;
+
+    for (uint32_t boxCount : boxCounts)
+    {
+        std::vector<VoxAABB> boxes = MakeRandomBoxes(boxCount, rng);
+        std::vector<AABBPacket8> packets;
+        PackAABBs8(boxes, packets);
+
+        // Every level runs over the same rays and boxes, the masks of the scalar kernel are the reference
+        const uint64_t passes = std::max<uint64_t>(1, testsPerCount / ((uint64_t)boxCount * numRays));
+        std::vector<uint32_t> reference;
+        double scalarRate = 0.0;
+
+        for (SimdLevel level : levels)
+        {
+            SlabKernel kernel = GetSlabKernel(level);
+            std::vector<uint32_t> masks(packets.size() * numRays);
+
+            uint64_t hits = 0;
+            auto start = std::chrono::steady_clock::now();
+
+            for (uint64_t pass = 0; pass < passes; pass++)
+            {
+                hits = 0;
+                for (uint32_t r = 0; r < numRays; r++)
+                {
+                    for (uint64_t p = 0; p < packets.size(); p++)
+                    {
+                        float tNear[8];
+                        uint32_t mask = kernel(rays[r], packets[p], tNear);
+                        masks[r * packets.size() + p] = mask;
+                        hits += std::popcount(mask);
+                    }
+                }
+            }
+
+            double ms = MillisecondsSince(start);
+            double rate = (double)passes * boxCount * numRays / (ms * 1000.0);
+
+            if (level == SimdLevel::Scalar)
+            {
+                reference = masks;
+                scalarRate = rate;
+            }
+            else if (masks != reference)
+            {
+                std::cout << GetSimdLevelName(level) << " disagrees with the scalar kernel at " << boxCount
+                          << " boxes" << std::endl;
+                allMatch = false;
+            }
+
+            std::cout << std::left << std::setw(10) << boxCount << std::setw(10) << GetSimdLevelName(level)
+                      << std::setw(14) << std::fixed << std::setprecision(1) << rate << std::setw(10)
+                      << std::setprecision(2) << rate / scalarRate << std::setprecision(3)
+                      << (double)hits / ((double)boxCount * numRays) << std::endl;
+        }
+    }
+
+    return allMatch ? 0 : 1;
+}
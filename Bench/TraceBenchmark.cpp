@@ -0,0 +1,127 @@
+#include "Benchmarks.h"
+#include "Core/BenchmarkStats.h"
+#include "Core/CpuTracer.h"
+#include "Core/FrameLoop.h"
+#include "Core/ImageWriter.h"
+#include "Core/MappedFile.h"
+#include "ogt_vox.h"
+
+#include <iomanip>
+#include <iostream>
+
+namespace
+{
+    // The app's frame loop on the CPU tracer, a fixed number of frames like a headless run
+    class CpuTraceLoop : public FrameLoop
+    {
+    public:
+        CpuTraceLoop(const CpuTracer& tracer, const SceneSettings& sceneSettings, uint32_t width, uint32_t height,
+                     uint32_t numFrames, ThreadPool& pool)
+            : mTracer(tracer), mSceneSettings(sceneSettings), mWidth(width), mHeight(height), mNumFrames(numFrames),
+              mPool(pool)
+        {
+        }
+
+        void BeginFrame() override
+        {
+            // A fixed time per frame keeps the image reproducible, the shaders seed their random numbers with it
+            const float time = (mFrame + 1) / 60.0f;
+            mConstants = MakeSceneConstants(mSceneSettings.View, mFrame, time, mSceneSettings.LightIntensity,
+                                            mSceneSettings.SkyBrightness);
+        }
+
+        void Update() override
+        {
+            auto start = std::chrono::steady_clock::now();
+            TotalRays += mTracer.Render(mConstants, mWidth, mHeight, mPool, mAccumulation, Output);
+            FrameTimes.push_back(MillisecondsSince(start));
+            TotalTime += FrameTimes.back();
+        }
+
+        void EndFrame() override { mFrame++; }
+
+        bool ShouldStop() const override { return mFrame >= mNumFrames; }
+
+    public:
+        std::vector<glm::vec4> Output;
+        std::vector<double> FrameTimes;
+        uint64_t TotalRays = 0;
+        double TotalTime = 0.0;
+
+    private:
+        const CpuTracer& mTracer;
+        SceneSettings mSceneSettings;
+        uint32_t mWidth;
+        uint32_t mHeight;
+        uint32_t mNumFrames;
+        ThreadPool& mPool;
+
+        uint32_t mFrame = 0;
+        SceneConstants mConstants;
+        std::vector<glm::vec4> mAccumulation;
+    };
+} // namespace
+
+int RunTraceBenchmark(const std::vector<std::string>& args)
+{
+    uint32_t numFrames = args.size() > 0 ? std::stoul(args[0]) : 16;
+    uint32_t width = args.size() > 1 ? std::stoul(args[1]) : 480;
+    uint32_t height = args.size() > 2 ? std::stoul(args[2]) : 270;
+    std::string dataDir = args.size() > 3 ? args[3] : "Data";
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+    ThreadPool pool(settings.NumThreads);
+
+    const std::string scene = ReadConfigScene(dataDir);
+
+    MappedFile voxFile;
+    if (scene.empty() || !voxFile.Open(dataDir + "/" + scene + ".vox"))
+    {
+        std::cout << "Failed to open the scene in " << dataDir << "/config.toml" << std::endl;
+        return 1;
+    }
+
+    auto voxData = voxFile.GetData();
+    const ogt_vox_scene* voxScene = ogt_vox_read_scene(voxData.data(), (uint32_t)voxData.size());
+    if (voxScene == nullptr)
+    {
+        std::cout << "Failed to read " << scene << std::endl;
+        return 1;
+    }
+
+    VoxelSceneData sceneData;
+    ExtractVoxelModels(voxScene, settings, pool, sceneData);
+    ogt_vox_destroy_scene(voxScene);
+
+    SceneSettings sceneSettings = ReadSceneSettings(dataDir, scene);
+    sceneSettings.View.AspectRatio = (float)width / (float)height;
+
+    auto buildStart = std::chrono::steady_clock::now();
+    CpuTracer tracer(MakeSceneView(sceneData), pool, BvhBuildSettings(), BvhLayout::Binary, settings.MergeVoxels);
+    double bvhTime = MillisecondsSince(buildStart);
+
+    std::cout << "Scene: " << scene << ", " << width << "x" << height << ", " << numFrames << " frames, "
+              << pool.GetThreadCount() << " threads, " << sceneData.NumAABBs << " AABBs" << std::endl;
+    std::cout << "BVH build: " << std::fixed << std::setprecision(2) << bvhTime << " ms" << std::endl;
+
+    CpuTraceLoop loop(tracer, sceneSettings, width, height, numFrames, pool);
+    RunFrameLoop(loop);
+
+    const uint64_t totalRays = loop.TotalRays;
+    const double totalTime = loop.TotalTime;
+
+    std::cout << std::fixed << std::setprecision(2) << "Time: " << totalTime << " ms, "
+              << totalTime / std::max(1u, numFrames) << " ms/frame" << std::endl;
+    PrintSampleStats(std::cout, "Frame time (ms)", ComputeSampleStats(loop.FrameTimes, 0));
+    std::cout << "Rays: " << totalRays << ", " << totalRays / (totalTime * 1000.0) << " MRays/s" << std::endl;
+
+    const std::string imageFile = scene + "-cpu.png";
+    if (!WritePNG(imageFile, width, height, ConvertToRGBA8(loop.Output).data()))
+    {
+        std::cout << "Failed to write " << imageFile << std::endl;
+        return 1;
+    }
+
+    std::cout << "Image: " << imageFile << std::endl;
+    return 0;
+}
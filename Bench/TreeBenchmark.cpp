@@ -0,0 +1,112 @@
+#include "Benchmarks.h"
+#include "Core/SparseTree64.h"
+#include "Core/VoxelExtract.h"
+#include "ogt_vox.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+int RunTreeBenchmark(const std::vector<std::string>& args)
+{
+    uint32_t raysPerModel = args.size() > 0 ? std::stoul(args[0]) : 1024;
+    std::string dataDir = args.size() > 1 ? args[1] : "Data";
+
+    const float tMax = 10000.0f;
+
+    VoxelLoadSettings settings = ReadLoadSettings(dataDir);
+    ThreadPool pool(settings.NumThreads);
+
+    auto scenes = FindScenes(dataDir);
+    if (scenes.empty())
+    {
+        std::cout << "No .vox files found in " << dataDir << std::endl;
+        return 1;
+    }
+
+    std::cout << raysPerModel << " rays per model checked against the voxel grid walk" << std::endl;
+    std::cout << std::left << std::setw(16) << "Scene" << std::setw(14) << "Build (ms)" << std::setw(12) << "Nodes"
+              << std::setw(12) << "Tree (MB)" << std::setw(14) << "Bytes/voxel" << std::setw(14) << "Tree MRays/s"
+              << std::setw(14) << "Grid MRays/s" << "Mismatches" << std::endl;
+
+    bool allMatch = true;
+
+    for (auto& scene : scenes)
+    {
+        const ogt_vox_scene* voxScene = ReadVoxScene(dataDir + "/" + scene + ".vox");
+        if (voxScene == nullptr)
+        {
+            std::cout << "Failed to read " << scene << std::endl;
+            continue;
+        }
+
+        VoxelSceneData sceneData;
+        ExtractVoxelModels(voxScene, settings, pool, sceneData);
+        ogt_vox_destroy_scene(voxScene);
+
+        VoxelSceneView view = MakeSceneView(sceneData);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SparseTree64> trees = BuildSparseTrees64(view.Models, pool);
+        double buildTime = MillisecondsSince(start);
+
+        uint64_t numNodes = 0;
+        uint64_t numVoxels = 0;
+        uint64_t treeSize = 0;
+        for (auto& tree : trees)
+        {
+            numNodes += tree.Nodes.size();
+            numVoxels += tree.Colors.size();
+            treeSize += GetSparseTree64MemorySize(tree);
+        }
+
+        std::mt19937 rng(1234);
+        uint64_t mismatches = 0;
+        uint64_t numRays = 0;
+        double treeTime = 0.0;
+        double gridTime = 0.0;
+
+        for (uint64_t i = 0; i < view.Models.size(); i++)
+        {
+            const VoxelGrid grid = BuildVoxelGrid(view.Models[i]);
+            const std::vector<ModelRay> rays = MakeModelRays(view.Models[i].Size, raysPerModel, rng);
+
+            std::vector<VoxelGridHit> treeHits(rays.size());
+            std::vector<bool> treeFound(rays.size());
+
+            start = std::chrono::steady_clock::now();
+            for (uint64_t r = 0; r < rays.size(); r++)
+                treeFound[r] = TraceSparseTree64(trees[i], rays[r].Origin, rays[r].Direction, 0.0f, tMax, treeHits[r]);
+            treeTime += MillisecondsSince(start);
+
+            std::vector<VoxelGridHit> gridHits(rays.size());
+            std::vector<bool> gridFound(rays.size());
+
+            start = std::chrono::steady_clock::now();
+            for (uint64_t r = 0; r < rays.size(); r++)
+                gridFound[r] = TraceVoxelGrid(grid, rays[r].Origin, rays[r].Direction, 0.0f, tMax, gridHits[r]);
+            gridTime += MillisecondsSince(start);
+
+            numRays += rays.size();
+
+            // The grid walk accumulates its distances, so allow for a little drift
+            for (uint64_t r = 0; r < rays.size(); r++)
+            {
+                const float t = gridHits[r].T;
+                if (treeFound[r] != gridFound[r] ||
+                    (gridFound[r] && std::abs(treeHits[r].T - t) > 1e-3f * std::max(1.0f, t)))
+                    mismatches++;
+            }
+        }
+
+        allMatch &= mismatches == 0;
+
+        std::cout << std::left << std::setw(16) << scene << std::setw(14) << std::fixed << std::setprecision(2)
+                  << buildTime << std::setw(12) << numNodes << std::setw(12) << treeSize / (1024.0 * 1024.0)
+                  << std::setw(14) << (numVoxels ? (double)treeSize / numVoxels : 0.0) << std::setw(14)
+                  << numRays / (treeTime * 1000.0) << std::setw(14) << numRays / (gridTime * 1000.0) << mismatches
+                  << std::endl;
+    }
+
+    return allMatch ? 0 : 1;
+}
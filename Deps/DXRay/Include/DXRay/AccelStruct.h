@@ -41,6 +41,13 @@ namespace DXR
         D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS Flags =
             D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE;
 
+        /// @brief TLAS & BLAS; Optional address the compacted size is written to when the acceleration structure is
+        /// built, as a D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC.
+        /// Requires D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION in Flags. The memory must be
+        /// 8 byte aligned and in the UNORDERED_ACCESS state when building, see AllocateAndAssignCompactedSizeBuffer.
+        /// @note This is the GPU virtual address, hence the "vp" prefix for "virtual pointer".
+        D3D12_GPU_VIRTUAL_ADDRESS vpCompactedSizeInfo = 0;
+
         // @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
         // @@@@@@@@@@@@@@@@@ Bottom Level Acceleration Structure @@@@@@@@@@@@@@@@@@
         // @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
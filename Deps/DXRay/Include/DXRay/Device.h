@@ -125,6 +125,26 @@ namespace DXR
         /// @return The new scratch buffer
         ComPtr<DMA::Allocation> AllocateScratchBuffer(UINT64 size);
 
+        /// @brief Allocate a buffer that receives the compacted sizes of the acceleration structures when they are
+        /// built, and assign each description's vpCompactedSizeInfo an 8 byte slot of it, in order. The buffer is in
+        /// the UNORDERED_ACCESS state and in GPU memory; copy it to a READBACK buffer to read the sizes on the CPU.
+        /// @param descs The descriptions of the acceleration structures, should be built with ALLOW_COMPACTION
+        /// @return The new compacted size buffer
+        ComPtr<DMA::Allocation> AllocateAndAssignCompactedSizeBuffer(std::vector<AccelerationStructureDesc>& descs);
+
+        /// @brief Compact a built acceleration structure. Allocates a buffer of the compacted size and records the
+        /// compacting copy. The GPU must have finished building the source, since the compacted size comes from it.
+        /// @param desc The description the acceleration structure was built with. Its destination is updated to the
+        /// compacted acceleration structure, it can't be rebuilt in place afterwards.
+        /// @param accel The built acceleration structure, replaced by the compacted allocation.
+        /// @param compactedSize The size read back from the desc's vpCompactedSizeInfo
+        /// @param cmdList The command list to record the copy into
+        /// @return The original allocation, it must be kept alive until the copy has been executed
+        /// @note Instance descriptions referencing the original BLAS must be updated to the compacted address.
+        ComPtr<DMA::Allocation> CompactAccelerationStructure(AccelerationStructureDesc& desc,
+                                                             ComPtr<DMA::Allocation>& accel, UINT64 compactedSize,
+                                                             ComPtr<ID3D12GraphicsCommandList4>& cmdList);
+
         /// @brief Allocate a instance buffer for a top level acceleration structure. These must then be filled with
         /// valid instance descriptions when building the acceleration structure. Can be discarded after building, but
         /// better if reused every frame.
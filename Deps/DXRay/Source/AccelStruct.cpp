@@ -104,9 +104,60 @@ namespace DXR
     {
         DXR_ASSERT(desc.HasBeenAllocated(), "Acceleration structure has not been allocated");
 
-        // TODO: Retrieve the postbuild info from the acceleration structure
+        if (desc.vpCompactedSizeInfo == 0)
+        {
+            cmdList->BuildRaytracingAccelerationStructure(&desc.BuildDesc, 0, nullptr);
+            return;
+        }
+
+        DXR_ASSERT(desc.Flags & D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION,
+                   "Compacted size requested for an acceleration structure that doesn't allow compaction");
+
+        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC postbuildInfo = {};
+        postbuildInfo.DestBuffer = desc.vpCompactedSizeInfo;
+        postbuildInfo.InfoType = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+
+        cmdList->BuildRaytracingAccelerationStructure(&desc.BuildDesc, 1, &postbuildInfo);
+    }
+
+    ComPtr<DMA::Allocation> Device::AllocateAndAssignCompactedSizeBuffer(std::vector<AccelerationStructureDesc>& descs)
+    {
+        constexpr UINT64 infoSize = sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+
+        D3D12_RESOURCE_DESC resDesc =
+            CD3DX12_RESOURCE_DESC::Buffer(descs.size() * infoSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        auto sizeBuffer = AllocateResource(resDesc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+
+        D3D12_GPU_VIRTUAL_ADDRESS baseAddress = sizeBuffer->GetResource()->GetGPUVirtualAddress();
+
+        for (UINT64 i = 0; i < descs.size(); i++)
+            descs[i].vpCompactedSizeInfo = baseAddress + i * infoSize;
+
+        return sizeBuffer;
+    }
+
+    ComPtr<DMA::Allocation> Device::CompactAccelerationStructure(AccelerationStructureDesc& desc,
+                                                                 ComPtr<DMA::Allocation>& accel, UINT64 compactedSize,
+                                                                 ComPtr<ID3D12GraphicsCommandList4>& cmdList)
+    {
+        DXR_ASSERT(desc.HasBeenAllocated(), "Acceleration structure has not been allocated");
+        DXR_ASSERT(compactedSize > 0 && compactedSize <= accel->GetSize(), "Invalid compacted size");
+
+        D3D12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(
+            compactedSize,
+            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS | D3D12_RESOURCE_FLAG_RAYTRACING_ACCELERATION_STRUCTURE);
+
+        auto compacted = AllocateResource(resDesc, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE);
+
+        cmdList->CopyRaytracingAccelerationStructure(compacted->GetResource()->GetGPUVirtualAddress(),
+                                                     accel->GetResource()->GetGPUVirtualAddress(),
+                                                     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT);
+
+        desc.BuildDesc.DestAccelerationStructureData = compacted->GetResource()->GetGPUVirtualAddress();
 
-        cmdList->BuildRaytracingAccelerationStructure(&desc.BuildDesc, 0, nullptr);
+        // Swap, the caller keeps the original alive until the copy is done
+        accel.Swap(compacted);
+        return compacted;
     }
 
     void Device::AssignScratchBuffer(std::vector<AccelerationStructureDesc>& descs, ComPtr<DMA::Allocation>& alloc)
@@ -8,3 +8,8 @@ data = pd.read_csv(file)
 mean_frametime = data["FrameTime"].mean()
 print(f"Mean Frame Time: {mean_frametime} ms")
 print(f"Mean FPS: {((1/mean_frametime) * 1000)}")
+
+# GPU times of the passes, from timestamp queries
+for column in ["DispatchRaysTime", "CopyTime"]:
+    if column in data:
+        print(f"Mean {column}: {data[column].mean()} ms")
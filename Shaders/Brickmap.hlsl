@@ -0,0 +1,260 @@
+#include "Shaders/Common/Common.hlsl"
+
+// Every occupied 8x8x8 brick of a model is an AABB in its BLAS, isect walks the voxels of the brick to find the one
+// that is hit. Selected with shader_file = "Brickmap" in config.toml, the app then uploads the bricks of all models
+// into one pool instead of the voxel AABBs.
+
+static const uint ColorBufferIndex = 3;
+static const uint BrickPoolIndex = 4;
+static const uint BrickColorPoolIndex = 5;
+
+static const uint BrickSize = 8;
+
+struct VoxMaterial
+{
+    uint Color;
+    float Emission;
+};
+
+// Reported by isect, the normal is in object space
+struct VoxelHit
+{
+    float3 Normal;
+    uint ColorIndex;
+};
+
+VoxMaterial GetColor(uint index)
+{
+    StructuredBuffer<VoxMaterial> buf = ResourceDescriptorHeap[ColorBufferIndex];
+    return buf[index];
+}
+
+float max_component(float3 v)
+{
+    return max(max(v.x, v.y), v.z);
+}
+
+float min_component(float3 v)
+{
+    return min(min(v.x, v.y), v.z);
+}
+
+uint min_axis(float3 v)
+{
+    return v.x < v.y ? (v.x < v.z ? 0 : 2) : (v.y < v.z ? 1 : 2);
+}
+
+uint max_axis(float3 v)
+{
+    return v.x > v.y ? (v.x > v.z ? 0 : 2) : (v.y > v.z ? 1 : 2);
+}
+
+// Distances where the ray enters and leaves [0, size] on every axis. An axis the ray is parallel to holds it from 0 up
+// to but excluding size, its distances are infinite instead of 0 * inf when the origin lies on a face.
+void clip_slabs(float3 origin, float3 dir, float3 invDir, float3 size, out float3 tLow, out float3 tHigh)
+{
+    const float3 t0 = -origin * invDir;
+    const float3 t1 = (size - origin) * invDir;
+    tLow = min(t0, t1);
+    tHigh = max(t0, t1);
+
+    [unroll]
+    for (uint axis = 0; axis < 3; axis++)
+    {
+        if (dir[axis] == 0.0)
+        {
+            const bool inside = origin[axis] >= 0.0 && origin[axis] < size[axis];
+            tLow[axis] = inside ? -1.#INF : 1.#INF;
+            tHigh[axis] = -tLow[axis];
+        }
+    }
+}
+
+// 8x8x8 voxels of a model, see Brick in Source/Core/Brickmap.h
+struct Brick
+{
+    // One 8x8 slice per z as the low and high 32 bits, bit x + y * 8 is set for filled voxels
+    uint2 Occupancy[BrickSize];
+    uint Position;
+    uint FirstColor;
+};
+
+bool IsFilled(Brick brick, int3 voxel)
+{
+    const uint bit = voxel.x + voxel.y * BrickSize;
+    const uint2 slice = brick.Occupancy[voxel.z];
+    return ((bit < 32 ? slice.x >> bit : slice.y >> (bit - 32)) & 1) != 0;
+}
+
+// The filled voxels before this one in bit order hold the colors in front of its own
+uint GetColorIndex(Brick brick, int3 voxel)
+{
+    uint rank = 0;
+    for (int z = 0; z < voxel.z; z++)
+        rank += countbits(brick.Occupancy[z].x) + countbits(brick.Occupancy[z].y);
+
+    const uint bit = voxel.x + voxel.y * BrickSize;
+    const uint2 slice = brick.Occupancy[voxel.z];
+    rank += bit < 32 ? countbits(slice.x & ((1u << bit) - 1))
+                     : countbits(slice.x) + countbits(slice.y & ((1u << (bit - 32)) - 1));
+
+    // One byte per color, four to a word
+    StructuredBuffer<uint> colors = ResourceDescriptorHeap[BrickColorPoolIndex];
+    const uint index = brick.FirstColor + rank;
+    return (colors[index / 4] >> (8 * (index % 4))) & 0xFF;
+}
+
+[shader("raygeneration")]
+void rgen()
+{
+    ConstantBuffer<SceneInfo> sceneInfo = ResourceDescriptorHeap[SceneConstantsIndex];
+    RWTexture2D<float4> outImage = ResourceDescriptorHeap[OutputBufferIndex];
+    RWTexture2D<float4> accumImage = ResourceDescriptorHeap[AccumulationBufferIndex];
+
+    const uint3 LaunchID = DispatchRaysIndex();
+    const uint3 LaunchSize = DispatchRaysDimensions();
+
+    uint seed = asuint(LaunchID.x) * asuint(LaunchID.y) * asuint(sceneInfo.otherInfo.y);
+    RayDesc rayDesc = ConstructRay(sceneInfo.View, sceneInfo.Proj, seed);
+
+    Payload p;
+    p.HitColor = 1;
+
+    for (uint i = 0; i < 4; i++)
+    {
+        TraceRay(rs, RAY_FLAG_FORCE_OPAQUE, 0xff, 0, 0, 0, rayDesc, p);
+        if (p.T < 0.0f)
+            break;
+
+        rayDesc.Origin = rayDesc.Origin + p.T * rayDesc.Direction;
+        rayDesc.Direction = normalize(p.RayDirection);
+    }
+
+    const int2 index = int2(LaunchID.xy);
+    float3 Radiance = p.HitColor * p.Emission;
+
+    if (any(isnan(Radiance)) || any(isinf(Radiance)))
+        Radiance = float3(0.0, 0.0, 0.0);
+
+    uint frameCount = asuint(sceneInfo.otherInfo.x);
+    float4 accum = accumImage[index];
+    accum.rgb = frameCount == 0 ? Radiance : accum.rgb + Radiance;
+
+    accumImage[index] = accum;
+    outImage[index] = accum / float(frameCount + 1);
+}
+
+[shader("intersection")]
+void isect()
+{
+    // The instance ID holds the index of the model's first brick in the pool
+    StructuredBuffer<Brick> bricks = ResourceDescriptorHeap[BrickPoolIndex];
+    const Brick brick = bricks[InstanceID() + PrimitiveIndex()];
+    const uint3 position = uint3(brick.Position, brick.Position >> 8, brick.Position >> 16) & 0xFF;
+
+    // Brick space, voxel v of the brick spans [v, v + 1]
+    const float3 origin = ObjectRayOrigin() + 0.5 - float3(position * BrickSize);
+    const float3 dir = ObjectRayDirection();
+    const float3 invDir = rcp(dir);
+
+    // Clip the ray to the brick
+    float3 tLow;
+    float3 tHigh;
+    clip_slabs(origin, dir, invDir, BrickSize, tLow, tHigh);
+
+    float t = max(max_component(tLow), RayTMin());
+    const float tExit = min(min_component(tHigh), RayTCurrent());
+    if (t > tExit)
+        return;
+
+    // The ray enters the brick through a face of this axis
+    uint axis = max_axis(tLow);
+
+    int3 voxel = clamp(int3(floor(origin + t * dir)), 0, int(BrickSize) - 1);
+    // invDir is never 0, so every axis steps, but the axes the ray is parallel to are never crossed
+    const int3 step = int3(sign(invDir));
+    const float3 tDelta = abs(invDir);
+    float3 tNext = (float3(voxel) + float3(step > 0) - origin) * invDir;
+    [unroll]
+    for (uint a = 0; a < 3; a++)
+    {
+        if (dir[a] == 0.0)
+            tNext[a] = 1.#INF;
+    }
+
+    // Amanatides and Woo on the occupancy bits, mirrors TraceBrick() in Source/Core/Brickmap.cpp
+    [loop]
+    while (true)
+    {
+        if (IsFilled(brick, voxel))
+        {
+            VoxelHit hit;
+            hit.Normal = 0.0;
+            hit.Normal[axis] = -step[axis];
+            hit.ColorIndex = GetColorIndex(brick, voxel);
+
+            ReportHit(t, 0, hit);
+            return;
+        }
+
+        // Step into the neighbour behind the closest boundary
+        axis = min_axis(tNext);
+        t = tNext[axis];
+        if (t > tExit)
+            return;
+
+        voxel[axis] += step[axis];
+        if (voxel[axis] < 0 || voxel[axis] >= int(BrickSize))
+            return;
+
+        tNext[axis] += tDelta[axis];
+    }
+}
+
+
+[shader("closesthit")]
+void chit(inout Payload p, in VoxelHit hit)
+{
+    ConstantBuffer<SceneInfo> sceneInfo = ResourceDescriptorHeap[SceneConstantsIndex];
+
+    const float SceneEmissiveIntensity = asfloat(sceneInfo.otherInfo.z);
+
+    const float3 normal = mul((float3x3) ObjectToWorld3x4(), hit.Normal);
+
+    float3 v = ObjectRayDirection();
+    float time = asfloat(sceneInfo.otherInfo.y);
+    uint seed = asint(time) * asint(v.x) * asint(v.y) * asint(v.z);
+
+    float2 rand = float2(NextRandomFloat(seed), NextRandomFloat(seed));
+
+    VoxMaterial m = GetColor(hit.ColorIndex);
+    float3 Color = float3((m.Color & 0xFF) / 255.0, ((m.Color >> 8) & 0xFF) / 255.0, ((m.Color >> 16) & 0xFF) / 255.0);
+    p.HitColor *= Color;
+    p.RayDirection = SampleCosineHemisphere(normal, rand);
+
+    // If there is emission, we don't need to trace further.
+    if (m.Emission > 0.0)
+    {
+        p.Emission = m.Emission * SceneEmissiveIntensity;
+        p.T = -1.0f;
+    }
+    else
+    {
+        // The walk reports the distance along the ray where it enters the voxel
+        p.Emission = 0.0;
+        p.T = RayTCurrent();
+    }
+}
+
+[shader("miss")]
+void miss(inout Payload p)
+{
+    ConstantBuffer<SceneInfo> sceneInfo = ResourceDescriptorHeap[SceneConstantsIndex];
+    const float SkyBrightness = asfloat(sceneInfo.otherInfo.w);
+
+    const float3 rayDir = normalize(WorldRayDirection());
+    const float t = 0.5f * (rayDir.y + 1.0f);
+    p.HitColor *= lerp(float3(1.0, 1.0, 1.0), float3(0.5, 0.7, 1.0), t);
+    p.Emission = SkyBrightness;
+    p.T = -1.0f;
+}
@@ -17,11 +17,49 @@ struct AABB
     uint Padding;
 };
 
+#if defined(COMPACT_VOXELS) || defined(UNIT_VOXELS)
+// 8 byte record on the model's voxel grid, see VoxPacked in Source/Core/Voxel.h, unit voxels only store the Position
+struct PackedVoxel
+{
+    uint Position;
+    uint Extent;
+};
+
+AABB UnpackVoxel(PackedVoxel packed)
+{
+    const uint3 position = uint3(packed.Position, packed.Position >> 8, packed.Position >> 16) & 0xFF;
+    const uint3 extent = uint3(packed.Extent, packed.Extent >> 8, packed.Extent >> 16) & 0xFF;
+    
+    AABB voxel;
+    voxel.Min = float3(position) - 0.5;
+    voxel.Max = float3(position + extent) + 0.5;
+    voxel.ColorIndex = packed.Position >> 24;
+    voxel.Padding = 0;
+    return voxel;
+}
+#endif
+
 AABB GetAABB()
 {
-    StructuredBuffer<AABB> buf = ResourceDescriptorHeap[NonUniformResourceIndex(AABBBufferIndexStart + InstanceID())];
+    // Instances of the same model share one AABB buffer, the instance ID holds the index of the model's buffer
+    const uint modelIndex = InstanceID();
+#if defined(UNIT_VOXELS)
+    // Unmerged voxels are unit cubes, only the position and color index are stored
+    StructuredBuffer<uint> buf = ResourceDescriptorHeap[NonUniformResourceIndex(AABBBufferIndexStart + modelIndex)];
+    
+    PackedVoxel packed;
+    packed.Position = buf[PrimitiveIndex()];
+    packed.Extent = 0;
+    return UnpackVoxel(packed);
+#elif defined(COMPACT_VOXELS)
+    StructuredBuffer<PackedVoxel> buf = ResourceDescriptorHeap[NonUniformResourceIndex(AABBBufferIndexStart + modelIndex)];
+    
+    return UnpackVoxel(buf[PrimitiveIndex()]);
+#else
+    StructuredBuffer<AABB> buf = ResourceDescriptorHeap[NonUniformResourceIndex(AABBBufferIndexStart + modelIndex)];
     
     return buf[PrimitiveIndex()];
+#endif
 }
 
 VoxMaterial GetColor(uint index)
@@ -57,7 +95,8 @@ float3 getNormal(in AABB voxel)
 {
     // Calculate the normal
     float3 voxelMid = (voxel.Max + voxel.Min) / 2.0;
-    float3 pc = (ObjectRayOrigin() + RayTCurrent() * ObjectRayDirection()) - voxelMid;
+    // Scale by the extent so merged boxes that aren't cubes pick the right face
+    float3 pc = ((ObjectRayOrigin() + RayTCurrent() * ObjectRayDirection()) - voxelMid) / (voxel.Max - voxel.Min);
     float3 normal = 0.0;
     
     
@@ -1,14 +1,21 @@
 #include "Common.h"
 #include "Application.h"
+#include "Core/SceneConstants.h"
+#include "Core/Profiler.h"
 
-Application::Application()
+Application::Application(bool headless, UINT32 framesInFlight) : mFrameContext(framesInFlight), mHeadless(headless)
 {
-    glfwInit(); // Initializes the GLFW library
+    const UINT32 numFrames = mFrameContext.GetNumFramesInFlight();
 
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    if (!mHeadless)
+    {
+        glfwInit(); // Initializes the GLFW library
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
-    mWindow = glfwCreateWindow(mWidth, mHeight, "FastVoxels", nullptr, nullptr); // Creates a window
+        mWindow = glfwCreateWindow(mWidth, mHeight, "FastVoxels", nullptr, nullptr); // Creates a window
+    }
 
     // Create Factory
     uint32_t dxgiFactoryFlags = 0;
@@ -90,30 +97,34 @@ Application::Application()
     THROW_IF_FAILED(mDXDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&mCommandQueue)));
 
     // Create Swap Chain
-    DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-    swapChainDesc.BufferCount = 2;
-    swapChainDesc.Width = 0;
-    swapChainDesc.Height = 0;
-    swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-    swapChainDesc.SampleDesc.Count = 1;
-    swapChainDesc.Flags = mTearingSupport ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+    if (!mHeadless)
+    {
+        DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+        swapChainDesc.BufferCount = numFrames;
+        swapChainDesc.Width = 0;
+        swapChainDesc.Height = 0;
+        swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+        swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+        swapChainDesc.SampleDesc.Count = 1;
+        swapChainDesc.Flags = mTearingSupport ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
 
-    ComPtr<IDXGISwapChain1> swapChain1 = nullptr;
+        ComPtr<IDXGISwapChain1> swapChain1 = nullptr;
 
-    HWND hwnd = glfwGetWin32Window(mWindow);
+        HWND hwnd = glfwGetWin32Window(mWindow);
 
-    THROW_IF_FAILED(
-        mFactory->CreateSwapChainForHwnd(mCommandQueue.Get(), hwnd, &swapChainDesc, nullptr, nullptr, &swapChain1));
-    THROW_IF_FAILED(mFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
+        THROW_IF_FAILED(mFactory->CreateSwapChainForHwnd(mCommandQueue.Get(), hwnd, &swapChainDesc, nullptr, nullptr,
+                                                         &swapChain1));
+        THROW_IF_FAILED(mFactory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
 
-    swapChain1.As(&mSwapchain);
+        swapChain1.As(&mSwapchain);
 
-    mBackBufferIndex = mSwapchain->GetCurrentBackBufferIndex();
+        mBackBufferIndex = mSwapchain->GetCurrentBackBufferIndex();
+    }
 
     // Create Command Allocators
-    for (UINT32 i = 0; i < 2; i++)
+    mCommandAllocators.resize(numFrames);
+    for (UINT32 i = 0; i < numFrames; i++)
     {
         THROW_IF_FAILED(
             mDXDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&mCommandAllocators[i])));
@@ -124,19 +135,23 @@ Application::Application()
                                                   IID_PPV_ARGS(&mCommandList)));
 
     // Create RTV Descriptor Heap
-    D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-    rtvHeapDesc.NumDescriptors = 2;
-    rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-    THROW_IF_FAILED(mDXDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&mRTVHeap)));
+    if (!mHeadless)
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
+        rtvHeapDesc.NumDescriptors = numFrames;
+        rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+        THROW_IF_FAILED(mDXDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&mRTVHeap)));
 
-    mRTVDescriptorSize = mDXDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        mRTVDescriptorSize = mDXDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRTVHeap->GetCPUDescriptorHandleForHeapStart());
-    for (UINT32 i = 0; i < 2; i++)
-    {
-        THROW_IF_FAILED(mSwapchain->GetBuffer(i, IID_PPV_ARGS(&mBackBuffers[i])));
-        mDXDevice->CreateRenderTargetView(mBackBuffers[i].Get(), nullptr, rtvHandle);
-        rtvHandle.Offset(1, mRTVDescriptorSize);
+        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRTVHeap->GetCPUDescriptorHandleForHeapStart());
+        mBackBuffers.resize(numFrames);
+        for (UINT32 i = 0; i < numFrames; i++)
+        {
+            THROW_IF_FAILED(mSwapchain->GetBuffer(i, IID_PPV_ARGS(&mBackBuffers[i])));
+            mDXDevice->CreateRenderTargetView(mBackBuffers[i].Get(), nullptr, rtvHandle);
+            rtvHandle.Offset(1, mRTVDescriptorSize);
+        }
     }
 
     // Create Fence
@@ -149,20 +164,15 @@ Application::Application()
 
     mDevice = std::make_unique<DXR::Device>(mDXDevice, mAdapter);
 
-    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, mWidth, mHeight, 1, 1, 1, 0,
-                                                              D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-    mOutputImage = mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_HEAP_TYPE_DEFAULT);
-    desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-    mAccumulationImage =
-        mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_HEAP_TYPE_DEFAULT);
-
-    desc = CD3DX12_RESOURCE_DESC::Buffer(1024, D3D12_RESOURCE_FLAG_NONE);
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(1024, D3D12_RESOURCE_FLAG_NONE);
 
     mConstantBuffer = mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_DEFAULT);
-    mStagingBuffers[0] = mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_UPLOAD);
-    mStagingBuffers[1] = mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_UPLOAD);
-    mStagingDatas[0] = (CHAR*)mDevice->MapAllocationForWrite(mStagingBuffers[0]);
-    mStagingDatas[1] = (CHAR*)mDevice->MapAllocationForWrite(mStagingBuffers[1]);
+    for (UINT32 i = 0; i < numFrames; i++)
+    {
+        mStagingBuffers.push_back(
+            mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_UPLOAD));
+        mStagingDatas.push_back((CHAR*)mDevice->MapAllocationForWrite(mStagingBuffers[i]));
+    }
 
     // Create Resource Heap
     D3D12_DESCRIPTOR_HEAP_DESC resourceHeapDesc = {};
@@ -181,6 +191,23 @@ Application::Application()
     cbvDesc.SizeInBytes = 1024;
     mDXDevice->CreateConstantBufferView(&cbvDesc, cpuHandle);
 
+    CreateOutputImages(mWidth, mHeight);
+}
+
+void Application::CreateOutputImages(UINT32 width, UINT32 height)
+{
+    mWidth = width;
+    mHeight = height;
+
+    // The previous images are released when they're replaced
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, mWidth, mHeight, 1, 1, 1, 0,
+                                                              D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    mOutputImage = mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_HEAP_TYPE_DEFAULT);
+    desc.Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+    mAccumulationImage =
+        mDevice->AllocateResource(desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_HEAP_TYPE_DEFAULT);
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mResourceHeap->GetCPUDescriptorHandleForHeapStart());
     cpuHandle.Offset(1, mResourceDescriptorSize);
 
     D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
@@ -198,29 +225,36 @@ Application::Application()
 
 void Application::BeginFrame()
 {
-    // Acquire the next image
-    mBackBufferIndex = mSwapchain->GetCurrentBackBufferIndex();
-
-    // Wait for the previous frame to finish
-    if (mFence->GetCompletedValue() < mFrameFenceValues[mBackBufferIndex])
+    // Acquire the next image, the frame slots take turns independent of the back buffers
+    if (mSwapchain)
+        mBackBufferIndex = mSwapchain->GetCurrentBackBufferIndex();
+    mFrameIndex = mFrameContext.BeginFrame(mFrameCount);
+
+    // Wait for the frame that last used the slot to finish
+    const UINT64 waitValue = mFrameContext.GetWaitValue();
+    if (mFence->GetCompletedValue() < waitValue)
     {
-        THROW_IF_FAILED(mFence->SetEventOnCompletion(mFrameFenceValues[mBackBufferIndex], mFenceEvent));
+        PROFILE_ZONE("WaitForFrame");
+        THROW_IF_FAILED(mFence->SetEventOnCompletion(waitValue, mFenceEvent));
         WaitForSingleObject(mFenceEvent, INFINITE);
     }
 
-    HandleIO();
+    {
+        PROFILE_ZONE("HandleIO");
+        HandleIO();
+    }
 
     DeltaTime = mFrameTimer.Endd();
     mFrameTimer.Start();
 
     // Reset the command allocator
-    THROW_IF_FAILED(mCommandAllocators[mBackBufferIndex]->Reset());
+    THROW_IF_FAILED(mCommandAllocators[mFrameIndex]->Reset());
 
     // Reset the command list
-    THROW_IF_FAILED(mCommandList->Reset(mCommandAllocators[mBackBufferIndex].Get(), nullptr));
+    THROW_IF_FAILED(mCommandList->Reset(mCommandAllocators[mFrameIndex].Get(), nullptr));
 
     // Copy the data to the constant buffer
-    mCommandList->CopyBufferRegion(mConstantBuffer->GetResource(), 0, mStagingBuffers[mBackBufferIndex]->GetResource(),
+    mCommandList->CopyBufferRegion(mConstantBuffer->GetResource(), 0, mStagingBuffers[mFrameIndex]->GetResource(),
                                    0, 1024);
 
     ID3D12DescriptorHeap* ppHeaps[] = {mResourceHeap.Get()};
@@ -229,6 +263,9 @@ void Application::BeginFrame()
 
 void Application::EndFrame()
 {
+    if (mWindow)
+        glfwPollEvents();
+
     mPassiveFrameCount++;
     mFrameCount++;
 
@@ -240,16 +277,49 @@ void Application::EndFrame()
     mCommandQueue->ExecuteCommandLists(1, ppCommandLists);
 
     // Present the image
-    THROW_IF_FAILED(mSwapchain->Present(0, mTearingSupport ? DXGI_PRESENT_ALLOW_TEARING : 0));
-
-    // Signal the fence
-    THROW_IF_FAILED(mCommandQueue->Signal(mFence.Get(), ++mFenceValue));
+    if (mSwapchain)
+    {
+        PROFILE_ZONE("Present");
+        THROW_IF_FAILED(mSwapchain->Present(0, mTearingSupport ? DXGI_PRESENT_ALLOW_TEARING : 0));
+    }
 
-    // Store the fence value to wait for
-    mFrameFenceValues[mBackBufferIndex] = mFenceValue;
+    // Signal the fence, the frame's slot waits for it before it's used again
+    THROW_IF_FAILED(mCommandQueue->Signal(mFence.Get(), mFrameContext.EndFrame()));
 }
 
 void Application::HandleIO()
+{
+    // A played camera path replaces the input, the camera moves every frame so nothing accumulates
+    if (mCameraPathMode == CameraPathMode::Play)
+    {
+        SampleCameraPath(mCameraPath, (float)mFrameCount, mCamera);
+        mPassiveFrameCount = 0;
+    }
+    else if (mWindow)
+    {
+        HandleInput();
+    }
+
+    if (mCameraPathMode == CameraPathMode::Record)
+        AddCameraKeyframe(mCameraPath, (float)mFrameCount, mCamera);
+
+    mCamera.AspectRatio = ((float)mWidth) / ((float)mHeight);
+
+    // Without a window or while a path plays every frame advances the time by the same step, so the images and the
+    // traced rays are reproducible
+    const bool fixedTime = !mWindow || mCameraPathMode == CameraPathMode::Play;
+    float time = fixedTime ? (mFrameCount + 1) / 60.0f : glfwGetTime();
+
+    // update the view matrix
+    SceneConstants constants =
+        MakeSceneConstants(mCamera, mPassiveFrameCount, time, mSceneLightIntensity, mSkyBrightness);
+
+    CHAR* data = mStagingDatas[mFrameIndex];
+
+    memcpy(data, &constants, sizeof(constants));
+}
+
+void Application::HandleInput()
 {
     glm::dvec2 lastMousePos = mMousePos;
 
@@ -316,60 +386,91 @@ void Application::HandleIO()
 
     mSceneLightIntensity = std::max(0.0f, mSceneLightIntensity);
     mSkyBrightness = std::max(0.0f, mSkyBrightness);
+}
 
-    glm::mat4 view = mCamera.GetViewMatrix();
-
-    mCamera.AspectRatio = ((float)mWidth) / ((float)mHeight);
-    glm::mat4 proj = mCamera.GetProjectionMatrix();
-
-    // Rotate the whole world
-    glm::mat4 rot = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    view = view * rot;
-
-    // update the view matrix
-    glm::mat4 mats[2] = {glm::inverse(view), glm::inverse(proj)};
+void Application::CleanUp()
+{
+    // Wait for the GPU to finish
+    const UINT64 fenceValue = mFrameContext.NextFenceValue();
+    mCommandQueue->Signal(mFence.Get(), fenceValue);
+    mFence->SetEventOnCompletion(fenceValue, mFenceEvent);
+    WaitForSingleObject(mFenceEvent, INFINITE);
+}
 
-    float time = glfwGetTime();
+bool Application::ShouldStop() const
+{
+    return mStopRequested || (mWindow && glfwWindowShouldClose(mWindow));
+}
 
-    uint32_t uniformExtraInfo[4];
-    uniformExtraInfo[0] = mPassiveFrameCount;
-    uniformExtraInfo[1] = *(uint32_t*)&time;                 // type punning
-    uniformExtraInfo[2] = *(uint32_t*)&mSceneLightIntensity; // type punning
-    uniformExtraInfo[3] = *(uint32_t*)&mSkyBrightness;       // type punning
+void Application::ExecuteAndWait()
+{
+    mCommandList->Close();
 
-    CHAR* data = mStagingDatas[mBackBufferIndex];
+    ID3D12CommandList* ppCommandLists[] = {mCommandList.Get()};
+    mCommandQueue->ExecuteCommandLists(1, ppCommandLists);
 
-    memcpy(data, mats, sizeof(mats));
-    memcpy(data + sizeof(mats), uniformExtraInfo, sizeof(uniformExtraInfo));
-}
+    const UINT64 fenceValue = mFrameContext.NextFenceValue();
+    mCommandQueue->Signal(mFence.Get(), fenceValue);
 
-void Application::CleanUp()
-{
-    // Wait for the GPU to finish
-    mCommandQueue->Signal(mFence.Get(), ++mFenceValue);
-    mFence->SetEventOnCompletion(mFenceValue, mFenceEvent);
+    // Wait for the command list to finish
+    mFence->SetEventOnCompletion(fenceValue, mFenceEvent);
     WaitForSingleObject(mFenceEvent, INFINITE);
 }
 
-void Application::Run()
+std::vector<uint8_t> Application::ReadbackImage(ID3D12Resource* image, UINT32 bytesPerPixel)
 {
-    Start();
+    // Texture rows are copied with their pitch aligned to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    const D3D12_RESOURCE_DESC imageDesc = image->GetDesc();
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    UINT64 readbackSize = 0;
+    mDXDevice->GetCopyableFootprints(&imageDesc, 0, 1, 0, &footprint, nullptr, nullptr, &readbackSize);
 
-    while (!glfwWindowShouldClose(mWindow))
-    {
-        BeginFrame();
-        Update();
-        glfwPollEvents();
-        EndFrame();
-    }
+    auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(readbackSize);
+    auto readback = mDevice->AllocateResource(readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_READBACK);
+
+    THROW_IF_FAILED(mCommandAllocators[mFrameIndex]->Reset());
+    THROW_IF_FAILED(mCommandList->Reset(mCommandAllocators[mFrameIndex].Get(), nullptr));
+
+    auto barrier = CD3DX12_RESOURCE_BARRIER::Transition(image, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                                        D3D12_RESOURCE_STATE_COPY_SOURCE);
+    mCommandList->ResourceBarrier(1, &barrier);
+
+    CD3DX12_TEXTURE_COPY_LOCATION destination(readback->GetResource(), footprint);
+    CD3DX12_TEXTURE_COPY_LOCATION source(image, 0);
+    mCommandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
 
-    CleanUp();
+    barrier = CD3DX12_RESOURCE_BARRIER::Transition(image, D3D12_RESOURCE_STATE_COPY_SOURCE,
+                                                   D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    mCommandList->ResourceBarrier(1, &barrier);
 
-    Stop();
+    ExecuteAndWait();
+
+    const UINT64 rowSize = (UINT64)mWidth * bytesPerPixel;
+    std::vector<uint8_t> pixels(rowSize * mHeight);
+
+    const D3D12_RANGE readRange = {0, readbackSize};
+    uint8_t* data = nullptr;
+    THROW_IF_FAILED(readback->GetResource()->Map(0, &readRange, (void**)&data));
+
+    for (UINT32 y = 0; y < mHeight; y++)
+        memcpy(pixels.data() + y * rowSize, data + footprint.Offset + y * footprint.Footprint.RowPitch, rowSize);
+
+    const D3D12_RANGE writeRange = {0, 0};
+    readback->GetResource()->Unmap(0, &writeRange);
+
+    return pixels;
+}
+
+void Application::Run()
+{
+    RunFrameLoop(*this);
 }
 
 Application::~Application()
 {
-    glfwDestroyWindow(mWindow);
-    glfwTerminate();
+    if (mWindow)
+    {
+        glfwDestroyWindow(mWindow);
+        glfwTerminate();
+    }
 }
@@ -1,32 +1,61 @@
 #pragma once
 #include <GLFW/glfw3.h>
 #include "SimpleTimer.h"
-#include "Camera.h"
+#include "Core/Camera.h"
+#include "Core/CameraPath.h"
+#include "Core/FrameContext.h"
+#include "Core/FrameLoop.h"
 
-class Application
+// What the camera path of the scene is used for
+enum class CameraPathMode
+{
+    None,
+    // The camera follows the path, the input is ignored
+    Play,
+    // The camera is moved with the input and appended to the path every frame
+    Record,
+};
+
+class Application : public FrameLoop
 {
 public:
-    Application();
+    // Headless applications render without a window or swapchain into the output image alone, until the sample
+    // requests to stop. The CPU records up to framesInFlight frames ahead of the GPU, between 2 and 4.
+    Application(bool headless = false, UINT32 framesInFlight = FrameContext::MinFramesInFlight);
     virtual ~Application();
 
-    // Functions to be overriden by the samples
-    virtual void Start() {};
+    // Start, Update and Stop are overriden by the samples
+    virtual void BeginFrame() override;
 
-    virtual void Update() {};
+    virtual void EndFrame() override;
 
-    virtual void Stop() {};
+    virtual void CleanUp() override;
 
-    virtual void BeginFrame();
-
-    virtual void EndFrame();
+    virtual bool ShouldStop() const override;
 
     void HandleIO();
 
-    void CleanUp();
-
     void Run();
 
 private:
+    // Moves the camera and changes the lighting with the mouse and keyboard
+    void HandleInput();
+
+protected:
+    // Ends the frame loop after the current frame
+    void RequestStop() { mStopRequested = true; }
+
+    // Closes the command list, executes it and waits for the GPU to finish it
+    void ExecuteAndWait();
+
+    // Copies a texture of the output size that is in the UNORDERED_ACCESS state to a readback buffer, executes the
+    // copy and waits for it. Returns the rows tightly packed, top row first. The command list must be closed.
+    std::vector<uint8_t> ReadbackImage(ID3D12Resource* image, UINT32 bytesPerPixel);
+
+    // Allocates the output and accumulation images at the given size and points descriptors 1 and 2 at them. Changing
+    // the size is only possible when headless, the back buffers keep the window's size. The GPU must be idle.
+    void CreateOutputImages(UINT32 width, UINT32 height);
+
 protected:
     ComPtr<IDXGIFactory7> mFactory = nullptr;
     ComPtr<IDXGIAdapter4> mAdapter = nullptr;
@@ -34,17 +63,18 @@ protected:
 
     ComPtr<ID3D12Device7> mDXDevice = nullptr;
     ComPtr<ID3D12CommandQueue> mCommandQueue = nullptr;
-    ComPtr<ID3D12CommandAllocator> mCommandAllocators[2] = {0};
+    // One per frame in flight
+    std::vector<ComPtr<ID3D12CommandAllocator>> mCommandAllocators;
     ComPtr<ID3D12GraphicsCommandList4> mCommandList = nullptr;
 
     ComPtr<ID3D12DescriptorHeap> mRTVHeap = nullptr;
     ComPtr<ID3D12DescriptorHeap> mResourceHeap = nullptr;
     ComPtr<ID3D12Fence> mFence = nullptr;
-    ComPtr<ID3D12Resource> mBackBuffers[2] = {0};
-
-    UINT64 mFenceValue = 0;
+    // One per frame in flight, none when headless
+    std::vector<ComPtr<ID3D12Resource>> mBackBuffers;
 
-    UINT64 mFrameFenceValues[2] = {0};
+    // The slot of the frame and the fence values every slot and submission waits for
+    FrameContext mFrameContext;
 
     HANDLE mFenceEvent = nullptr;
 
@@ -52,6 +82,8 @@ protected:
 
     UINT32 mTearingSupport = 0;
     UINT32 mBackBufferIndex = 0;
+    // Slot of the current frame, indexes the command allocators and the staging buffers
+    UINT32 mFrameIndex = 0;
     UINT32 mRTVDescriptorSize = 0;
     UINT32 mResourceDescriptorSize = 0;
 
@@ -65,15 +97,21 @@ protected:
     ComPtr<DMA::Allocation> mOutputImage;
     ComPtr<DMA::Allocation> mAccumulationImage;
     ComPtr<DMA::Allocation> mConstantBuffer;
-    ComPtr<DMA::Allocation> mStagingBuffers[2] = {0};
-    CHAR* mStagingDatas[2] = {0};
+    // The scene constants of every frame in flight, copied to the constant buffer at the start of the frame
+    std::vector<ComPtr<DMA::Allocation>> mStagingBuffers;
+    std::vector<CHAR*> mStagingDatas;
 
+    // Null when headless
     GLFWwindow* mWindow = nullptr;
+    bool mHeadless = false;
+    bool mStopRequested = false;
 
     UINT32 mWidth = 1980;
     UINT32 mHeight = 1080;
 
     Camera mCamera;
+    CameraPath mCameraPath;
+    CameraPathMode mCameraPathMode = CameraPathMode::None;
     float mSceneLightIntensity = 1.0f;
     float mSkyBrightness = 1.0f;
 
@@ -1,6 +1,3 @@
 #include "Common.h"
 
-#define OGT_VOX_IMPLEMENTATION
-#include "ogt_vox.h"
-
 DXRAY_AGILITY_SDK_IMPLEMENTATION;
@@ -29,4 +29,4 @@ using namespace Microsoft::WRL;
 
 #include "SimpleTimer.h"
 #include "FileRead.h"
-#include "Camera.h"
+#include "Core/Camera.h"
@@ -0,0 +1,160 @@
+#include "Core/BenchmarkStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    std::string EscapeJson(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // JSON has no NaN or infinity
+    double FiniteOrZero(double value)
+    {
+        return std::isfinite(value) ? value : 0.0;
+    }
+} // namespace
+
+double GetPercentile(std::span<const double> sortedSamples, double p)
+{
+    if (sortedSamples.empty())
+        return 0.0;
+
+    const double rank = std::clamp(p, 0.0, 100.0) / 100.0 * (double)(sortedSamples.size() - 1);
+    const uint64_t lower = (uint64_t)rank;
+    const uint64_t upper = std::min<uint64_t>(lower + 1, sortedSamples.size() - 1);
+    return sortedSamples[lower] + (sortedSamples[upper] - sortedSamples[lower]) * (rank - (double)lower);
+}
+
+SampleStats ComputeSampleStats(std::span<const double> samples, uint64_t numWarmup)
+{
+    SampleStats stats;
+    stats.NumWarmup = std::min<uint64_t>(numWarmup, samples.size());
+
+    std::vector<double> sorted(samples.begin() + stats.NumWarmup, samples.end());
+    stats.Count = sorted.size();
+    if (sorted.empty())
+        return stats;
+
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (double sample : sorted)
+        sum += sample;
+    stats.Mean = sum / (double)stats.Count;
+
+    double squares = 0.0;
+    for (double sample : sorted)
+        squares += (sample - stats.Mean) * (sample - stats.Mean);
+    stats.StdDev = stats.Count > 1 ? std::sqrt(squares / (double)(stats.Count - 1)) : 0.0;
+
+    stats.Min = sorted.front();
+    stats.Max = sorted.back();
+    stats.Median = GetPercentile(sorted, 50.0);
+    stats.P1 = GetPercentile(sorted, 1.0);
+    stats.P5 = GetPercentile(sorted, 5.0);
+    stats.P95 = GetPercentile(sorted, 95.0);
+    stats.P99 = GetPercentile(sorted, 99.0);
+
+    const double q1 = GetPercentile(sorted, 25.0);
+    const double q3 = GetPercentile(sorted, 75.0);
+    const double low = q1 - 1.5 * (q3 - q1);
+    const double high = q3 + 1.5 * (q3 - q1);
+
+    double inlierSum = 0.0;
+    for (double sample : sorted)
+    {
+        if (sample < low || sample > high)
+            stats.NumOutliers++;
+        else
+            inlierSum += sample;
+    }
+
+    // The median is always inside the fences, so there is at least one inlier
+    stats.MeanWithoutOutliers = inlierSum / (double)(stats.Count - stats.NumOutliers);
+
+    return stats;
+}
+
+void PrintSampleStats(std::ostream& out, const std::string& name, const SampleStats& stats)
+{
+    // Leave the stream formatted like it was
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+
+    out << std::fixed << std::setprecision(3) << name << ": mean " << stats.Mean << ", median " << stats.Median
+        << ", p1 " << stats.P1 << ", p5 " << stats.P5 << ", p95 " << stats.P95 << ", p99 " << stats.P99
+        << ", stddev " << stats.StdDev << ", " << stats.NumOutliers << " outliers in " << stats.Count << " samples"
+        << std::endl;
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool WriteBenchmarkJson(const std::string& filePath, const BenchmarkReport& report)
+{
+    std::ofstream file(filePath);
+    if (!file.is_open())
+        return false;
+
+    file << "{" << std::endl;
+
+    std::vector<std::string> members;
+    for (auto& [name, value] : report.Properties)
+    {
+        std::ostringstream member;
+        member << "\"" << EscapeJson(name) << "\": \"" << EscapeJson(value) << "\"";
+        members.push_back(member.str());
+    }
+
+    for (auto& [name, value] : report.Values)
+    {
+        std::ostringstream member;
+        member << std::setprecision(17) << "\"" << EscapeJson(name) << "\": " << FiniteOrZero(value);
+        members.push_back(member.str());
+    }
+
+    for (auto& [name, stats] : report.Stats)
+    {
+        const std::pair<const char*, double> fields[] = {
+            {"count", (double)stats.Count},
+            {"warmup", (double)stats.NumWarmup},
+            {"mean", stats.Mean},
+            {"stddev", stats.StdDev},
+            {"min", stats.Min},
+            {"max", stats.Max},
+            {"median", stats.Median},
+            {"p1", stats.P1},
+            {"p5", stats.P5},
+            {"p95", stats.P95},
+            {"p99", stats.P99},
+            {"outliers", (double)stats.NumOutliers},
+            {"mean_without_outliers", stats.MeanWithoutOutliers},
+        };
+
+        std::ostringstream member;
+        member << std::setprecision(17) << "\"" << EscapeJson(name) << "\": {";
+        for (uint32_t i = 0; i < std::size(fields); i++)
+            member << (i ? ", " : "") << "\"" << fields[i].first << "\": " << FiniteOrZero(fields[i].second);
+        member << "}";
+        members.push_back(member.str());
+    }
+
+    for (uint64_t i = 0; i < members.size(); i++)
+        file << "    " << members[i] << (i + 1 < members.size() ? "," : "") << std::endl;
+
+    file << "}" << std::endl;
+    return file.good();
+}
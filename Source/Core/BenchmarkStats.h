@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Summary of the per frame samples of one metric, e.g. the frame time in ms
+struct SampleStats
+{
+    // Samples after the warmup
+    uint64_t Count = 0;
+    // Samples skipped at the start while caches and clocks settle
+    uint64_t NumWarmup = 0;
+
+    double Mean = 0.0;
+    double StdDev = 0.0;
+    double Min = 0.0;
+    double Max = 0.0;
+
+    double Median = 0.0;
+    double P1 = 0.0;
+    double P5 = 0.0;
+    double P95 = 0.0;
+    double P99 = 0.0;
+
+    // Samples outside of the Tukey fences, more than 1.5 interquartile ranges below the first or above the third
+    // quartile, and the mean without them
+    uint64_t NumOutliers = 0;
+    double MeanWithoutOutliers = 0.0;
+};
+
+// Percentile p in [0, 100] of sorted samples, linearly interpolated between the two closest ranks
+double GetPercentile(std::span<const double> sortedSamples, double p);
+
+// Everything but the outlier count is over all samples after the first numWarmup ones
+SampleStats ComputeSampleStats(std::span<const double> samples, uint64_t numWarmup);
+
+// One line: mean, median, percentiles, stddev and outliers
+void PrintSampleStats(std::ostream& out, const std::string& name, const SampleStats& stats);
+
+// Machine readable summary of a benchmark run, to diff runs against each other
+struct BenchmarkReport
+{
+    // e.g. the scene and the shader
+    std::vector<std::pair<std::string, std::string>> Properties;
+    // e.g. the voxel count, memory and build times
+    std::vector<std::pair<std::string, double>> Values;
+    std::vector<std::pair<std::string, SampleStats>> Stats;
+};
+
+// Writes the report as one JSON object: the properties and values as members, every stats entry as an object
+bool WriteBenchmarkJson(const std::string& filePath, const BenchmarkReport& report);
@@ -0,0 +1,96 @@
+#include "Core/Brickmap.h"
+
+#include <bit>
+
+Brickmap BuildBrickmap(const VoxelGrid& grid)
+{
+    Brickmap brickmap;
+
+    const glm::uvec3 numBricks = (grid.Size + BrickSize - 1u) / BrickSize;
+
+    for (uint32_t bz = 0; bz < numBricks.z; bz++)
+    {
+        for (uint32_t by = 0; by < numBricks.y; by++)
+        {
+            for (uint32_t bx = 0; bx < numBricks.x; bx++)
+            {
+                const glm::uvec3 first = glm::uvec3(bx, by, bz) * BrickSize;
+                const glm::uvec3 last = glm::min(first + BrickSize, grid.Size);
+
+                Brick brick = {};
+                brick.Position = bx | by << 8 | bz << 16;
+                brick.FirstColor = (uint32_t)brickmap.Colors.size();
+
+                glm::uvec3 filledMin = last;
+                glm::uvec3 filledMax = first;
+
+                // Bit order, so the colors end up in the order the shaders count them in
+                for (uint32_t z = first.z; z < last.z; z++)
+                {
+                    for (uint32_t y = first.y; y < last.y; y++)
+                    {
+                        for (uint32_t x = first.x; x < last.x; x++)
+                        {
+                            const uint32_t colorIndex = grid.GetColorIndex({x, y, z});
+                            if (colorIndex == 0)
+                                continue;
+
+                            brick.Occupancy[z - first.z] |= 1ull << ((x - first.x) + (y - first.y) * BrickSize);
+                            brickmap.Colors.push_back((uint8_t)colorIndex);
+
+                            filledMin = glm::min(filledMin, glm::uvec3(x, y, z));
+                            filledMax = glm::max(filledMax, glm::uvec3(x, y, z) + 1u);
+                        }
+                    }
+                }
+
+                if (brickmap.Colors.size() == brick.FirstColor)
+                    continue;
+
+                brickmap.Bricks.push_back(brick);
+                brickmap.Bounds.push_back(VoxAABB {
+                    .Min = glm::vec3(filledMin) - 0.5f,
+                    .Max = glm::vec3(filledMax) - 0.5f,
+                    .ColorIndex = 0,
+                    .Padding = 0,
+                });
+            }
+        }
+    }
+
+    return brickmap;
+}
+
+bool TraceBrick(const Brick& brick, std::span<const uint8_t> colors, const glm::vec3& origin,
+                const glm::vec3& direction, float tMin, float tMax, VoxelGridHit& outHit)
+{
+    const glm::uvec3 position = glm::uvec3(brick.Position, brick.Position >> 8, brick.Position >> 16) & 0xFFu;
+    const glm::uvec3 offset = position * BrickSize;
+
+    // The filled voxels before this one in bit order hold the colors in front of its own
+    auto getColorIndex = [&](const glm::uvec3& voxel) -> uint32_t {
+        const uint32_t bit = voxel.x + voxel.y * BrickSize;
+        const uint64_t slice = brick.Occupancy[voxel.z];
+        if (!(slice & (1ull << bit)))
+            return 0;
+
+        uint32_t rank = std::popcount(slice & ((1ull << bit) - 1));
+        for (uint32_t z = 0; z < voxel.z; z++)
+            rank += std::popcount(brick.Occupancy[z]);
+
+        return colors[brick.FirstColor + rank];
+    };
+
+    // Brick space, voxel v of the brick spans [v, v + 1]
+    if (!WalkVoxels(glm::uvec3(BrickSize), origin + 0.5f - glm::vec3(offset), direction, tMin, tMax, getColorIndex,
+                    outHit))
+        return false;
+
+    outHit.Voxel += offset;
+    return true;
+}
+
+uint64_t GetBrickmapMemorySize(const Brickmap& brickmap)
+{
+    return brickmap.Bricks.size() * sizeof(Brick) + brickmap.Colors.size();
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Core/VoxelGrid.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+constexpr uint32_t BrickSize = 8;
+
+// 8x8x8 voxels of a model. The layout is mirrored in Shaders/Brickmap.hlsl, keep them in sync.
+struct Brick
+{
+    // One 8x8 slice per z, bit x + y * 8 is set for filled voxels
+    uint64_t Occupancy[BrickSize];
+    // Brick coordinates in the model, x | y << 8 | z << 16
+    uint32_t Position;
+    // The color indices of the filled voxels follow each other from here in the color pool, in bit order
+    uint32_t FirstColor;
+};
+
+static_assert(sizeof(Brick) == 72, "The shaders read bricks with a stride of 72 bytes");
+
+// The occupied bricks of one model
+struct Brickmap
+{
+    std::vector<Brick> Bricks;
+    // Model space bounds of the filled voxels of every brick, the BLAS primitives
+    std::vector<VoxAABB> Bounds;
+    // Color index of every filled voxel, one byte each
+    std::vector<uint8_t> Colors;
+};
+
+// Splits the grid into bricks and keeps the ones with filled voxels
+Brickmap BuildBrickmap(const VoxelGrid& grid);
+
+// WalkVoxels inside one brick with the ray in model space, mirrors isect() in Shaders/Brickmap.hlsl.
+// colors is the color pool the brick's FirstColor points into.
+bool TraceBrick(const Brick& brick, std::span<const uint8_t> colors, const glm::vec3& origin,
+                const glm::vec3& direction, float tMin, float tMax, VoxelGridHit& outHit);
+
+// Bytes of the bricks and colors the shaders read, the bounds only feed the BLAS build
+uint64_t GetBrickmapMemorySize(const Brickmap& brickmap);
@@ -0,0 +1,544 @@
+#include "Core/Bvh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    constexpr uint32_t MaxBins = 64;
+
+    // Deeper nodes are split at the object median, which halves them, so no build gets deeper than MaxBvhDepth
+    constexpr uint32_t MaxSAHDepth = MaxBvhDepth - 32;
+
+    // Primitives binned per chunk when a large node is binned in parallel
+    constexpr uint64_t BinningGrain = 1 << 14;
+
+    // Nodes below this size are always built by one task, splitting them further isn't worth a task each
+    constexpr uint64_t MinTaskSize = 1 << 12;
+
+    struct Bounds
+    {
+        glm::vec3 Min = glm::vec3(INFINITY);
+        glm::vec3 Max = glm::vec3(-INFINITY);
+
+        void Grow(const glm::vec3& point)
+        {
+            Min = glm::min(Min, point);
+            Max = glm::max(Max, point);
+        }
+
+        void Grow(const Bounds& other)
+        {
+            Min = glm::min(Min, other.Min);
+            Max = glm::max(Max, other.Max);
+        }
+
+        // Half the surface area is enough for the ratios the SAH needs
+        float HalfArea() const
+        {
+            if (Min.x > Max.x)
+                return 0.0f;
+
+            glm::vec3 extent = Max - Min;
+            return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+        }
+    };
+
+    struct Bin
+    {
+        Bounds Box;
+        Bounds Centroids;
+        uint32_t Count = 0;
+    };
+
+    struct Binning
+    {
+        Bin Bins[3][MaxBins];
+
+        void Reset(uint32_t numBins)
+        {
+            for (auto& axisBins : Bins)
+                std::fill(axisBins, axisBins + numBins, Bin{});
+        }
+    };
+
+    // Copy of a box that is partitioned along with the node ranges, so binning reads the boxes of a node
+    // sequentially instead of gathering them from all over the input
+    struct BuildRef
+    {
+        glm::vec3 Min;
+        uint32_t Index;
+        glm::vec3 Max;
+
+        glm::vec3 Centroid() const { return (Min + Max) * 0.5f; }
+    };
+
+    // A node whose bounds are set and which still has to be split or made a leaf
+    struct BuildJob
+    {
+        uint32_t Node;
+        uint32_t Begin;
+        uint32_t End;
+        uint32_t Depth;
+        Bounds Centroids;
+    };
+
+    class BvhBuilder
+    {
+    public:
+        BvhBuilder(std::span<const VoxAABB> aabbs, const BvhBuildSettings& settings, Bvh& outBvh)
+            : mAABBs(aabbs), mSettings(settings), mBvh(outBvh)
+        {
+            mSettings.NumBins = std::clamp(mSettings.NumBins, 2u, MaxBins);
+            mSettings.MaxLeafSize = std::max(mSettings.MaxLeafSize, 1u);
+        }
+
+        // Sets up the root, false if there are no boxes. Must not be called from a task.
+        bool InitRoot(ThreadPool& pool, BuildJob& outJob)
+        {
+            const uint32_t count = (uint32_t)mAABBs.size();
+            if (count == 0)
+                return false;
+
+            // A binary tree with at least one primitive per leaf has at most 2n - 1 nodes
+            mBvh.Nodes.resize(2 * (uint64_t)count - 1);
+            mRefs.resize(count);
+
+            Bounds box, centroids;
+            std::mutex mutex;
+
+            pool.ParallelFor(count, BinningGrain, [&](uint64_t begin, uint64_t end) {
+                Bounds localBox, localCentroids;
+                for (uint64_t i = begin; i < end; i++)
+                {
+                    mRefs[i] = {mAABBs[i].Min, (uint32_t)i, mAABBs[i].Max};
+
+                    localBox.Grow(mRefs[i].Min);
+                    localBox.Grow(mRefs[i].Max);
+                    localCentroids.Grow(mRefs[i].Centroid());
+                }
+
+                std::lock_guard lock(mutex);
+                box.Grow(localBox);
+                centroids.Grow(localCentroids);
+            });
+
+            SetNode(0, box);
+            mNumNodes = 1;
+            outJob = {0, 0, count, 0, centroids};
+            return true;
+        }
+
+        // Turns the job's node into a leaf or splits it, returning the two children to build next.
+        // With a pool the primitives are binned in parallel, which must not happen inside a task.
+        // The binning is scratch space, reused by the caller between nodes.
+        bool Split(const BuildJob& job, ThreadPool* pool, Binning& binning, BuildJob& outLeft, BuildJob& outRight)
+        {
+            BvhNode& node = mBvh.Nodes[job.Node];
+            const uint32_t count = job.End - job.Begin;
+
+            if (count == 1)
+                return MakeLeaf(node, job);
+
+            // Small nodes don't need more bins than they have primitives, most nodes are near the leaves
+            const uint32_t numBins = std::min(mSettings.NumBins, count);
+
+            const glm::vec3 extent = job.Centroids.Max - job.Centroids.Min;
+            glm::vec3 scale;
+            for (uint32_t axis = 0; axis < 3; axis++)
+                scale[axis] = extent[axis] > 0.0f ? numBins / extent[axis] : 0.0f;
+
+            auto binIndex = [&](const glm::vec3& centroid, uint32_t axis) {
+                return std::min(numBins - 1, (uint32_t)((centroid[axis] - job.Centroids.Min[axis]) * scale[axis]));
+            };
+
+            // Best split over all three axes, the boxes left of bin split go to the left child
+            uint32_t bestAxis = 0;
+            uint32_t bestSplit = 0;
+            float bestCost = INFINITY;
+
+            if (job.Depth < MaxSAHDepth)
+            {
+                binning.Reset(numBins);
+
+                if (pool != nullptr && count > BinningGrain)
+                {
+                    std::mutex mutex;
+                    pool->ParallelFor(count, BinningGrain, [&](uint64_t begin, uint64_t end) {
+                        auto local = std::make_unique<Binning>();
+                        local->Reset(numBins);
+                        BinPrimitives(job.Begin + (uint32_t)begin, job.Begin + (uint32_t)end, scale, binIndex, *local);
+
+                        std::lock_guard lock(mutex);
+                        for (uint32_t axis = 0; axis < 3; axis++)
+                        {
+                            for (uint32_t i = 0; i < numBins; i++)
+                            {
+                                Bin& bin = binning.Bins[axis][i];
+                                bin.Box.Grow(local->Bins[axis][i].Box);
+                                bin.Centroids.Grow(local->Bins[axis][i].Centroids);
+                                bin.Count += local->Bins[axis][i].Count;
+                            }
+                        }
+                    });
+                }
+                else
+                {
+                    BinPrimitives(job.Begin, job.End, scale, binIndex, binning);
+                }
+
+                const float nodeArea = std::max(Bounds{node.Min, node.Max}.HalfArea(), 1e-12f);
+
+                for (uint32_t axis = 0; axis < 3; axis++)
+                {
+                    if (scale[axis] == 0.0f)
+                        continue;
+
+                    const Bin* bins = binning.Bins[axis];
+
+                    // Sweep from the right to get the cost of every right side, then from the left to finish it
+                    float rightCost[MaxBins];
+                    Bounds right;
+                    uint32_t rightCount = 0;
+                    for (uint32_t i = numBins - 1; i > 0; i--)
+                    {
+                        right.Grow(bins[i].Box);
+                        rightCount += bins[i].Count;
+                        rightCost[i] = rightCount > 0 ? right.HalfArea() * rightCount : INFINITY;
+                    }
+
+                    Bounds left;
+                    uint32_t leftCount = 0;
+                    for (uint32_t i = 1; i < numBins; i++)
+                    {
+                        left.Grow(bins[i - 1].Box);
+                        leftCount += bins[i - 1].Count;
+                        if (leftCount == 0)
+                            continue;
+
+                        const float cost = mSettings.TraversalCost + mSettings.IntersectionCost *
+                                                                         (left.HalfArea() * leftCount + rightCost[i]) /
+                                                                         nodeArea;
+                        if (cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = i;
+                        }
+                    }
+                }
+            }
+
+            if (count <= mSettings.MaxLeafSize && mSettings.IntersectionCost * count <= bestCost)
+                return MakeLeaf(node, job);
+
+            const uint32_t first = mNumNodes.fetch_add(2);
+            node.First = first;
+            node.Count = 0;
+
+            BuildRef* refs = mRefs.data();
+            uint32_t mid;
+            Bounds leftBox, rightBox, leftCentroids, rightCentroids;
+
+            if (bestCost < INFINITY)
+            {
+                BuildRef* midIt = std::partition(refs + job.Begin, refs + job.End, [&](const BuildRef& ref) {
+                    return binIndex(ref.Centroid(), bestAxis) < bestSplit;
+                });
+                mid = (uint32_t)(midIt - refs);
+
+                for (uint32_t i = 0; i < numBins; i++)
+                {
+                    const Bin& bin = binning.Bins[bestAxis][i];
+                    (i < bestSplit ? leftBox : rightBox).Grow(bin.Box);
+                    (i < bestSplit ? leftCentroids : rightCentroids).Grow(bin.Centroids);
+                }
+            }
+            else
+            {
+                // Every centroid is in the same spot or the node is too deep, split at the median on the widest axis
+                uint32_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+                mid = job.Begin + count / 2;
+                std::nth_element(refs + job.Begin, refs + mid, refs + job.End,
+                                 [&](const BuildRef& a, const BuildRef& b) {
+                                     return a.Centroid()[axis] < b.Centroid()[axis];
+                                 });
+
+                ComputeBounds(job.Begin, mid, leftBox, leftCentroids);
+                ComputeBounds(mid, job.End, rightBox, rightCentroids);
+            }
+
+            SetNode(first, leftBox);
+            SetNode(first + 1, rightBox);
+            outLeft = {first, job.Begin, mid, job.Depth + 1, leftCentroids};
+            outRight = {first + 1, mid, job.End, job.Depth + 1, rightCentroids};
+            return true;
+        }
+
+        // Builds the whole subtree of the job on the calling thread
+        void BuildSubtree(const BuildJob& root)
+        {
+            auto binning = std::make_unique<Binning>();
+
+            std::vector<BuildJob> stack = {root};
+            while (!stack.empty())
+            {
+                BuildJob job = stack.back();
+                stack.pop_back();
+
+                BuildJob left, right;
+                if (Split(job, nullptr, *binning, left, right))
+                {
+                    stack.push_back(right);
+                    stack.push_back(left);
+                }
+            }
+        }
+
+        // Trims the nodes once every job is done
+        void Finish()
+        {
+            mBvh.Nodes.resize(mNumNodes);
+            mBvh.Nodes.shrink_to_fit();
+
+            mBvh.PrimitiveIndices.resize(mRefs.size());
+            for (uint64_t i = 0; i < mRefs.size(); i++)
+                mBvh.PrimitiveIndices[i] = mRefs[i].Index;
+
+            mRefs.clear();
+            mRefs.shrink_to_fit();
+        }
+
+    private:
+        template <typename BinIndexFn>
+        void BinPrimitives(uint32_t begin, uint32_t end, const glm::vec3& scale, const BinIndexFn& binIndex,
+                           Binning& binning) const
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const BuildRef& ref = mRefs[i];
+                const glm::vec3 centroid = ref.Centroid();
+
+                for (uint32_t axis = 0; axis < 3; axis++)
+                {
+                    if (scale[axis] == 0.0f)
+                        continue;
+
+                    Bin& bin = binning.Bins[axis][binIndex(centroid, axis)];
+                    bin.Box.Grow(ref.Min);
+                    bin.Box.Grow(ref.Max);
+                    bin.Centroids.Grow(centroid);
+                    bin.Count++;
+                }
+            }
+        }
+
+        void ComputeBounds(uint32_t begin, uint32_t end, Bounds& outBox, Bounds& outCentroids) const
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const BuildRef& ref = mRefs[i];
+                outBox.Grow(ref.Min);
+                outBox.Grow(ref.Max);
+                outCentroids.Grow(ref.Centroid());
+            }
+        }
+
+        void SetNode(uint32_t index, const Bounds& box)
+        {
+            mBvh.Nodes[index].Min = box.Min;
+            mBvh.Nodes[index].Max = box.Max;
+        }
+
+        bool MakeLeaf(BvhNode& node, const BuildJob& job)
+        {
+            node.First = job.Begin;
+            node.Count = job.End - job.Begin;
+            return false;
+        }
+
+    private:
+        std::span<const VoxAABB> mAABBs;
+        BvhBuildSettings mSettings;
+        Bvh& mBvh;
+
+        std::vector<BuildRef> mRefs;
+        std::atomic<uint32_t> mNumNodes = 0;
+    };
+} // namespace
+
+std::vector<Bvh> BuildBvhs(std::span<const std::span<const VoxAABB>> sets, const BvhBuildSettings& settings,
+                           ThreadPool& pool)
+{
+    std::vector<Bvh> bvhs(sets.size());
+    std::vector<std::unique_ptr<BvhBuilder>> builders;
+    builders.reserve(sets.size());
+
+    uint64_t totalCount = 0;
+    for (auto& set : sets)
+        totalCount += set.size();
+
+    // Enough tasks per thread that large and small subtrees still balance out
+    const uint64_t taskThreshold = std::min<uint64_t>(
+        settings.ParallelThreshold, std::max(MinTaskSize, totalCount / ((uint64_t)pool.GetThreadCount() * 4)));
+
+    using Job = std::pair<BvhBuilder*, BuildJob>;
+    std::vector<Job> largeJobs;
+    std::vector<Job> tasks;
+
+    auto addJob = [&](BvhBuilder* builder, const BuildJob& job) {
+        (job.End - job.Begin > taskThreshold ? largeJobs : tasks).emplace_back(builder, job);
+    };
+
+    for (uint64_t i = 0; i < sets.size(); i++)
+    {
+        BvhBuilder* builder = builders.emplace_back(std::make_unique<BvhBuilder>(sets[i], settings, bvhs[i])).get();
+
+        BuildJob root;
+        if (builder->InitRoot(pool, root))
+            addJob(builder, root);
+    }
+
+    // The top of large trees is split here with parallel binning until the nodes are small enough to be tasks
+    auto binning = std::make_unique<Binning>();
+    while (!largeJobs.empty())
+    {
+        auto [builder, job] = largeJobs.back();
+        largeJobs.pop_back();
+
+        BuildJob left, right;
+        if (builder->Split(job, &pool, *binning, left, right))
+        {
+            addJob(builder, left);
+            addJob(builder, right);
+        }
+    }
+
+    for (auto& [builder, job] : tasks)
+        pool.Submit([builder, job]() { builder->BuildSubtree(job); });
+
+    pool.Wait();
+
+    for (auto& builder : builders)
+        builder->Finish();
+
+    return bvhs;
+}
+
+Bvh BuildBvh(std::span<const VoxAABB> aabbs, const BvhBuildSettings& settings, ThreadPool& pool)
+{
+    return std::move(BuildBvhs({&aabbs, 1}, settings, pool)[0]);
+}
+
+BvhStats GetBvhStats(const Bvh& bvh, const BvhBuildSettings& settings)
+{
+    BvhStats stats;
+    stats.NumNodes = bvh.Nodes.size();
+    stats.MemorySize = bvh.Nodes.size() * sizeof(BvhNode) + bvh.PrimitiveIndices.size() * sizeof(uint32_t);
+
+    if (bvh.Nodes.empty())
+        return stats;
+
+    const float rootArea = std::max(Bounds{bvh.Nodes[0].Min, bvh.Nodes[0].Max}.HalfArea(), 1e-12f);
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 1}};
+    while (!stack.empty())
+    {
+        auto [index, depth] = stack.back();
+        stack.pop_back();
+
+        const BvhNode& node = bvh.Nodes[index];
+        const float area = Bounds{node.Min, node.Max}.HalfArea() / rootArea;
+        stats.MaxDepth = std::max(stats.MaxDepth, depth);
+
+        if (node.IsLeaf())
+        {
+            stats.NumLeaves++;
+            stats.SAHCost += settings.IntersectionCost * node.Count * area;
+        }
+        else
+        {
+            stats.SAHCost += settings.TraversalCost * area;
+            stack.push_back({node.First, depth + 1});
+            stack.push_back({node.First + 1, depth + 1});
+        }
+    }
+
+    return stats;
+}
+
+SceneBvh BuildSceneBvh(const VoxelSceneView& scene, const BvhBuildSettings& settings, ThreadPool& pool)
+{
+    SceneBvh sceneBvh;
+
+    std::vector<std::span<const VoxAABB>> sets;
+    sets.reserve(scene.Models.size());
+    for (auto& model : scene.Models)
+        sets.push_back(model.AABBs);
+
+    sceneBvh.Models = BuildBvhs(sets, settings, pool);
+
+    // World space bounds of the instances, built like the TLAS from the instance descs
+    std::vector<VoxAABB> instanceBounds;
+    std::vector<uint32_t> instanceIndices;
+
+    sceneBvh.Instances.reserve(scene.Instances.size());
+    for (uint32_t i = 0; i < scene.Instances.size(); i++)
+    {
+        const VoxelInstance& instance = scene.Instances[i];
+
+        // The transform holds the rows of the 3x4 matrix
+        glm::mat4 objectToWorld = glm::transpose(glm::mat4(instance.Transform));
+        sceneBvh.Instances.push_back({objectToWorld, glm::inverse(objectToWorld), instance.ModelIndex});
+
+        const Bvh& model = sceneBvh.Models[instance.ModelIndex];
+        if (model.Nodes.empty())
+            continue;
+
+        Bounds world;
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            glm::vec3 p((corner & 1) ? model.Nodes[0].Max.x : model.Nodes[0].Min.x,
+                        (corner & 2) ? model.Nodes[0].Max.y : model.Nodes[0].Min.y,
+                        (corner & 4) ? model.Nodes[0].Max.z : model.Nodes[0].Min.z);
+            world.Grow(glm::vec3(objectToWorld * glm::vec4(p, 1.0f)));
+        }
+
+        instanceBounds.push_back({world.Min, world.Max, 0, 0});
+        instanceIndices.push_back(i);
+    }
+
+    sceneBvh.Top = BuildBvh(instanceBounds, settings, pool);
+
+    for (auto& index : sceneBvh.Top.PrimitiveIndices)
+        index = instanceIndices[index];
+
+    return sceneBvh;
+}
+
+BvhStats GetModelBvhStats(const SceneBvh& bvh, const BvhBuildSettings& settings)
+{
+    BvhStats total;
+    uint64_t totalPrimitives = 0;
+
+    for (auto& model : bvh.Models)
+    {
+        BvhStats stats = GetBvhStats(model, settings);
+        const uint64_t numPrimitives = model.PrimitiveIndices.size();
+
+        total.NumNodes += stats.NumNodes;
+        total.NumLeaves += stats.NumLeaves;
+        total.MaxDepth = std::max(total.MaxDepth, stats.MaxDepth);
+        total.MemorySize += stats.MemorySize;
+        total.SAHCost += stats.SAHCost * numPrimitives;
+        totalPrimitives += numPrimitives;
+    }
+
+    if (totalPrimitives > 0)
+        total.SAHCost /= totalPrimitives;
+
+    return total;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Core/ThreadPool.h"
+#include "Core/Voxel.h"
+#include "Core/VoxelExtract.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Builds never go deeper than this, traversal stacks of this size can't overflow
+constexpr uint32_t MaxBvhDepth = 96;
+
+// Node of a binary BVH, 32 bytes. Inner nodes have a count of 0 and their children at First and First + 1,
+// leaves reference Count primitives starting at First in the BVH's primitive order.
+struct BvhNode
+{
+    glm::vec3 Min;
+    uint32_t First;
+    glm::vec3 Max;
+    uint32_t Count;
+
+    bool IsLeaf() const { return Count != 0; }
+};
+
+struct BvhBuildSettings
+{
+    // Split candidates per axis, at most 64
+    uint32_t NumBins = 16;
+    uint32_t MaxLeafSize = 4;
+
+    // Nodes with more primitives are split on the calling thread with parallel binning, smaller ones are built as a
+    // whole by one task. The build lowers it further so there are enough tasks for every thread.
+    uint64_t ParallelThreshold = 1 << 18;
+
+    // Relative costs of visiting a node and testing a primitive for the surface area heuristic
+    float TraversalCost = 1.0f;
+    float IntersectionCost = 1.0f;
+};
+
+// Binary BVH over a set of boxes, the CPU equivalent of a BLAS. The root is node 0, an empty set has no nodes.
+struct Bvh
+{
+    std::vector<BvhNode> Nodes;
+    // Index into the input boxes of every primitive in leaf order
+    std::vector<uint32_t> PrimitiveIndices;
+};
+
+struct BvhStats
+{
+    uint64_t NumNodes = 0;
+    uint64_t NumLeaves = 0;
+    uint32_t MaxDepth = 0;
+    // Expected cost of a random ray that hits the root, relative to testing one primitive
+    float SAHCost = 0.0f;
+    uint64_t MemorySize = 0;
+};
+
+// Builds one BVH per set of boxes with binned SAH. The sets share the pool, so many small models build in parallel
+// just like a few large ones.
+std::vector<Bvh> BuildBvhs(std::span<const std::span<const VoxAABB>> sets, const BvhBuildSettings& settings,
+                           ThreadPool& pool);
+
+Bvh BuildBvh(std::span<const VoxAABB> aabbs, const BvhBuildSettings& settings, ThreadPool& pool);
+
+BvhStats GetBvhStats(const Bvh& bvh, const BvhBuildSettings& settings);
+
+// Two level BVH with the layout of the acceleration structures the app builds: one BVH per model like the BLASes and
+// one over the world space bounds of the instances like the TLAS.
+struct SceneBvh
+{
+    // The transforms of D3D12_RAYTRACING_INSTANCE_DESC
+    struct Instance
+    {
+        glm::mat4 ObjectToWorld;
+        glm::mat4 WorldToObject;
+        uint32_t ModelIndex;
+    };
+
+    std::vector<Bvh> Models;
+    std::vector<Instance> Instances;
+
+    // The primitive indices of the top level are instance indices. Instances of empty models aren't in it.
+    Bvh Top;
+};
+
+// The boxes stay in the scene, the BVH only references them by index
+SceneBvh BuildSceneBvh(const VoxelSceneView& scene, const BvhBuildSettings& settings, ThreadPool& pool);
+
+// Sum of the stats of the models, the SAH cost is the average over the models weighted by their box count
+BvhStats GetModelBvhStats(const SceneBvh& bvh, const BvhBuildSettings& settings);
@@ -0,0 +1,232 @@
+#include "Core/Bvh8.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <deque>
+
+namespace
+{
+    constexpr uint32_t GridSteps = 255;
+    // Smallest exponent that still gives a normal float step
+    constexpr int32_t MinExponent = -126;
+
+    // 2^exponent, built from the bits so decoding stays cheap
+    float GetGridStep(int8_t exponent)
+    {
+        return std::bit_cast<float>((uint32_t)(exponent + 127) << 23);
+    }
+
+    // Smallest power of two step whose last grid line from min reaches max
+    int8_t GetGridExponent(float min, float max)
+    {
+        int32_t exponent = MinExponent;
+        if (max > min)
+        {
+            std::frexp((max - min) / GridSteps, &exponent);
+            exponent = std::max(exponent - 1, MinExponent);
+        }
+
+        while (min + GridSteps * GetGridStep((int8_t)exponent) < max)
+            exponent++;
+
+        return (int8_t)exponent;
+    }
+
+    uint8_t QuantizeDown(float value, float min, float scale)
+    {
+        if (scale == 0.0f)
+            return 0;
+
+        return (uint8_t)std::clamp(std::floor((value - min) / scale), 0.0f, (float)GridSteps);
+    }
+
+    uint8_t QuantizeUp(float value, float min, float scale)
+    {
+        if (scale == 0.0f)
+            return 0;
+
+        return (uint8_t)std::clamp(std::ceil((value - min) / scale), 0.0f, (float)GridSteps);
+    }
+
+    float HalfArea(const BvhNode& node)
+    {
+        glm::vec3 extent = node.Max - node.Min;
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+
+    // A wide node that still has to be filled from its binary counterpart
+    struct PendingNode
+    {
+        uint32_t BinaryNode;
+        uint32_t WideNode;
+        // Decoded bounds of the node, its children are quantized on a grid from Min that reaches Max
+        glm::vec3 Min;
+        glm::vec3 Max;
+    };
+} // namespace
+
+void DecodeBvh8Children(const Bvh8Node& node, const glm::vec3& nodeMin, AABBPacket8& outChildren)
+{
+    const glm::vec3 scale(GetGridStep(node.Exponent[0]), GetGridStep(node.Exponent[1]), GetGridStep(node.Exponent[2]));
+
+    // No branches, so the compiler can vectorize it
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        outChildren.MinX[i] = nodeMin.x + node.MinX[i] * scale.x;
+        outChildren.MinY[i] = nodeMin.y + node.MinY[i] * scale.y;
+        outChildren.MinZ[i] = nodeMin.z + node.MinZ[i] * scale.z;
+        outChildren.MaxX[i] = nodeMin.x + node.MaxX[i] * scale.x;
+        outChildren.MaxY[i] = nodeMin.y + node.MaxY[i] * scale.y;
+        outChildren.MaxZ[i] = nodeMin.z + node.MaxZ[i] * scale.z;
+    }
+}
+
+Bvh8 CollapseBvh8(const Bvh& bvh)
+{
+    Bvh8 wide;
+    if (bvh.Nodes.empty())
+        return wide;
+
+    wide.RootMin = bvh.Nodes[0].Min;
+    wide.RootMax = bvh.Nodes[0].Max;
+    wide.PrimitiveIndices.reserve(bvh.PrimitiveIndices.size());
+    wide.Nodes.emplace_back();
+
+    // Breadth first, so the inner children of a node can be allocated next to each other
+    std::deque<PendingNode> queue = {{0, 0, wide.RootMin, wide.RootMax}};
+
+    while (!queue.empty())
+    {
+        const PendingNode pending = queue.front();
+        queue.pop_front();
+
+        // A leaf can only get here as the root, it becomes the root's only child
+        uint32_t children[8];
+        uint32_t numChildren = 0;
+
+        const BvhNode& binaryNode = bvh.Nodes[pending.BinaryNode];
+        if (binaryNode.IsLeaf())
+        {
+            children[numChildren++] = pending.BinaryNode;
+        }
+        else
+        {
+            children[numChildren++] = binaryNode.First;
+            children[numChildren++] = binaryNode.First + 1;
+        }
+
+        while (numChildren < 8)
+        {
+            int32_t largest = -1;
+            float largestArea = -1.0f;
+
+            for (uint32_t i = 0; i < numChildren; i++)
+            {
+                const BvhNode& child = bvh.Nodes[children[i]];
+                if (!child.IsLeaf() && HalfArea(child) > largestArea)
+                {
+                    largest = (int32_t)i;
+                    largestArea = HalfArea(child);
+                }
+            }
+
+            if (largest < 0)
+                break;
+
+            const BvhNode& opened = bvh.Nodes[children[largest]];
+            children[largest] = opened.First;
+            children[numChildren++] = opened.First + 1;
+        }
+
+        Bvh8Node node = {};
+        node.FirstChild = (uint32_t)wide.Nodes.size();
+        node.FirstPrimitive = (uint32_t)wide.PrimitiveIndices.size();
+
+        glm::vec3 scale;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            node.Exponent[axis] = GetGridExponent(pending.Min[axis], pending.Max[axis]);
+            scale[axis] = GetGridStep(node.Exponent[axis]);
+        }
+
+        for (uint32_t i = 0; i < numChildren; i++)
+        {
+            const BvhNode& child = bvh.Nodes[children[i]];
+
+            if (child.IsLeaf())
+            {
+                assert(child.Count <= MaxBvh8LeafSize && "Bvh8 leaves can't hold more than 15 primitives");
+                node.PrimitiveCounts |= child.Count << (4 * i);
+                wide.PrimitiveIndices.insert(wide.PrimitiveIndices.end(),
+                                             bvh.PrimitiveIndices.begin() + child.First,
+                                             bvh.PrimitiveIndices.begin() + child.First + child.Count);
+            }
+            else
+            {
+                node.InnerMask |= 1u << i;
+            }
+
+            node.MinX[i] = QuantizeDown(child.Min.x, pending.Min.x, scale.x);
+            node.MinY[i] = QuantizeDown(child.Min.y, pending.Min.y, scale.y);
+            node.MinZ[i] = QuantizeDown(child.Min.z, pending.Min.z, scale.z);
+            node.MaxX[i] = QuantizeUp(child.Max.x, pending.Min.x, scale.x);
+            node.MaxY[i] = QuantizeUp(child.Max.y, pending.Min.y, scale.y);
+            node.MaxZ[i] = QuantizeUp(child.Max.z, pending.Min.z, scale.z);
+        }
+
+        // Rounding can put a decoded plane just inside the child, widen those by a step until the bounds hold.
+        // The grid reaches from the node's min to past its max, so this always ends.
+        AABBPacket8 decoded;
+        while (true)
+        {
+            DecodeBvh8Children(node, pending.Min, decoded);
+
+            bool widened = false;
+            for (uint32_t i = 0; i < numChildren; i++)
+            {
+                const BvhNode& child = bvh.Nodes[children[i]];
+
+                auto widen = [&](uint8_t& step, bool outside, int32_t direction) {
+                    if (outside)
+                    {
+                        step = (uint8_t)(step + direction);
+                        widened = true;
+                    }
+                };
+
+                widen(node.MinX[i], decoded.MinX[i] > child.Min.x, -1);
+                widen(node.MinY[i], decoded.MinY[i] > child.Min.y, -1);
+                widen(node.MinZ[i], decoded.MinZ[i] > child.Min.z, -1);
+                widen(node.MaxX[i], decoded.MaxX[i] < child.Max.x, 1);
+                widen(node.MaxY[i], decoded.MaxY[i] < child.Max.y, 1);
+                widen(node.MaxZ[i], decoded.MaxZ[i] < child.Max.z, 1);
+            }
+
+            if (!widened)
+                break;
+        }
+
+        wide.Nodes[pending.WideNode] = node;
+        wide.Nodes.resize(wide.Nodes.size() + std::popcount(node.InnerMask));
+
+        // The children see the decoded bounds as their own, exactly like the traversal will
+        uint32_t nextChild = node.FirstChild;
+        for (uint32_t i = 0; i < numChildren; i++)
+        {
+            if (!(node.InnerMask & (1u << i)))
+                continue;
+
+            queue.push_back({children[i], nextChild++, glm::vec3(decoded.MinX[i], decoded.MinY[i], decoded.MinZ[i]),
+                             glm::vec3(decoded.MaxX[i], decoded.MaxY[i], decoded.MaxZ[i])});
+        }
+    }
+
+    return wide;
+}
+
+uint64_t GetBvh8MemorySize(const Bvh8& bvh)
+{
+    return bvh.Nodes.size() * sizeof(Bvh8Node) + bvh.PrimitiveIndices.size() * sizeof(uint32_t);
+}
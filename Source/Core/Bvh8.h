@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Core/Bvh.h"
+#include "Core/SlabKernel.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Entries a Bvh8 traversal stack needs at most, every level pushes up to 8 children and pops one
+constexpr uint32_t MaxBvh8StackSize = 7 * MaxBvhDepth + 1;
+
+// Primitives a leaf child can hold, its count has 4 bits in Bvh8Node::PrimitiveCounts
+constexpr uint32_t MaxBvh8LeafSize = 15;
+
+// Node of an 8-wide BVH in one cache line. The child bounds are stored as 8 bit steps on a grid per axis that starts
+// at the node's own min corner, which comes from the grid of its parent in turn. The steps are powers of two, so
+// decoding needs neither a division nor the node's max corner. Only the root's bounds are stored in full, see
+// DecodeBvh8Children.
+struct alignas(64) Bvh8Node
+{
+    uint8_t MinX[8];
+    uint8_t MinY[8];
+    uint8_t MinZ[8];
+    uint8_t MaxX[8];
+    uint8_t MaxY[8];
+    uint8_t MaxZ[8];
+
+    // The inner children follow each other from here, in child order
+    uint32_t FirstChild;
+    // So do the primitives of the leaf children
+    uint32_t FirstPrimitive;
+    // Primitive count of every leaf child, 4 bits each starting with child 0 in the lowest bits
+    uint32_t PrimitiveCounts;
+
+    // Bit i is set if child i is an inner node
+    uint8_t InnerMask;
+    // The grid step per axis is 2^Exponent
+    int8_t Exponent[3];
+
+    uint32_t GetPrimitiveCount(uint32_t child) const { return (PrimitiveCounts >> (4 * child)) & 0xF; }
+
+    // Bit i is set if child i exists, leaves always have primitives
+    uint32_t GetChildMask() const
+    {
+        uint32_t leaves = (PrimitiveCounts | PrimitiveCounts >> 1 | PrimitiveCounts >> 2 | PrimitiveCounts >> 3) &
+                          0x11111111;
+        leaves = (leaves | leaves >> 3) & 0x03030303;
+        leaves = (leaves | leaves >> 6) & 0x000F000F;
+        leaves = (leaves | leaves >> 12) & 0xFF;
+        return leaves | InnerMask;
+    }
+};
+
+static_assert(sizeof(Bvh8Node) == 64, "A Bvh8Node must fill exactly one cache line");
+
+struct Bvh8
+{
+    glm::vec3 RootMin = glm::vec3(0.0f);
+    glm::vec3 RootMax = glm::vec3(0.0f);
+
+    // The root is node 0, an empty BVH has no nodes
+    std::vector<Bvh8Node> Nodes;
+    // Index into the input boxes of every primitive in leaf order
+    std::vector<uint32_t> PrimitiveIndices;
+};
+
+// Collapses a binary BVH into an 8-wide one. Every node takes the children of its binary counterpart and keeps
+// replacing the inner child with the largest surface area by its two children until it has 8.
+// The leaves of the binary BVH become leaf children as they are, build it with a MaxLeafSize of at most
+// MaxBvh8LeafSize.
+Bvh8 CollapseBvh8(const Bvh& bvh);
+
+// Conservative bounds of the children of a node with the given min corner, as a packet for the slab kernels.
+// Unused child slots decode to the node's min corner, mask the kernel's result with GetChildMask().
+// The build decodes with this too, so the corners a traversal passes down are bit for bit the ones the children were
+// quantized against.
+void DecodeBvh8Children(const Bvh8Node& node, const glm::vec3& nodeMin, AABBPacket8& outChildren);
+
+uint64_t GetBvh8MemorySize(const Bvh8& bvh);
@@ -1,4 +1,4 @@
-#include "Camera.h"
+#include "Core/Camera.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
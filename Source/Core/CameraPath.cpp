@@ -0,0 +1,89 @@
+#include "Core/CameraPath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+
+bool ReadCameraPath(const std::string& filePath, CameraPath& outPath)
+{
+    std::ifstream file(filePath);
+    if (!file.is_open())
+        return false;
+
+    outPath.Keyframes.clear();
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line[0] == '#' || line == "\r")
+            continue;
+
+        CameraKeyframe keyframe;
+        std::istringstream values(line);
+        values >> keyframe.Frame >> keyframe.Position.x >> keyframe.Position.y >> keyframe.Position.z >>
+            keyframe.Rotation.w >> keyframe.Rotation.x >> keyframe.Rotation.y >> keyframe.Rotation.z;
+        if (values.fail())
+            return false;
+
+        outPath.Keyframes.push_back(keyframe);
+    }
+
+    // Hand written paths don't have to be in order
+    std::stable_sort(outPath.Keyframes.begin(), outPath.Keyframes.end(),
+                     [](const CameraKeyframe& a, const CameraKeyframe& b) { return a.Frame < b.Frame; });
+    return true;
+}
+
+bool WriteCameraPath(const std::string& filePath, const CameraPath& path)
+{
+    std::ofstream file(filePath);
+    if (!file.is_open())
+        return false;
+
+    file << "# frame x y z qw qx qy qz" << std::endl;
+    file.precision(9);
+
+    for (auto& keyframe : path.Keyframes)
+    {
+        file << keyframe.Frame << " " << keyframe.Position.x << " " << keyframe.Position.y << " "
+             << keyframe.Position.z << " " << keyframe.Rotation.w << " " << keyframe.Rotation.x << " "
+             << keyframe.Rotation.y << " " << keyframe.Rotation.z << std::endl;
+    }
+
+    return file.good();
+}
+
+void AddCameraKeyframe(CameraPath& path, float frame, const Camera& camera)
+{
+    assert((path.Keyframes.empty() || path.Keyframes.back().Frame < frame) && "Keyframes must be added in order");
+    path.Keyframes.push_back({frame, camera.Position, camera.Rotation});
+}
+
+void SampleCameraPath(const CameraPath& path, float frame, Camera& camera)
+{
+    if (path.Keyframes.empty())
+        return;
+
+    // First keyframe after the frame
+    auto next = std::upper_bound(path.Keyframes.begin(), path.Keyframes.end(), frame,
+                                 [](float f, const CameraKeyframe& keyframe) { return f < keyframe.Frame; });
+
+    if (next == path.Keyframes.begin() || next == path.Keyframes.end())
+    {
+        const CameraKeyframe& keyframe = next == path.Keyframes.begin() ? *next : path.Keyframes.back();
+        camera.Position = keyframe.Position;
+        camera.Rotation = keyframe.Rotation;
+    }
+    else
+    {
+        const CameraKeyframe& a = *(next - 1);
+        const CameraKeyframe& b = *next;
+        const float t = (frame - a.Frame) / (b.Frame - a.Frame);
+
+        camera.Position = glm::mix(a.Position, b.Position, t);
+        camera.Rotation = glm::normalize(glm::slerp(a.Rotation, b.Rotation, t));
+    }
+
+    camera.UpdateDirections();
+}
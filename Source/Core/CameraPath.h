@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Core/Camera.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <string>
+#include <vector>
+
+// Camera pose at a frame of a camera path
+struct CameraKeyframe
+{
+    float Frame;
+    glm::vec3 Position;
+    glm::quat Rotation;
+};
+
+// Keyframed camera flight, played back frame by frame so every run traces the same views no matter how fast the
+// frames are. Stored as text next to the scene, one keyframe per line: frame x y z qw qx qy qz.
+// Lines starting with # are comments.
+struct CameraPath
+{
+    // Sorted by frame
+    std::vector<CameraKeyframe> Keyframes;
+};
+
+// Returns false if the file can't be opened or a line can't be parsed
+bool ReadCameraPath(const std::string& filePath, CameraPath& outPath);
+
+bool WriteCameraPath(const std::string& filePath, const CameraPath& path);
+
+// Appends the camera's pose, the frame has to be after the last keyframe's
+void AddCameraKeyframe(CameraPath& path, float frame, const Camera& camera);
+
+// Moves the camera to the path's pose at the frame, interpolated between the keyframes around it. Before the first
+// and after the last keyframe the camera stays at it. An empty path leaves the camera as it is.
+void SampleCameraPath(const CameraPath& path, float frame, Camera& camera);
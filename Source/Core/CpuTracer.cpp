@@ -0,0 +1,517 @@
+#include "Core/CpuTracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t TileSize = 16;
+    constexpr uint32_t MaxBounces = 4;
+
+    constexpr float TwoPi = 6.283185307179586476925286766559f;
+    constexpr float SqrtOfOneThird = 0.57735026919f;
+
+    // Shaders/Common/Resources.hlsl
+    struct Payload
+    {
+        glm::vec3 HitColor;
+        glm::vec3 RayDirection;
+        float T;
+        float Emission;
+    };
+
+    // Shaders/Common/Random.hlsl
+    uint32_t Random(uint32_t state)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    float NextRandomFloat(uint32_t& seed)
+    {
+        seed = Random(seed);
+        return seed / (float)0xffffffff;
+    }
+
+    uint32_t AsUint(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float AsFloat(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    float MaxComponent(const glm::vec3& v)
+    {
+        return std::max(std::max(v.x, v.y), v.z);
+    }
+
+    float MinComponent(const glm::vec3& v)
+    {
+        return std::min(std::min(v.x, v.y), v.z);
+    }
+
+    // slabs() in Optimized.hlsl, the entry distance or -1 if the ray misses
+    float Slabs(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& rayOrigin, const glm::vec3& invRayDir)
+    {
+        glm::vec3 t0 = (p0 - rayOrigin) * invRayDir;
+        glm::vec3 t1 = (p1 - rayOrigin) * invRayDir;
+        glm::vec3 tmin = glm::min(t0, t1), tmax = glm::max(t0, t1);
+
+        float min = MaxComponent(tmin);
+        float max = MinComponent(tmax);
+
+        return min <= max ? min : -1.0f;
+    }
+
+    // What the traversal hardware does before calling isect, the ray segment overlaps the box
+    bool Overlaps(const glm::vec3& boxMin, const glm::vec3& boxMax, const glm::vec3& rayOrigin,
+                  const glm::vec3& invRayDir, float tMin, float tMax, float& outTNear)
+    {
+        glm::vec3 t0 = (boxMin - rayOrigin) * invRayDir;
+        glm::vec3 t1 = (boxMax - rayOrigin) * invRayDir;
+
+        outTNear = std::max(MaxComponent(glm::min(t0, t1)), tMin);
+        float tFar = std::min(MinComponent(glm::max(t0, t1)), tMax);
+
+        return outTNear <= tFar;
+    }
+
+    // Calls leafFn with every primitive in a leaf the ray segment overlaps, nearer children first.
+    // tMax is read again at every node, so hits the leaves report prune the rest of the walk.
+    template <typename LeafFn>
+    void TraverseBvh(const Bvh& bvh, const glm::vec3& origin, const glm::vec3& invDir, float tMin, const float& tMax,
+                     const LeafFn& leafFn)
+    {
+        struct StackEntry
+        {
+            uint32_t Node;
+            float TNear;
+        };
+
+        float tNear;
+        if (bvh.Nodes.empty() || !Overlaps(bvh.Nodes[0].Min, bvh.Nodes[0].Max, origin, invDir, tMin, tMax, tNear))
+            return;
+
+        StackEntry stack[MaxBvhDepth];
+        uint32_t stackSize = 0;
+        uint32_t index = 0;
+
+        while (true)
+        {
+            const BvhNode& node = bvh.Nodes[index];
+
+            if (node.IsLeaf())
+            {
+                for (uint32_t i = node.First; i < node.First + node.Count; i++)
+                    leafFn(bvh.PrimitiveIndices[i]);
+            }
+            else
+            {
+                const BvhNode& left = bvh.Nodes[node.First];
+                const BvhNode& right = bvh.Nodes[node.First + 1];
+
+                float tLeft, tRight;
+                const bool hitLeft = Overlaps(left.Min, left.Max, origin, invDir, tMin, tMax, tLeft);
+                const bool hitRight = Overlaps(right.Min, right.Max, origin, invDir, tMin, tMax, tRight);
+
+                if (hitLeft && hitRight)
+                {
+                    const bool leftFirst = tLeft <= tRight;
+                    stack[stackSize++] = {leftFirst ? node.First + 1 : node.First, leftFirst ? tRight : tLeft};
+                    index = leftFirst ? node.First : node.First + 1;
+                    continue;
+                }
+
+                if (hitLeft || hitRight)
+                {
+                    index = hitLeft ? node.First : node.First + 1;
+                    continue;
+                }
+            }
+
+            // Skip the nodes that start behind a hit found since they were pushed
+            do
+            {
+                if (stackSize == 0)
+                    return;
+                stackSize--;
+            } while (stack[stackSize].TNear > tMax);
+
+            index = stack[stackSize].Node;
+        }
+    }
+
+    // TraverseBvh for the 8-wide layout. All children of a node are tested at once with the SIMD slab kernel and
+    // pushed far to near, leaf children included, so the walk stays front to back.
+    template <typename LeafFn>
+    void TraverseBvh8(const Bvh8& bvh, const glm::vec3& origin, const glm::vec3& invDir, float tMin,
+                      const float& tMax, const LeafFn& leafFn)
+    {
+        // An inner node with its decoded min corner, or the primitives of a leaf child if Count isn't 0
+        struct StackEntry
+        {
+            uint32_t Index;
+            uint32_t Count;
+            float TNear;
+            glm::vec3 Min;
+        };
+
+        float tNear;
+        if (bvh.Nodes.empty() || !Overlaps(bvh.RootMin, bvh.RootMax, origin, invDir, tMin, tMax, tNear))
+            return;
+
+        StackEntry stack[MaxBvh8StackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = {0, 0, tNear, bvh.RootMin};
+
+        AABBPacket8 children;
+
+        while (stackSize > 0)
+        {
+            const StackEntry entry = stack[--stackSize];
+
+            // Skip what starts behind a hit found since it was pushed
+            if (entry.TNear > tMax)
+                continue;
+
+            if (entry.Count != 0)
+            {
+                for (uint32_t i = entry.Index; i < entry.Index + entry.Count; i++)
+                    leafFn(bvh.PrimitiveIndices[i]);
+                continue;
+            }
+
+            const Bvh8Node& node = bvh.Nodes[entry.Index];
+            DecodeBvh8Children(node, entry.Min, children);
+
+            float childTNear[8];
+            const uint32_t mask =
+                IntersectSlabs8({origin, invDir, tMin, tMax}, children, childTNear) & node.GetChildMask();
+            if (mask == 0)
+                continue;
+
+            // Hit children sorted far to near
+            uint32_t order[8];
+            uint32_t numHits = 0;
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                if (!(mask & (1u << i)))
+                    continue;
+
+                uint32_t j = numHits++;
+                for (; j > 0 && childTNear[order[j - 1]] < childTNear[i]; j--)
+                    order[j] = order[j - 1];
+                order[j] = i;
+            }
+
+            for (uint32_t h = 0; h < numHits; h++)
+            {
+                const uint32_t i = order[h];
+                const uint32_t before = (1u << i) - 1;
+
+                if (node.InnerMask & (1u << i))
+                {
+                    const uint32_t child = node.FirstChild + std::popcount(node.InnerMask & before);
+                    stack[stackSize++] = {child, 0, childTNear[i],
+                                          glm::vec3(children.MinX[i], children.MinY[i], children.MinZ[i])};
+                }
+                else
+                {
+                    // The leaf children before this one hold the primitives in front of its own
+                    uint32_t first = node.FirstPrimitive;
+                    for (uint32_t c = 0; c < i; c++)
+                        first += node.GetPrimitiveCount(c);
+
+                    stack[stackSize++] = {first, node.GetPrimitiveCount(i), childTNear[i], glm::vec3(0.0f)};
+                }
+            }
+        }
+    }
+
+    glm::vec3 GetNormal(const glm::vec3& pc)
+    {
+        glm::vec3 normal(0.0f);
+
+        if (std::abs(pc.x) > std::abs(pc.y) && std::abs(pc.x) > std::abs(pc.z))
+            normal.x = glm::sign(pc).x;
+        else if (std::abs(pc.y) > std::abs(pc.z))
+            normal.y = glm::sign(pc).y;
+        else
+            normal.z = glm::sign(pc).z;
+
+        return glm::normalize(normal);
+    }
+
+    // Shaders/Common/Sampling.hlsl
+    glm::vec3 SampleCosineHemisphere(const glm::vec3& normal, const glm::vec2& rand)
+    {
+        float theta = std::acos(std::sqrt(rand.x));
+        float phi = TwoPi * rand.y;
+
+        glm::vec3 t0 = std::abs(normal.x) < SqrtOfOneThird ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+        glm::vec3 t1 = glm::normalize(glm::cross(normal, t0));
+        glm::vec3 t2 = glm::normalize(glm::cross(normal, t1));
+
+        glm::vec3 cartesian(std::cos(phi) * std::sin(theta), std::sin(phi) * std::sin(theta), std::cos(theta));
+
+        return cartesian.x * t1 + cartesian.y * t2 + cartesian.z * normal;
+    }
+
+    glm::vec3 TransformPoint(const glm::mat4& m, const glm::vec3& p)
+    {
+        return glm::vec3(m * glm::vec4(p, 1.0f));
+    }
+
+    glm::vec3 TransformVector(const glm::mat4& m, const glm::vec3& v)
+    {
+        return glm::vec3(m * glm::vec4(v, 0.0f));
+    }
+
+    // The binary leaves are collapsed into Bvh8 leaf children as they are, so the wide layout caps their size
+    BvhBuildSettings GetLayoutSettings(BvhBuildSettings settings, BvhLayout layout)
+    {
+        if (layout == BvhLayout::Wide)
+            settings.MaxLeafSize = std::min(settings.MaxLeafSize, MaxBvh8LeafSize);
+
+        return settings;
+    }
+} // namespace
+
+CpuTracer::CpuTracer(const VoxelSceneView& scene, ThreadPool& pool, const BvhBuildSettings& bvhSettings,
+                     BvhLayout layout, bool mergedVoxels)
+    : mPalette(scene.Palette.begin(), scene.Palette.end()),
+      mBvh(BuildSceneBvh(scene, GetLayoutSettings(bvhSettings, layout), pool)), mLayout(layout),
+      mMergedVoxels(mergedVoxels)
+{
+    mModels.reserve(scene.Models.size());
+    for (auto& model : scene.Models)
+        mModels.push_back(model.AABBs);
+
+    if (mLayout == BvhLayout::Wide)
+    {
+        mWideModels.resize(mBvh.Models.size());
+        pool.ParallelFor(mBvh.Models.size(), 1, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t i = begin; i < end; i++)
+            {
+                mWideModels[i] = CollapseBvh8(mBvh.Models[i]);
+                mBvh.Models[i] = Bvh();
+            }
+        });
+    }
+}
+
+uint64_t CpuTracer::GetBvhMemorySize() const
+{
+    auto binarySize = [](const Bvh& bvh) {
+        return bvh.Nodes.size() * sizeof(BvhNode) + bvh.PrimitiveIndices.size() * sizeof(uint32_t);
+    };
+
+    uint64_t size = binarySize(mBvh.Top);
+
+    for (auto& model : mBvh.Models)
+        size += binarySize(model);
+
+    for (auto& model : mWideModels)
+        size += GetBvh8MemorySize(model);
+
+    return size;
+}
+
+bool CpuTracer::Intersect(const Ray& ray, Hit& outHit) const
+{
+    bool found = false;
+    float tCurrent = ray.TMax;
+
+    // Since isect doesn't report the real hit distance, which box wins can depend on the order the boxes are visited
+    // in. The GPU's order is up to the driver, so front to back is as good a reference as any.
+    TraverseBvh(mBvh.Top, ray.Origin, 1.0f / ray.Direction, ray.TMin, tCurrent, [&](uint32_t instanceIndex) {
+        const SceneBvh::Instance& instance = mBvh.Instances[instanceIndex];
+        const std::span<const VoxAABB> aabbs = mModels[instance.ModelIndex];
+
+        // Like ObjectRayOrigin() and ObjectRayDirection(), the direction isn't normalized
+        const glm::vec3 origin = TransformPoint(instance.WorldToObject, ray.Origin);
+        const glm::vec3 invDir = 1.0f / TransformVector(instance.WorldToObject, ray.Direction);
+
+        auto testBox = [&](uint32_t primitive) {
+            const VoxAABB& aabb = aabbs[primitive];
+
+            float tNear;
+            if (!Overlaps(aabb.Min, aabb.Max, origin, invDir, ray.TMin, tCurrent, tNear))
+                return;
+
+            // isect reports the entry distance of merged boxes and the distance to the min corner of unit voxels,
+            // ReportHit only accepts it within the ray's interval
+            const float dist =
+                mMergedVoxels ? Slabs(aabb.Min, aabb.Max, origin, invDir) : glm::distance(origin, aabb.Min);
+            if (dist < 0.0f || dist < ray.TMin || dist >= tCurrent)
+                return;
+
+            tCurrent = dist;
+            outHit = {dist, instanceIndex, &aabb};
+            found = true;
+        };
+
+        if (mLayout == BvhLayout::Wide)
+            TraverseBvh8(mWideModels[instance.ModelIndex], origin, invDir, ray.TMin, tCurrent, testBox);
+        else
+            TraverseBvh(mBvh.Models[instance.ModelIndex], origin, invDir, ray.TMin, tCurrent, testBox);
+    });
+
+    return found;
+}
+
+void CpuTracer::TracePixel(const SceneConstants& constants, uint32_t x, uint32_t y, uint32_t width,
+                           uint32_t height, glm::vec4& accumulation, glm::vec4& output, uint64_t& rays) const
+{
+    const uint32_t frameCount = constants.OtherInfo.x;
+    const float time = AsFloat(constants.OtherInfo.y);
+    const float sceneEmissiveIntensity = AsFloat(constants.OtherInfo.z);
+    const float skyBrightness = AsFloat(constants.OtherInfo.w);
+
+    // rgen
+    uint32_t seed = x * y * constants.OtherInfo.y;
+
+    // ConstructRay() takes the seed by value
+    Ray ray;
+    {
+        uint32_t raySeed = seed;
+        const glm::vec2 pixelCenter = glm::vec2((float)x, (float)y) +
+                                      glm::vec2(NextRandomFloat(raySeed), NextRandomFloat(raySeed));
+        const glm::vec2 inUV = pixelCenter / glm::vec2((float)width, (float)height);
+        const glm::vec2 d = inUV * 2.0f - 1.0f;
+        const glm::vec4 target = constants.ProjectionInverse * glm::vec4(d.x, d.y, 1.0f, 1.0f);
+
+        ray.Origin = glm::vec3(constants.ViewInverse * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        ray.Direction = glm::normalize(TransformVector(constants.ViewInverse, glm::normalize(glm::vec3(target))));
+        ray.TMin = 0.1f;
+        ray.TMax = 10000.0f;
+    }
+
+    Payload p;
+    p.HitColor = glm::vec3(1.0f);
+    p.RayDirection = glm::vec3(0.0f);
+    p.T = -1.0f;
+    p.Emission = 0.0f;
+
+    for (uint32_t bounce = 0; bounce < MaxBounces; bounce++)
+    {
+        rays++;
+
+        Hit hit;
+        if (!Intersect(ray, hit))
+        {
+            // miss
+            const glm::vec3 rayDir = glm::normalize(ray.Direction);
+            const float t = 0.5f * (rayDir.y + 1.0f);
+            p.HitColor *= glm::mix(glm::vec3(1.0f), glm::vec3(0.5f, 0.7f, 1.0f), t);
+            p.Emission = skyBrightness;
+            p.T = -1.0f;
+            break;
+        }
+
+        // chit
+        const SceneBvh::Instance& instance = mBvh.Instances[hit.Instance];
+        const VoxAABB& voxel = *hit.Voxel;
+
+        const glm::vec3 objectOrigin = TransformPoint(instance.WorldToObject, ray.Origin);
+        const glm::vec3 objectDir = TransformVector(instance.WorldToObject, ray.Direction);
+
+        const float hitT = Slabs(voxel.Min, voxel.Max, objectOrigin, 1.0f / objectDir);
+        if (hitT < 0.0f)
+        {
+            p.HitColor = glm::vec3(0.0f);
+            p.T = -1.0f;
+            break;
+        }
+
+        // Scale by the extent so merged boxes that aren't cubes pick the right face
+        const glm::vec3 voxelMid = (voxel.Max + voxel.Min) / 2.0f;
+        const glm::vec3 pc = ((objectOrigin + hitT * objectDir) - voxelMid) / (voxel.Max - voxel.Min);
+        const glm::vec3 normal = TransformVector(instance.ObjectToWorld, GetNormal(pc));
+
+        // The shader multiplies the bits as ints, which wraps the same as unsigned
+        uint32_t hitSeed = AsUint(time) * AsUint(objectDir.x) * AsUint(objectDir.y) * AsUint(objectDir.z);
+        const glm::vec2 rand(NextRandomFloat(hitSeed), NextRandomFloat(hitSeed));
+
+        const VoxMaterial& m = mPalette[voxel.ColorIndex];
+        const glm::vec3 color((m.Color & 0xFF) / 255.0f, ((m.Color >> 8) & 0xFF) / 255.0f,
+                              ((m.Color >> 16) & 0xFF) / 255.0f);
+        p.HitColor *= color;
+        p.RayDirection = SampleCosineHemisphere(normal, rand);
+
+        // If there is emission, we don't need to trace further.
+        if (m.Emissive > 0.0f)
+        {
+            p.Emission = m.Emissive * sceneEmissiveIntensity;
+            break;
+        }
+
+        p.Emission = 0.0f;
+        p.T = hitT;
+
+        ray.Origin = ray.Origin + p.T * ray.Direction;
+        ray.Direction = glm::normalize(p.RayDirection);
+    }
+
+    glm::vec3 radiance = p.HitColor * p.Emission;
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        if (std::isnan(radiance[i]) || std::isinf(radiance[i]))
+        {
+            radiance = glm::vec3(0.0f);
+            break;
+        }
+    }
+
+    glm::vec3 accum = frameCount == 0 ? radiance : glm::vec3(accumulation) + radiance;
+    accumulation = glm::vec4(accum, accumulation.w);
+    output = accumulation / float(frameCount + 1);
+}
+
+uint64_t CpuTracer::Render(const SceneConstants& constants, uint32_t width, uint32_t height, ThreadPool& pool,
+                           std::vector<glm::vec4>& accumulation, std::vector<glm::vec4>& output) const
+{
+    accumulation.resize((uint64_t)width * height, glm::vec4(0.0f));
+    output.resize((uint64_t)width * height);
+
+    const uint32_t tilesX = (width + TileSize - 1) / TileSize;
+    const uint32_t tilesY = (height + TileSize - 1) / TileSize;
+
+    std::atomic<uint64_t> totalRays = 0;
+
+    pool.ParallelFor((uint64_t)tilesX * tilesY, 1, [&](uint64_t begin, uint64_t end) {
+        uint64_t rays = 0;
+
+        for (uint64_t tile = begin; tile < end; tile++)
+        {
+            const uint32_t startX = (uint32_t)(tile % tilesX) * TileSize;
+            const uint32_t startY = (uint32_t)(tile / tilesX) * TileSize;
+
+            for (uint32_t y = startY; y < std::min(startY + TileSize, height); y++)
+            {
+                for (uint32_t x = startX; x < std::min(startX + TileSize, width); x++)
+                {
+                    const uint64_t index = (uint64_t)y * width + x;
+                    TracePixel(constants, x, y, width, height, accumulation[index], output[index], rays);
+                }
+            }
+        }
+
+        totalRays += rays;
+    });
+
+    return totalRays;
+}
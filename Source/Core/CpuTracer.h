@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Core/Bvh.h"
+#include "Core/Bvh8.h"
+#include "Core/SceneConstants.h"
+#include "Core/ThreadPool.h"
+#include "Core/VoxelExtract.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Node layout of the model BVHs, the instance BVH is always binary
+enum class BvhLayout
+{
+    Binary,
+    // Collapsed 8-wide nodes with quantized bounds, tested with the SIMD slab kernels
+    Wide,
+};
+
+// CPU port of the rgen, isect, chit and miss shaders in Shaders/Optimized.hlsl.
+// Used as a reference image to check the GPU output against and to benchmark on machines without DXR.
+// The shader math is followed closely, quirks included: for unit voxels isect reports the distance to the box's min
+// corner and chit recomputes the real hit with the slab test, merged boxes report their entry distance like isect does
+// under MERGE_VOXELS. Either way the chosen box is the same one the GPU would shade.
+class CpuTracer
+{
+public:
+    // The scene must stay alive as long as the tracer is used. Builds the BVHs on the pool's threads, the wide layout
+    // caps the leaf size at MaxBvh8LeafSize. mergedVoxels matches VoxelLoadSettings::MergeVoxels of the scene.
+    CpuTracer(const VoxelSceneView& scene, ThreadPool& pool, const BvhBuildSettings& bvhSettings = BvhBuildSettings(),
+              BvhLayout layout = BvhLayout::Binary, bool mergedVoxels = false);
+
+    // Traces one sample per pixel in 16x16 tiles on the pool's threads and accumulates it like rgen does.
+    // The accumulation restarts when the frame count in the constants is 0.
+    // accumulation and output hold width * height pixels, output is the average of the accumulated samples.
+    // Returns the number of rays traced.
+    uint64_t Render(const SceneConstants& constants, uint32_t width, uint32_t height, ThreadPool& pool,
+                    std::vector<glm::vec4>& accumulation, std::vector<glm::vec4>& output) const;
+
+public:
+    struct Ray
+    {
+        glm::vec3 Origin;
+        glm::vec3 Direction;
+        float TMin;
+        float TMax;
+    };
+
+    struct Hit
+    {
+        // Distance reported by isect, only the distance to the box for merged voxels
+        float T = 0.0f;
+        uint32_t Instance = 0;
+        const VoxAABB* Voxel = nullptr;
+    };
+
+    // Closest box reported by isect along the ray, false if the ray misses everything.
+    // Walks the instance BVH and the BVHs of the models it reaches like the TLAS and BLAS traversal does.
+    bool Intersect(const Ray& ray, Hit& outHit) const;
+
+    // With the wide layout the binary model BVHs are freed once they are collapsed
+    const SceneBvh& GetBvh() const { return mBvh; }
+
+    // Memory of the instance BVH and the model BVHs in the tracer's layout
+    uint64_t GetBvhMemorySize() const;
+
+private:
+    void TracePixel(const SceneConstants& constants, uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+                    glm::vec4& accumulation, glm::vec4& output, uint64_t& rays) const;
+
+private:
+    std::vector<VoxMaterial> mPalette;
+    std::vector<std::span<const VoxAABB>> mModels;
+    SceneBvh mBvh;
+
+    BvhLayout mLayout;
+    std::vector<Bvh8> mWideModels;
+
+    bool mMergedVoxels;
+};
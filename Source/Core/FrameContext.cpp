@@ -0,0 +1,20 @@
+#include "Core/FrameContext.h"
+
+#include <algorithm>
+
+FrameContext::FrameContext(uint32_t numFramesInFlight)
+    : mSlotFenceValues(std::clamp(numFramesInFlight, MinFramesInFlight, MaxFramesInFlight), 0)
+{
+}
+
+uint32_t FrameContext::BeginFrame(uint64_t frame)
+{
+    mSlot = (uint32_t)(frame % mSlotFenceValues.size());
+    return mSlot;
+}
+
+uint64_t FrameContext::EndFrame()
+{
+    mSlotFenceValues[mSlot] = ++mFenceValue;
+    return mFenceValue;
+}
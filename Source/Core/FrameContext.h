@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Bookkeeping of the frames in flight, independent of the API.
+// Every frame records into the resources of its slot, e.g. a command allocator and a staging buffer. Frame N uses slot
+// N % NumFramesInFlight, so while the GPU works on a frame the CPU records the next ones into the other slots. Before a
+// slot's resources are reused the caller waits for the fence value that was signaled after the slot's last frame.
+// Submissions outside of the frames take their values from the same counter, so the fence only ever increases.
+class FrameContext
+{
+public:
+    static constexpr uint32_t MinFramesInFlight = 2;
+    static constexpr uint32_t MaxFramesInFlight = 4;
+
+    FrameContext() : FrameContext(MinFramesInFlight) {}
+
+    // The number of frames is clamped to [MinFramesInFlight, MaxFramesInFlight]
+    explicit FrameContext(uint32_t numFramesInFlight);
+
+    // Makes the frame's slot the current one and returns it. Its resources are free once the GPU reached
+    // GetWaitValue().
+    uint32_t BeginFrame(uint64_t frame);
+
+    // Fence value signaled after the current slot was last submitted, 0 if it never was
+    uint64_t GetWaitValue() const { return mSlotFenceValues[mSlot]; }
+
+    // Returns the value to signal once the current frame is submitted, the slot waits for it the next time around
+    uint64_t EndFrame();
+
+    // Value to signal for a submission outside of the frames, e.g. one that is waited for right away
+    uint64_t NextFenceValue() { return ++mFenceValue; }
+
+    // Once the GPU reached the last value handed out, everything submitted so far is done
+    uint64_t GetLastFenceValue() const { return mFenceValue; }
+
+    uint32_t GetSlot() const { return mSlot; }
+    uint32_t GetNumFramesInFlight() const { return (uint32_t)mSlotFenceValues.size(); }
+
+private:
+    uint64_t mFenceValue = 0;
+    uint32_t mSlot = 0;
+
+    // Fence value of the last frame submitted from each slot
+    std::vector<uint64_t> mSlotFenceValues;
+};
@@ -0,0 +1,37 @@
+#include "Core/FrameLoop.h"
+#include "Core/Profiler.h"
+
+void RunFrameLoop(FrameLoop& loop)
+{
+    {
+        PROFILE_ZONE("Start");
+        loop.Start();
+    }
+
+    while (!loop.ShouldStop())
+    {
+        PROFILE_ZONE("Frame");
+
+        {
+            PROFILE_ZONE("BeginFrame");
+            loop.BeginFrame();
+        }
+        {
+            PROFILE_ZONE("Update");
+            loop.Update();
+        }
+        {
+            PROFILE_ZONE("EndFrame");
+            loop.EndFrame();
+        }
+    }
+
+    {
+        PROFILE_ZONE("CleanUp");
+        loop.CleanUp();
+    }
+    {
+        PROFILE_ZONE("Stop");
+        loop.Stop();
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// The steps of a renderer's frame loop, independent of the API it renders with.
+// Application implements it with D3D12, with or without a window, and the CPU tracer benchmark implements it on any
+// platform, RunFrameLoop drives both the same way.
+class FrameLoop
+{
+public:
+    virtual ~FrameLoop() = default;
+
+    // Called once before the first frame
+    virtual void Start() {};
+
+    virtual void BeginFrame() {};
+
+    virtual void Update() {};
+
+    virtual void EndFrame() {};
+
+    // Called once after the last frame, waits for the work that is still in flight
+    virtual void CleanUp() {};
+
+    // Called once after CleanUp
+    virtual void Stop() {};
+
+    // Checked before every frame, the loop ends as soon as it returns true
+    virtual bool ShouldStop() const = 0;
+};
+
+// Start, BeginFrame, Update and EndFrame until ShouldStop, then CleanUp and Stop
+void RunFrameLoop(FrameLoop& loop);
@@ -0,0 +1,154 @@
+#include "Core/ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+namespace
+{
+    std::array<uint32_t, 256> MakeCrcTable()
+    {
+        std::array<uint32_t, 256> table;
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (uint32_t k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[n] = c;
+        }
+        return table;
+    }
+
+    uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, uint64_t size)
+    {
+        static const std::array<uint32_t, 256> table = MakeCrcTable();
+
+        for (uint64_t i = 0; i < size; i++)
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return crc;
+    }
+
+    void AppendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+    {
+        out.push_back((uint8_t)(value >> 24));
+        out.push_back((uint8_t)(value >> 16));
+        out.push_back((uint8_t)(value >> 8));
+        out.push_back((uint8_t)value);
+    }
+
+    void WriteChunk(std::ofstream& file, const char type[4], const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> chunk;
+        chunk.reserve(data.size() + 12);
+
+        AppendBigEndian(chunk, (uint32_t)data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+
+        // The CRC covers the type and the data
+        const uint32_t crc = UpdateCrc(0xFFFFFFFFu, chunk.data() + 4, data.size() + 4) ^ 0xFFFFFFFFu;
+        AppendBigEndian(chunk, crc);
+
+        file.write((const char*)chunk.data(), chunk.size());
+    }
+} // namespace
+
+std::vector<uint8_t> ConvertToRGBA8(const std::vector<glm::vec4>& pixels)
+{
+    std::vector<uint8_t> rgba(pixels.size() * 4);
+
+    for (uint64_t i = 0; i < pixels.size(); i++)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+            rgba[i * 4 + c] = (uint8_t)(std::clamp(pixels[i][c], 0.0f, 1.0f) * 255.0f + 0.5f);
+        rgba[i * 4 + 3] = 255;
+    }
+
+    return rgba;
+}
+
+bool WritePNG(const std::string& filePath, uint32_t width, uint32_t height, const uint8_t* rgba)
+{
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    const uint8_t signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write((const char*)signature, sizeof(signature));
+
+    // 8 bit RGBA, no interlacing
+    std::vector<uint8_t> header;
+    AppendBigEndian(header, width);
+    AppendBigEndian(header, height);
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+    WriteChunk(file, "IHDR", header);
+
+    // Every row starts with filter type 0
+    const uint64_t rowSize = (uint64_t)width * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgba + y * rowSize, rgba + (y + 1) * rowSize);
+    }
+
+    // zlib stream made of stored deflate blocks, the images are only used for comparisons so size doesn't matter
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    constexpr uint64_t MaxBlockSize = 65535;
+
+    uint64_t offset = 0;
+    do
+    {
+        const uint16_t blockSize = (uint16_t)std::min(MaxBlockSize, raw.size() - offset);
+        const bool last = offset + blockSize == raw.size();
+
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back((uint8_t)blockSize);
+        zlib.push_back((uint8_t)(blockSize >> 8));
+        zlib.push_back((uint8_t)~blockSize);
+        zlib.push_back((uint8_t)(~blockSize >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+        offset += blockSize;
+    } while (offset < raw.size());
+
+    // Adler-32 of the uncompressed data
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : raw)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    AppendBigEndian(zlib, (b << 16) | a);
+
+    WriteChunk(file, "IDAT", zlib);
+    WriteChunk(file, "IEND", {});
+
+    return file.good();
+}
+
+bool WritePFM(const std::string& filePath, uint32_t width, uint32_t height, const glm::vec4* pixels)
+{
+    std::ofstream file(filePath, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    // A negative scale marks the floats as little endian
+    const std::string header = "PF\n" + std::to_string(width) + " " + std::to_string(height) + "\n-1.0\n";
+    file.write(header.data(), header.size());
+
+    // The rows are stored bottom row first
+    std::vector<float> row((uint64_t)width * 3);
+    for (uint32_t y = height; y-- > 0;)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+                row[x * 3 + c] = pixels[(uint64_t)y * width + x][c];
+        }
+        file.write((const char*)row.data(), row.size() * sizeof(float));
+    }
+
+    return file.good();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Converts float RGBA pixels to 8 bit like a write to an R8G8B8A8_UNORM texture: clamped to [0, 1], no gamma.
+// Alpha is set to opaque, the shaders leave it at 0 and the swapchain ignores it.
+std::vector<uint8_t> ConvertToRGBA8(const std::vector<glm::vec4>& pixels);
+
+// Writes width * height RGBA8 pixels, top row first, as an uncompressed PNG
+bool WritePNG(const std::string& filePath, uint32_t width, uint32_t height, const uint8_t* rgba);
+
+// Writes the RGB of width * height float pixels, top row first, as a little endian Portable Float Map (.pfm).
+// Keeps the unclamped radiance that WritePNG cuts off at 1, alpha is dropped.
+bool WritePFM(const std::string& filePath, uint32_t width, uint32_t height, const glm::vec4* pixels);
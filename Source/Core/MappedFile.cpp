@@ -0,0 +1,162 @@
+#include "Core/MappedFile.h"
+
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+
+        mData = std::exchange(other.mData, nullptr);
+        mSize = std::exchange(other.mSize, 0);
+        mIsOpen = std::exchange(other.mIsOpen, false);
+#ifdef _WIN32
+        mFileHandle = std::exchange(other.mFileHandle, nullptr);
+        mMappingHandle = std::exchange(other.mMappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filePath)
+{
+    Close();
+
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::printf("Failed to open file: %s\n", filePath.c_str());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    mFileHandle = file;
+    mSize = (uint64_t)fileSize.QuadPart;
+    mIsOpen = true;
+
+    // Zero sized files cannot be mapped
+    if (mSize == 0)
+        return true;
+
+    mMappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMappingHandle != nullptr)
+        mData = (const uint8_t*)MapViewOfFile(mMappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    if (mData == nullptr)
+    {
+        std::printf("Failed to map file: %s\n", filePath.c_str());
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData != nullptr)
+        UnmapViewOfFile(mData);
+    if (mMappingHandle != nullptr)
+        CloseHandle(mMappingHandle);
+    if (mFileHandle != nullptr)
+        CloseHandle(mFileHandle);
+
+    mData = nullptr;
+    mSize = 0;
+    mIsOpen = false;
+    mFileHandle = nullptr;
+    mMappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filePath)
+{
+    Close();
+
+    int file = open(filePath.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        std::printf("Failed to open file: %s\n", filePath.c_str());
+        return false;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(file, &fileStat) != 0)
+    {
+        close(file);
+        return false;
+    }
+
+    mSize = (uint64_t)fileStat.st_size;
+    mIsOpen = true;
+
+    // Zero sized files cannot be mapped
+    if (mSize != 0)
+    {
+        void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED)
+        {
+            std::printf("Failed to map file: %s\n", filePath.c_str());
+            close(file);
+            Close();
+            return false;
+        }
+
+        // Files are read front to back by the parsers
+        madvise(data, mSize, MADV_SEQUENTIAL);
+        mData = (const uint8_t*)data;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(file);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData != nullptr)
+        munmap((void*)mData, mSize);
+
+    mData = nullptr;
+    mSize = 0;
+    mIsOpen = false;
+}
+
+#endif
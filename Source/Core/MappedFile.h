@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+// Read-only memory mapping of a whole file. The data is paged in by the OS on first access
+// instead of being copied into a heap allocation, so large scenes are not held in memory twice.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Maps the file, unmapping any previously opened one. Empty files open successfully with empty data.
+    bool Open(const std::string& filePath);
+    void Close();
+
+    bool IsOpen() const { return mIsOpen; }
+
+    // Valid until the file is closed
+    std::span<const uint8_t> GetData() const { return {mData, mSize}; }
+
+private:
+    const uint8_t* mData = nullptr;
+    uint64_t mSize = 0;
+    bool mIsOpen = false;
+
+#ifdef _WIN32
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#endif
+};
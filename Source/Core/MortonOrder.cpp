@@ -0,0 +1,175 @@
+#include "Core/MortonOrder.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+    constexpr uint32_t RadixBits = 8;
+    constexpr uint32_t NumBuckets = 1 << RadixBits;
+
+    // Values per chunk below which more chunks cost more in histograms than they win in parallelism
+    constexpr uint64_t MinChunkSize = 1 << 14;
+} // namespace
+
+uint32_t SpreadBits10(uint32_t v)
+{
+    v &= 0x3FF;
+    v = (v | v << 16) & 0x030000FF;
+    v = (v | v << 8) & 0x0300F00F;
+    v = (v | v << 4) & 0x030C30C3;
+    v = (v | v << 2) & 0x09249249;
+    return v;
+}
+
+uint32_t HilbertCode30(const glm::uvec3& position)
+{
+    // Skilling's transform of the axes into the transposed Hilbert index, "Programming the Hilbert curve" (2004)
+    uint32_t x[3] = {position.x & 0x3FF, position.y & 0x3FF, position.z & 0x3FF};
+
+    for (uint32_t q = 1 << 9; q > 1; q >>= 1)
+    {
+        const uint32_t p = q - 1;
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            if (x[i] & q)
+            {
+                x[0] ^= p;
+            }
+            else
+            {
+                const uint32_t t = (x[0] ^ x[i]) & p;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    x[1] ^= x[0];
+    x[2] ^= x[1];
+
+    uint32_t t = 0;
+    for (uint32_t q = 1 << 9; q > 1; q >>= 1)
+    {
+        if (x[2] & q)
+            t ^= q - 1;
+    }
+
+    for (uint32_t i = 0; i < 3; i++)
+        x[i] ^= t;
+
+    // The index is the bits of the transposed axes interleaved, the first axis highest
+    return SpreadBits10(x[2]) | SpreadBits10(x[1]) << 1 | SpreadBits10(x[0]) << 2;
+}
+
+void ParallelRadixSort(std::vector<uint64_t>& values, uint32_t firstBit, uint32_t numBits, ThreadPool& pool)
+{
+    const uint64_t count = values.size();
+    if (count < 2)
+        return;
+
+    const uint64_t numChunks = std::clamp<uint64_t>(count / MinChunkSize, 1, pool.GetThreadCount());
+    const uint64_t chunkSize = (count + numChunks - 1) / numChunks;
+
+    std::vector<uint64_t> scratch(count);
+    std::vector<std::array<uint64_t, NumBuckets>> offsets(numChunks);
+
+    const uint32_t lastBit = firstBit + numBits;
+    for (uint32_t shift = firstBit; shift < lastBit; shift += RadixBits)
+    {
+        const uint64_t digitMask = (1ull << std::min(RadixBits, lastBit - shift)) - 1;
+
+        pool.ParallelFor(numChunks, 1, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t c = begin; c < end; c++)
+            {
+                offsets[c].fill(0);
+                for (uint64_t i = c * chunkSize; i < std::min(count, (c + 1) * chunkSize); i++)
+                    offsets[c][(values[i] >> shift) & digitMask]++;
+            }
+        });
+
+        // Exclusive sum over the buckets first and the chunks second, so every chunk scatters its values of a bucket
+        // behind those of the chunks before it and the sort stays stable
+        uint64_t sum = 0;
+        bool singleBucket = false;
+        for (uint32_t bucket = 0; bucket < NumBuckets; bucket++)
+        {
+            uint64_t bucketSize = 0;
+            for (uint64_t c = 0; c < numChunks; c++)
+            {
+                const uint64_t n = offsets[c][bucket];
+                offsets[c][bucket] = sum;
+                sum += n;
+                bucketSize += n;
+            }
+            singleBucket |= bucketSize == count;
+        }
+
+        // Every value has the same digit, the pass would not move anything
+        if (singleBucket)
+            continue;
+
+        pool.ParallelFor(numChunks, 1, [&](uint64_t begin, uint64_t end) {
+            for (uint64_t c = begin; c < end; c++)
+            {
+                for (uint64_t i = c * chunkSize; i < std::min(count, (c + 1) * chunkSize); i++)
+                    scratch[offsets[c][(values[i] >> shift) & digitMask]++] = values[i];
+            }
+        });
+
+        values.swap(scratch);
+    }
+}
+
+void ReorderAABBs(std::vector<VoxAABB>& aabbs, VoxelOrder order, ThreadPool& pool)
+{
+    if (order == VoxelOrder::Linear || aabbs.size() < 2)
+        return;
+
+    const uint64_t count = aabbs.size();
+
+    // Code above the box index, sorting by the code bits carries the index along
+    std::vector<uint64_t> keys(count);
+    pool.ParallelFor(count, MinChunkSize, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++)
+        {
+            // Boxes span [x - 0.5, x + w - 0.5], so the center is in [0, 256] on the grid
+            const glm::uvec3 center = glm::uvec3((aabbs[i].Min + aabbs[i].Max) * 0.5f + 0.5f);
+            const uint32_t code = order == VoxelOrder::Morton ? MortonCode30(center) : HilbertCode30(center);
+            keys[i] = (uint64_t)code << 32 | i;
+        }
+    });
+
+    ParallelRadixSort(keys, 32, 30, pool);
+
+    std::vector<VoxAABB> sorted(count);
+    pool.ParallelFor(count, MinChunkSize, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++)
+            sorted[i] = aabbs[(uint32_t)keys[i]];
+    });
+
+    aabbs.swap(sorted);
+}
+
+VoxelOrder ParseVoxelOrder(std::string_view name)
+{
+    if (name == "morton")
+        return VoxelOrder::Morton;
+    if (name == "hilbert")
+        return VoxelOrder::Hilbert;
+    return VoxelOrder::Linear;
+}
+
+const char* GetVoxelOrderName(VoxelOrder order)
+{
+    switch (order)
+    {
+    case VoxelOrder::Morton:
+        return "morton";
+    case VoxelOrder::Hilbert:
+        return "hilbert";
+    default:
+        return "linear";
+    }
+}
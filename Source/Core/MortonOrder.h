@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Core/ThreadPool.h"
+#include "Core/Voxel.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Spreads the low 10 bits of v so there are two zero bits between each of them
+uint32_t SpreadBits10(uint32_t v);
+
+// 30 bit Morton (Z-order) code of a position with 10 bits per axis, x in the lowest bit
+inline uint32_t MortonCode30(const glm::uvec3& position)
+{
+    return SpreadBits10(position.x) | SpreadBits10(position.y) << 1 | SpreadBits10(position.z) << 2;
+}
+
+// 30 bit index of a position with 10 bits per axis along a 3D Hilbert curve. Unlike the Morton order, consecutive
+// indices are always neighbouring cells.
+uint32_t HilbertCode30(const glm::uvec3& position);
+
+// Stable LSD radix sort of the values by their bits [firstBit, firstBit + numBits), 8 bits per pass.
+// Every pass builds a histogram per chunk of the values on the pool's threads and scatters the chunks in parallel,
+// must not be called from one of the pool's tasks.
+void ParallelRadixSort(std::vector<uint64_t>& values, uint32_t firstBit, uint32_t numBits, ThreadPool& pool);
+
+// Sorts the boxes of a model by the code of their center along the given curve. Boxes are on the model's voxel grid,
+// .vox models are at most 256 voxels on each axis, so 10 bits per axis are always enough.
+void ReorderAABBs(std::vector<VoxAABB>& aabbs, VoxelOrder order, ThreadPool& pool);
+
+// "linear", "morton" or "hilbert" as written in config.toml, anything else is linear
+VoxelOrder ParseVoxelOrder(std::string_view name);
+const char* GetVoxelOrderName(VoxelOrder order);
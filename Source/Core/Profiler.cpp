@@ -0,0 +1,192 @@
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+    // Ring buffer of one thread. Only its thread writes zones, the lock is only contended while the zones are
+    // collected.
+    struct ThreadZones
+    {
+        std::mutex Mutex;
+        std::vector<ProfilerZone> Zones;
+        // Zones ever recorded, the next one goes to Count % Zones.size()
+        uint64_t Count = 0;
+        uint32_t ThreadId = 0;
+    };
+
+    struct ProfilerState
+    {
+        std::atomic<bool> Enabled = false;
+        std::chrono::steady_clock::time_point Epoch;
+        uint32_t ZonesPerThread = 0;
+
+        // The buffers outlive their threads, so the zones of the loader threads are still there when collected
+        std::mutex Mutex;
+        std::vector<std::shared_ptr<ThreadZones>> Threads;
+    };
+
+    ProfilerState& GetState()
+    {
+        static ProfilerState state;
+        return state;
+    }
+
+    // Zones that are open on this thread
+    thread_local uint32_t tDepth = 0;
+    thread_local std::shared_ptr<ThreadZones> tZones;
+
+    ThreadZones& GetThreadZones()
+    {
+        if (tZones == nullptr)
+        {
+            ProfilerState& state = GetState();
+            std::lock_guard lock(state.Mutex);
+
+            tZones = std::make_shared<ThreadZones>();
+            tZones->ThreadId = (uint32_t)state.Threads.size();
+            state.Threads.push_back(tZones);
+        }
+        return *tZones;
+    }
+
+    int64_t GetNanoseconds(std::chrono::steady_clock::time_point time)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - GetState().Epoch).count();
+    }
+} // namespace
+
+void EnableProfiler(uint32_t zonesPerThread)
+{
+    ProfilerState& state = GetState();
+    std::lock_guard lock(state.Mutex);
+
+    // Zones recorded before are dropped, the buffers are resized by their threads with the next zone
+    for (auto& thread : state.Threads)
+    {
+        std::lock_guard threadLock(thread->Mutex);
+        thread->Zones.clear();
+        thread->Count = 0;
+    }
+
+    state.ZonesPerThread = std::max(zonesPerThread, 1u);
+    state.Epoch = std::chrono::steady_clock::now();
+    state.Enabled.store(true, std::memory_order_release);
+}
+
+void DisableProfiler()
+{
+    GetState().Enabled.store(false, std::memory_order_release);
+}
+
+bool IsProfilerEnabled()
+{
+    return GetState().Enabled.load(std::memory_order_acquire);
+}
+
+std::vector<ProfilerZone> CollectProfilerZones()
+{
+    ProfilerState& state = GetState();
+    std::lock_guard lock(state.Mutex);
+
+    std::vector<ProfilerZone> zones;
+    for (auto& thread : state.Threads)
+    {
+        std::lock_guard threadLock(thread->Mutex);
+
+        // Oldest first, once the ring has wrapped the oldest zone is the one that is overwritten next
+        const uint64_t size = thread->Zones.size();
+        const uint64_t count = std::min<uint64_t>(thread->Count, size);
+        const uint64_t first = thread->Count - count;
+        for (uint64_t i = first; i < thread->Count; i++)
+            zones.push_back(thread->Zones[i % size]);
+    }
+
+    // Zones end inner first, sorting by begin puts every parent before its children
+    std::stable_sort(zones.begin(), zones.end(), [](const ProfilerZone& a, const ProfilerZone& b) {
+        return a.Begin < b.Begin || (a.Begin == b.Begin && a.Depth < b.Depth);
+    });
+
+    return zones;
+}
+
+bool WriteChromeTrace(const std::string& filePath, std::span<const ProfilerZone> zones)
+{
+    std::ofstream file(filePath);
+    if (!file.is_open())
+        return false;
+
+    // Complete events with their begin and duration in microseconds
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+    file << std::fixed << std::setprecision(3);
+    for (uint64_t i = 0; i < zones.size(); i++)
+    {
+        const ProfilerZone& zone = zones[i];
+
+        std::string name;
+        for (const char* c = zone.Name; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+                name += '\\';
+            name += *c;
+        }
+
+        file << "{\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << zone.ThreadId
+             << ", \"ts\": " << zone.Begin / 1000.0 << ", \"dur\": " << (zone.End - zone.Begin) / 1000.0 << "}"
+             << (i + 1 < zones.size() ? "," : "") << std::endl;
+    }
+    file << "]}" << std::endl;
+
+    return file.good();
+}
+
+ProfileZone::ProfileZone(const char* name)
+    : mName(name), mBegin(std::chrono::steady_clock::now()), mRecorded(IsProfilerEnabled())
+{
+    if (mRecorded)
+        tDepth++;
+}
+
+ProfileZone::~ProfileZone()
+{
+    if (!mRecorded)
+        return;
+
+    tDepth--;
+
+    // Disabled while the zone was open
+    ProfilerState& state = GetState();
+    if (!IsProfilerEnabled())
+        return;
+
+    ProfilerZone zone;
+    zone.Name = mName;
+    zone.Begin = GetNanoseconds(mBegin);
+    zone.End = GetNanoseconds(std::chrono::steady_clock::now());
+    zone.Depth = tDepth;
+
+    // The zone began before the profiler was enabled again
+    if (zone.Begin < 0)
+        return;
+
+    ThreadZones& thread = GetThreadZones();
+    zone.ThreadId = thread.ThreadId;
+
+    std::lock_guard lock(thread.Mutex);
+    if (thread.Zones.size() != state.ZonesPerThread)
+    {
+        thread.Zones.resize(state.ZonesPerThread);
+        thread.Count = 0;
+    }
+    thread.Zones[thread.Count++ % thread.Zones.size()] = zone;
+}
+
+double ProfileZone::GetElapsedMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mBegin).count();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// A zone that ended, times in nanoseconds since the profiler was enabled
+struct ProfilerZone
+{
+    // The name given to the zone, a string literal that is never copied
+    const char* Name = nullptr;
+    int64_t Begin = 0;
+    int64_t End = 0;
+    // Zones that were open on the thread when this one began
+    uint32_t Depth = 0;
+    // Small ids in the order the threads recorded their first zone
+    uint32_t ThreadId = 0;
+};
+
+// Starts recording zones. Every thread records into its own ring buffer of zonesPerThread zones, once it's full the
+// oldest zones are overwritten. Zones that begin before the profiler is enabled aren't recorded.
+void EnableProfiler(uint32_t zonesPerThread = 1 << 16);
+void DisableProfiler();
+bool IsProfilerEnabled();
+
+// The zones of all threads that are still in their ring buffers, sorted by begin. Threads may keep recording while
+// the zones are collected.
+std::vector<ProfilerZone> CollectProfilerZones();
+
+// Writes the zones as complete events of the Chrome trace event format, for chrome://tracing or ui.perfetto.dev
+bool WriteChromeTrace(const std::string& filePath, std::span<const ProfilerZone> zones);
+
+// Records the time from its construction to its destruction as a zone of the calling thread. Zones nest, a zone that
+// begins while another one is open on the same thread is drawn below it.
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name);
+    ~ProfileZone();
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+    // Milliseconds since the zone began, also while the profiler is disabled
+    double GetElapsedMs() const;
+
+private:
+    const char* mName;
+    std::chrono::steady_clock::time_point mBegin;
+    // Whether the profiler was enabled when the zone began, only those zones are recorded
+    bool mRecorded;
+};
+
+#define PROFILE_ZONE_CONCAT_INNER(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT_INNER(a, b)
+
+// Profiles the rest of the enclosing scope
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profileZone, __COUNTER__)(name)
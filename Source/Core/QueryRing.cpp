@@ -0,0 +1,40 @@
+#include "Core/QueryRing.h"
+
+#include <algorithm>
+#include <cassert>
+
+QueryRing::QueryRing(uint32_t numSlots, uint32_t queriesPerFrame)
+    : mQueriesPerFrame(queriesPerFrame), mSlotFrames(numSlots, NoFrame)
+{
+    assert(numSlots > 0 && "The ring needs at least one slot");
+}
+
+bool QueryRing::BeginFrame(uint64_t frame, QueryRingFrame& outCompleted)
+{
+    mSlot = (uint32_t)(frame % mSlotFrames.size());
+
+    const uint64_t previous = mSlotFrames[mSlot];
+    mSlotFrames[mSlot] = frame;
+
+    if (previous == NoFrame)
+        return false;
+
+    assert(previous < frame && "Frames must be begun in order");
+    outCompleted = {previous, mSlot};
+    return true;
+}
+
+std::vector<QueryRingFrame> QueryRing::Drain()
+{
+    std::vector<QueryRingFrame> frames;
+    for (uint32_t slot = 0; slot < mSlotFrames.size(); slot++)
+    {
+        if (mSlotFrames[slot] != NoFrame)
+            frames.push_back({mSlotFrames[slot], slot});
+        mSlotFrames[slot] = NoFrame;
+    }
+
+    std::sort(frames.begin(), frames.end(),
+              [](const QueryRingFrame& a, const QueryRingFrame& b) { return a.Frame < b.Frame; });
+    return frames;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A frame's queries and where they are in the query heap and in the readback buffer they are resolved into
+struct QueryRingFrame
+{
+    uint64_t Frame = 0;
+    uint32_t Slot = 0;
+};
+
+// Bookkeeping of GPU queries that are read back with a few frames of latency, independent of the API.
+// Every frame writes its queries into its own slot of the query heap and resolves them into the same slot of a
+// readback buffer. Frame N uses slot N % NumSlots, so before it is begun the caller has to wait for frame
+// N - NumSlots, the last frame that used the slot, whose results are then handed out to be read.
+class QueryRing
+{
+public:
+    QueryRing() = default;
+    QueryRing(uint32_t numSlots, uint32_t queriesPerFrame);
+
+    // Claims the slot of the frame. Returns true if an earlier frame still has unread results in the slot, they're
+    // complete once that frame has been waited for and have to be read before the new frame overwrites them.
+    bool BeginFrame(uint64_t frame, QueryRingFrame& outCompleted);
+
+    // The frames whose results haven't been handed out yet, oldest first. Read them once the GPU is idle.
+    std::vector<QueryRingFrame> Drain();
+
+    // Slot of the frame last begun
+    uint32_t GetSlot() const { return mSlot; }
+
+    // Index of a query of the frame last begun in the query heap
+    uint32_t GetQueryIndex(uint32_t query) const { return GetFirstQuery(mSlot) + query; }
+
+    uint32_t GetFirstQuery(uint32_t slot) const { return slot * mQueriesPerFrame; }
+
+    // Byte offset of a slot's results in the readback buffer, every result is a uint64_t
+    uint64_t GetResultOffset(uint32_t slot) const { return (uint64_t)GetFirstQuery(slot) * sizeof(uint64_t); }
+
+    uint32_t GetQueriesPerFrame() const { return mQueriesPerFrame; }
+
+    // Queries in the heap and results in the readback buffer for all slots
+    uint32_t GetNumQueries() const { return (uint32_t)mSlotFrames.size() * mQueriesPerFrame; }
+
+private:
+    static constexpr uint64_t NoFrame = UINT64_MAX;
+
+    uint32_t mQueriesPerFrame = 0;
+    uint32_t mSlot = 0;
+
+    // Frame whose results are in each slot and haven't been handed out yet
+    std::vector<uint64_t> mSlotFrames;
+};
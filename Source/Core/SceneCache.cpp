@@ -0,0 +1,194 @@
+#include "Core/SceneCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    constexpr char SceneCacheMagic[4] = {'F', 'V', 'X', 'C'};
+
+    constexpr uint64_t FnvPrime = 0x100000001b3ull;
+
+    uint64_t AlignOffset(uint64_t offset)
+    {
+        return (offset + SceneCacheAlignment - 1) & ~(SceneCacheAlignment - 1);
+    }
+
+    void WritePadding(std::ofstream& file, uint64_t& offset)
+    {
+        static const char zeros[SceneCacheAlignment] = {};
+        const uint64_t aligned = AlignOffset(offset);
+        file.write(zeros, aligned - offset);
+        offset = aligned;
+    }
+
+    template<typename T>
+    void WriteArray(std::ofstream& file, uint64_t& offset, const T* data, uint64_t count)
+    {
+        file.write((const char*)data, count * sizeof(T));
+        offset += count * sizeof(T);
+    }
+
+    bool InBounds(std::span<const uint8_t> cache, uint64_t offset, uint64_t size)
+    {
+        return offset <= cache.size() && size <= cache.size() - offset;
+    }
+} // namespace
+
+static_assert(sizeof(VoxAABB) == 32, "VoxAABB layout is part of the cache format");
+static_assert(sizeof(VoxMaterial) == 8, "VoxMaterial layout is part of the cache format");
+static_assert(sizeof(VoxelInstance) == 52, "VoxelInstance layout is part of the cache format");
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = seed;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * FnvPrime;
+    }
+
+    for (; i < size; i++)
+        hash = (hash ^ bytes[i]) * FnvPrime;
+
+    return hash;
+}
+
+uint64_t HashLoadSettings(const VoxelLoadSettings& settings)
+{
+    const uint8_t flags[] = {
+        settings.MergeVoxels,
+        settings.CullInteriorVoxels,
+        (uint8_t)settings.AABBOrder,
+    };
+    return HashBytes(flags, sizeof(flags));
+}
+
+std::string GetSceneCachePath(const std::string& voxFile)
+{
+    return voxFile + "cache";
+}
+
+bool WriteSceneCache(const std::string& cacheFile, uint64_t sourceHash, const VoxelLoadSettings& settings,
+                     const VoxelSceneView& scene)
+{
+    SceneCacheHeader header = {};
+    memcpy(header.Magic, SceneCacheMagic, sizeof(header.Magic));
+    header.Version = SceneCacheVersion;
+    header.SourceHash = sourceHash;
+    header.SettingsHash = HashLoadSettings(settings);
+    header.NumVoxels = scene.NumVoxels;
+    header.NumAABBs = scene.NumAABBs;
+    header.NumCulledVoxels = scene.NumCulledVoxels;
+    header.NumPaletteEntries = (uint32_t)scene.Palette.size();
+    header.NumModels = (uint32_t)scene.Models.size();
+    header.NumInstances = (uint32_t)scene.Instances.size();
+
+    // Lay out the sections
+    uint64_t offset = AlignOffset(sizeof(SceneCacheHeader));
+    header.PaletteOffset = offset;
+    offset = AlignOffset(offset + scene.Palette.size_bytes());
+    header.ModelsOffset = offset;
+    offset = AlignOffset(offset + scene.Models.size() * sizeof(SceneCacheModel));
+    header.InstancesOffset = offset;
+    offset = AlignOffset(offset + scene.Instances.size_bytes());
+
+    std::vector<SceneCacheModel> models(scene.Models.size());
+    for (size_t i = 0; i < scene.Models.size(); i++)
+    {
+        auto& model = scene.Models[i];
+        models[i].Size[0] = model.Size.x;
+        models[i].Size[1] = model.Size.y;
+        models[i].Size[2] = model.Size.z;
+        models[i].Padding = 0;
+        models[i].AABBOffset = offset;
+        models[i].NumAABBs = model.AABBs.size();
+
+        offset = AlignOffset(offset + model.AABBs.size_bytes());
+    }
+    header.FileSize = offset;
+
+    // Write to a temporary file first, so a crash never leaves a truncated cache with a valid header behind
+    const std::string tempFile = cacheFile + ".tmp";
+    {
+        std::ofstream file(tempFile, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        offset = 0;
+        WriteArray(file, offset, &header, 1);
+        WritePadding(file, offset);
+        WriteArray(file, offset, scene.Palette.data(), scene.Palette.size());
+        WritePadding(file, offset);
+        WriteArray(file, offset, models.data(), models.size());
+        WritePadding(file, offset);
+        WriteArray(file, offset, scene.Instances.data(), scene.Instances.size());
+        WritePadding(file, offset);
+
+        for (auto& model : scene.Models)
+        {
+            WriteArray(file, offset, model.AABBs.data(), model.AABBs.size());
+            WritePadding(file, offset);
+        }
+
+        if (!file.good())
+            return false;
+    }
+
+    std::remove(cacheFile.c_str());
+    return std::rename(tempFile.c_str(), cacheFile.c_str()) == 0;
+}
+
+bool OpenSceneCache(std::span<const uint8_t> cache, uint64_t sourceHash, const VoxelLoadSettings& settings,
+                    VoxelSceneView& outScene)
+{
+    if (cache.size() < sizeof(SceneCacheHeader))
+        return false;
+
+    SceneCacheHeader header;
+    memcpy(&header, cache.data(), sizeof(header));
+
+    if (memcmp(header.Magic, SceneCacheMagic, sizeof(header.Magic)) != 0 || header.Version != SceneCacheVersion ||
+        header.SourceHash != sourceHash || header.SettingsHash != HashLoadSettings(settings) ||
+        header.FileSize != cache.size())
+        return false;
+
+    if (!InBounds(cache, header.PaletteOffset, header.NumPaletteEntries * sizeof(VoxMaterial)) ||
+        !InBounds(cache, header.ModelsOffset, header.NumModels * sizeof(SceneCacheModel)) ||
+        !InBounds(cache, header.InstancesOffset, header.NumInstances * sizeof(VoxelInstance)))
+        return false;
+
+    outScene = {};
+    outScene.NumVoxels = header.NumVoxels;
+    outScene.NumAABBs = header.NumAABBs;
+    outScene.NumCulledVoxels = header.NumCulledVoxels;
+
+    // The sections are aligned, so they can be used in place
+    outScene.Palette = {(const VoxMaterial*)(cache.data() + header.PaletteOffset), header.NumPaletteEntries};
+    outScene.Instances = {(const VoxelInstance*)(cache.data() + header.InstancesOffset), header.NumInstances};
+
+    const SceneCacheModel* models = (const SceneCacheModel*)(cache.data() + header.ModelsOffset);
+
+    outScene.Models.resize(header.NumModels);
+    for (uint32_t i = 0; i < header.NumModels; i++)
+    {
+        if (!InBounds(cache, models[i].AABBOffset, models[i].NumAABBs * sizeof(VoxAABB)))
+            return false;
+
+        outScene.Models[i].Size = glm::vec3(models[i].Size[0], models[i].Size[1], models[i].Size[2]);
+        outScene.Models[i].AABBs = {(const VoxAABB*)(cache.data() + models[i].AABBOffset), models[i].NumAABBs};
+    }
+
+    for (auto& instance : outScene.Instances)
+    {
+        if (instance.ModelIndex >= header.NumModels)
+            return false;
+    }
+
+    return true;
+}
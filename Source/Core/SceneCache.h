@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Core/VoxelExtract.h"
+
+// Binary cache of an extracted scene, so startup can skip parsing the .vox and walking every voxel.
+//
+// The file is a SceneCacheHeader followed by the palette, the model table, the instances and finally the AABB arrays
+// of all models, every section aligned to SceneCacheAlignment. All sections are stored in the exact layout the
+// upload buffers use, so a mapped cache file can be memcpy'd into them directly.
+//
+// A cache is only used if its version, the hash of the source .vox file and the hash of the loader settings that
+// affect the output all match, otherwise it's rebuilt.
+
+constexpr uint32_t SceneCacheVersion = 1;
+constexpr uint64_t SceneCacheAlignment = 64;
+
+struct SceneCacheHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint64_t SourceHash;
+    uint64_t SettingsHash;
+    uint64_t FileSize;
+
+    uint64_t NumVoxels;
+    uint64_t NumAABBs;
+    uint64_t NumCulledVoxels;
+
+    uint32_t NumPaletteEntries;
+    uint32_t NumModels;
+    uint32_t NumInstances;
+    uint32_t Padding;
+
+    uint64_t PaletteOffset;
+    uint64_t ModelsOffset;
+    uint64_t InstancesOffset;
+};
+
+struct SceneCacheModel
+{
+    float Size[3];
+    uint32_t Padding;
+    // Byte offset of the model's AABBs from the start of the file
+    uint64_t AABBOffset;
+    uint64_t NumAABBs;
+};
+
+// 64 bit FNV-1a over 8 byte words, the tail is hashed bytewise
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+// Hash of the settings that change the extracted AABBs, thread counts etc. are ignored
+uint64_t HashLoadSettings(const VoxelLoadSettings& settings);
+
+// Path of the cache that belongs to a .vox file
+std::string GetSceneCachePath(const std::string& voxFile);
+
+bool WriteSceneCache(const std::string& cacheFile, uint64_t sourceHash, const VoxelLoadSettings& settings,
+                     const VoxelSceneView& scene);
+
+// Validates the cache bytes against the source hash and settings and fills a view that points into them.
+// Returns false if the cache is stale or malformed.
+bool OpenSceneCache(std::span<const uint8_t> cache, uint64_t sourceHash, const VoxelLoadSettings& settings,
+                    VoxelSceneView& outScene);
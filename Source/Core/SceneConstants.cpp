@@ -0,0 +1,34 @@
+#include "Core/SceneConstants.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cstring>
+
+namespace
+{
+    uint32_t FloatBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+} // namespace
+
+SceneConstants MakeSceneConstants(Camera& camera, uint32_t frameCount, float time, float emissiveIntensity,
+                                  float skyBrightness)
+{
+    glm::mat4 view = camera.GetViewMatrix();
+    glm::mat4 proj = camera.GetProjectionMatrix();
+
+    // Rotate the whole world
+    glm::mat4 rot = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    view = view * rot;
+
+    SceneConstants constants;
+    constants.ViewInverse = glm::inverse(view);
+    constants.ProjectionInverse = glm::inverse(proj);
+    constants.OtherInfo =
+        glm::uvec4(frameCount, FloatBits(time), FloatBits(emissiveIntensity), FloatBits(skyBrightness));
+
+    return constants;
+}
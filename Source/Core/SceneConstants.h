@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Core/Camera.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Per frame constants, the layout of SceneInfo in Shaders/Common/Resources.hlsl
+struct SceneConstants
+{
+    glm::mat4 ViewInverse;
+    glm::mat4 ProjectionInverse;
+
+    // x: frames accumulated so far, y: time, z: emissive intensity, w: sky brightness.
+    // The shaders read the float values with asfloat, so y to w hold the bits of floats.
+    glm::uvec4 OtherInfo;
+};
+
+// Builds the constants for the camera, the world is rotated so the .vox z axis points up
+SceneConstants MakeSceneConstants(Camera& camera, uint32_t frameCount, float time, float emissiveIntensity,
+                                  float skyBrightness);
@@ -0,0 +1,32 @@
+#include "Core/ScratchBatching.h"
+
+#include <algorithm>
+
+std::vector<ScratchBatch> PartitionScratchBatches(std::span<const uint64_t> scratchSizes, uint64_t alignment,
+                                                  uint64_t budget)
+{
+    std::vector<ScratchBatch> batches;
+
+    for (uint32_t i = 0; i < scratchSizes.size(); i++)
+    {
+        const uint64_t size = (scratchSizes[i] + alignment - 1) / alignment * alignment;
+
+        const bool fits = !batches.empty() && (budget == 0 || batches.back().ScratchSize + size <= budget);
+        if (!fits)
+            batches.push_back({.First = i});
+
+        batches.back().Count++;
+        batches.back().ScratchSize += size;
+    }
+
+    return batches;
+}
+
+uint64_t GetPeakScratchSize(std::span<const ScratchBatch> batches)
+{
+    uint64_t peak = 0;
+    for (auto& batch : batches)
+        peak = std::max(peak, batch.ScratchSize);
+
+    return peak;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// A run of consecutive acceleration structure builds that share one scratch allocation
+struct ScratchBatch
+{
+    uint32_t First = 0;
+    uint32_t Count = 0;
+    // Sum of the aligned scratch sizes of the builds in the batch
+    uint64_t ScratchSize = 0;
+};
+
+// Splits the builds into consecutive batches whose aligned scratch sizes add up to at most budget bytes.
+// Each size is rounded up to alignment, so the builds of a batch can be packed back to back in one buffer.
+// A build that needs more than the budget on its own gets a batch of its own. A budget of 0 is unlimited.
+std::vector<ScratchBatch> PartitionScratchBatches(std::span<const uint64_t> scratchSizes, uint64_t alignment,
+                                                  uint64_t budget);
+
+// Largest scratch size of the batches, the size of the allocation they can all share
+uint64_t GetPeakScratchSize(std::span<const ScratchBatch> batches);
@@ -0,0 +1,218 @@
+#include "Core/SlabKernel.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define VOXEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 in functions that ask for it, MSVC always can
+#if defined(VOXEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define VOXEL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define VOXEL_TARGET_AVX2
+#endif
+
+namespace
+{
+    // Same operand order as _mm_min_ps / _mm_max_ps, so every kernel treats NaNs from 0 * inf alike
+    float Min(float a, float b)
+    {
+        return a < b ? a : b;
+    }
+
+    float Max(float a, float b)
+    {
+        return a > b ? a : b;
+    }
+
+    uint32_t IntersectSlabs8Scalar(const SlabRay& ray, const AABBPacket8& boxes, float* outTNear)
+    {
+        uint32_t mask = 0;
+
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            float t0x = (boxes.MinX[i] - ray.Origin.x) * ray.InvDirection.x;
+            float t1x = (boxes.MaxX[i] - ray.Origin.x) * ray.InvDirection.x;
+            float t0y = (boxes.MinY[i] - ray.Origin.y) * ray.InvDirection.y;
+            float t1y = (boxes.MaxY[i] - ray.Origin.y) * ray.InvDirection.y;
+            float t0z = (boxes.MinZ[i] - ray.Origin.z) * ray.InvDirection.z;
+            float t1z = (boxes.MaxZ[i] - ray.Origin.z) * ray.InvDirection.z;
+
+            float tNear = Max(Max(Max(Min(t0x, t1x), Min(t0y, t1y)), Min(t0z, t1z)), ray.TMin);
+            float tFar = Min(Min(Min(Max(t0x, t1x), Max(t0y, t1y)), Max(t0z, t1z)), ray.TMax);
+
+            if (tNear <= tFar)
+            {
+                mask |= 1u << i;
+                outTNear[i] = tNear;
+            }
+        }
+
+        return mask;
+    }
+
+#ifdef VOXEL_X86
+    uint32_t IntersectSlabs8SSE(const SlabRay& ray, const AABBPacket8& boxes, float* outTNear)
+    {
+        const __m128 originX = _mm_set1_ps(ray.Origin.x);
+        const __m128 originY = _mm_set1_ps(ray.Origin.y);
+        const __m128 originZ = _mm_set1_ps(ray.Origin.z);
+        const __m128 invX = _mm_set1_ps(ray.InvDirection.x);
+        const __m128 invY = _mm_set1_ps(ray.InvDirection.y);
+        const __m128 invZ = _mm_set1_ps(ray.InvDirection.z);
+        const __m128 rayTMin = _mm_set1_ps(ray.TMin);
+        const __m128 rayTMax = _mm_set1_ps(ray.TMax);
+
+        uint32_t mask = 0;
+
+        // Two halves of 4 boxes
+        for (uint32_t half = 0; half < 8; half += 4)
+        {
+            __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.MinX + half), originX), invX);
+            __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.MaxX + half), originX), invX);
+            __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.MinY + half), originY), invY);
+            __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.MaxY + half), originY), invY);
+            __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.MinZ + half), originZ), invZ);
+            __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.MaxZ + half), originZ), invZ);
+
+            __m128 tNear = _mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y));
+            tNear = _mm_max_ps(_mm_max_ps(tNear, _mm_min_ps(t0z, t1z)), rayTMin);
+            __m128 tFar = _mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y));
+            tFar = _mm_min_ps(_mm_min_ps(tFar, _mm_max_ps(t0z, t1z)), rayTMax);
+
+            _mm_storeu_ps(outTNear + half, tNear);
+            mask |= (uint32_t)_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)) << half;
+        }
+
+        return mask;
+    }
+
+    VOXEL_TARGET_AVX2 uint32_t IntersectSlabs8AVX2(const SlabRay& ray, const AABBPacket8& boxes, float* outTNear)
+    {
+        const __m256 originX = _mm256_set1_ps(ray.Origin.x);
+        const __m256 originY = _mm256_set1_ps(ray.Origin.y);
+        const __m256 originZ = _mm256_set1_ps(ray.Origin.z);
+        const __m256 invX = _mm256_set1_ps(ray.InvDirection.x);
+        const __m256 invY = _mm256_set1_ps(ray.InvDirection.y);
+        const __m256 invZ = _mm256_set1_ps(ray.InvDirection.z);
+
+        __m256 t0x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(boxes.MinX), originX), invX);
+        __m256 t1x = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(boxes.MaxX), originX), invX);
+        __m256 t0y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(boxes.MinY), originY), invY);
+        __m256 t1y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(boxes.MaxY), originY), invY);
+        __m256 t0z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(boxes.MinZ), originZ), invZ);
+        __m256 t1z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(boxes.MaxZ), originZ), invZ);
+
+        __m256 tNear = _mm256_max_ps(_mm256_min_ps(t0x, t1x), _mm256_min_ps(t0y, t1y));
+        tNear = _mm256_max_ps(_mm256_max_ps(tNear, _mm256_min_ps(t0z, t1z)), _mm256_set1_ps(ray.TMin));
+        __m256 tFar = _mm256_min_ps(_mm256_max_ps(t0x, t1x), _mm256_max_ps(t0y, t1y));
+        tFar = _mm256_min_ps(_mm256_min_ps(tFar, _mm256_max_ps(t0z, t1z)), _mm256_set1_ps(ray.TMax));
+
+        _mm256_storeu_ps(outTNear, tNear);
+        return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ));
+    }
+
+    bool CpuSupportsAVX2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // The OS has to save the YMM registers too
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    SimdLevel DetectSimdLevel()
+    {
+#ifdef VOXEL_X86
+        // SSE2 is part of x86-64, 32 bit builds are assumed to have it too
+        return CpuSupportsAVX2() ? SimdLevel::AVX2 : SimdLevel::SSE;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+} // namespace
+
+SimdLevel GetSupportedSimdLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+SlabKernel GetSlabKernel(SimdLevel level)
+{
+    if ((uint32_t)level > (uint32_t)GetSupportedSimdLevel())
+        level = SimdLevel::Scalar;
+
+#ifdef VOXEL_X86
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return IntersectSlabs8AVX2;
+    case SimdLevel::SSE:
+        return IntersectSlabs8SSE;
+    default:
+        break;
+    }
+#endif
+
+    return IntersectSlabs8Scalar;
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE:
+        return "SSE";
+    default:
+        return "Scalar";
+    }
+}
+
+uint32_t IntersectSlabs8(const SlabRay& ray, const AABBPacket8& boxes, float* outTNear)
+{
+    static const SlabKernel kernel = GetSlabKernel(GetSupportedSimdLevel());
+    return kernel(ray, boxes, outTNear);
+}
+
+void PackAABBs8(std::span<const VoxAABB> aabbs, std::vector<AABBPacket8>& outPackets)
+{
+    for (uint64_t first = 0; first < aabbs.size(); first += 8)
+    {
+        AABBPacket8& packet = outPackets.emplace_back();
+
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            const bool used = first + i < aabbs.size();
+            const glm::vec3 min = used ? aabbs[first + i].Min : glm::vec3(INFINITY);
+            const glm::vec3 max = used ? aabbs[first + i].Max : glm::vec3(INFINITY);
+
+            packet.MinX[i] = min.x;
+            packet.MinY[i] = min.y;
+            packet.MinZ[i] = min.z;
+            packet.MaxX[i] = max.x;
+            packet.MaxY[i] = max.y;
+            packet.MaxZ[i] = max.z;
+        }
+    }
+}
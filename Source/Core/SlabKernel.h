@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Core/Voxel.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// 8 boxes in structure of arrays form, the layout the SIMD slab kernels load from.
+// Unused lanes hold a degenerate box at +inf, every ray misses it: the entry distance on an axis with a positive
+// direction is +inf and the exit distance on an axis with a negative direction is -inf.
+struct alignas(32) AABBPacket8
+{
+    float MinX[8];
+    float MinY[8];
+    float MinZ[8];
+    float MaxX[8];
+    float MaxY[8];
+    float MaxZ[8];
+};
+
+// A ray prepared for the slab test
+struct SlabRay
+{
+    glm::vec3 Origin;
+    glm::vec3 InvDirection;
+    float TMin;
+    float TMax;
+};
+
+enum class SimdLevel
+{
+    Scalar,
+    SSE,
+    AVX2,
+};
+
+// Tests the ray against the 8 boxes like slabs() in Optimized.hlsl, clipped to [TMin, TMax].
+// Returns a mask with bit i set if box i is hit and writes the entry distances of the hit boxes to outTNear.
+using SlabKernel = uint32_t (*)(const SlabRay& ray, const AABBPacket8& boxes, float* outTNear);
+
+// Best level the CPU supports, detected once
+SimdLevel GetSupportedSimdLevel();
+
+// Kernel for the given level, the scalar one if the CPU or the compiler doesn't support it
+SlabKernel GetSlabKernel(SimdLevel level);
+
+const char* GetSimdLevelName(SimdLevel level);
+
+// Tests with the best kernel the CPU supports
+uint32_t IntersectSlabs8(const SlabRay& ray, const AABBPacket8& boxes, float* outTNear);
+
+// Packs the boxes into ceil(n / 8) packets, appended to outPackets
+void PackAABBs8(std::span<const VoxAABB> aabbs, std::vector<AABBPacket8>& outPackets);
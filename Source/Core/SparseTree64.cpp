@@ -0,0 +1,217 @@
+#include "Core/SparseTree64.h"
+#include "Core/MortonOrder.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+SparseTree64 BuildSparseTree64(const VoxelGrid& grid)
+{
+    SparseTree64 tree;
+    tree.Size = grid.Size;
+
+    const uint32_t maxSize = std::max(std::max(grid.Size.x, grid.Size.y), grid.Size.z);
+    tree.NumLevels = 1;
+    while ((1u << (2 * tree.NumLevels)) < maxSize)
+        tree.NumLevels++;
+
+    // Morton code above the color index, sorting them sorts the voxels into the order of the lowest level
+    std::vector<uint64_t> voxels;
+    for (uint32_t z = 0; z < grid.Size.z; z++)
+    {
+        for (uint32_t y = 0; y < grid.Size.y; y++)
+        {
+            for (uint32_t x = 0; x < grid.Size.x; x++)
+            {
+                const uint32_t colorIndex = grid.GetColorIndex({x, y, z});
+                if (colorIndex != 0)
+                    voxels.push_back((uint64_t)MortonCode30({x, y, z}) << 8 | colorIndex);
+            }
+        }
+    }
+
+    if (voxels.empty())
+        return tree;
+
+    std::sort(voxels.begin(), voxels.end());
+
+    std::vector<uint32_t> keys(voxels.size());
+    tree.Colors.resize(voxels.size());
+    for (uint64_t i = 0; i < voxels.size(); i++)
+    {
+        keys[i] = (uint32_t)(voxels[i] >> 8);
+        tree.Colors[i] = (uint8_t)voxels[i];
+    }
+
+    // Every level groups the sorted keys of the level below by their parent, the low 6 bits are the child index.
+    // levels[0] is the lowest level
+    std::vector<std::vector<SparseTree64Node>> levels(tree.NumLevels);
+    for (uint32_t level = 0; level < tree.NumLevels; level++)
+    {
+        std::vector<uint32_t> parentKeys;
+        auto& nodes = levels[level];
+
+        for (uint32_t i = 0; i < keys.size(); i++)
+        {
+            const uint32_t parent = keys[i] >> 6;
+            if (i == 0 || parent != parentKeys.back())
+            {
+                parentKeys.push_back(parent);
+                nodes.push_back({{0, 0}, i});
+            }
+
+            const uint32_t child = keys[i] & 63;
+            nodes.back().ChildMask[child / 32] |= 1u << (child % 32);
+        }
+
+        keys = std::move(parentKeys);
+    }
+
+    assert(levels.back().size() == 1 && "The top level must be the root alone");
+
+    // Root first, the children of every level are offset by where the level below starts
+    std::vector<uint32_t> levelStart(tree.NumLevels);
+    uint32_t numNodes = 0;
+    for (uint32_t level = tree.NumLevels; level-- > 0;)
+    {
+        levelStart[level] = numNodes;
+        numNodes += (uint32_t)levels[level].size();
+    }
+
+    tree.Nodes.reserve(numNodes);
+    for (uint32_t level = tree.NumLevels; level-- > 0;)
+    {
+        for (SparseTree64Node node : levels[level])
+        {
+            if (level > 0)
+                node.FirstChild += levelStart[level - 1];
+            tree.Nodes.push_back(node);
+        }
+    }
+
+    return tree;
+}
+
+std::vector<SparseTree64> BuildSparseTrees64(std::span<const VoxelSceneView::Model> models, ThreadPool& pool)
+{
+    std::vector<SparseTree64> trees(models.size());
+
+    // Models are independent, the grid of a model only lives while its tree is built
+    pool.ParallelFor(models.size(), 1, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++)
+            trees[i] = BuildSparseTree64(BuildVoxelGrid(models[i]));
+    });
+
+    return trees;
+}
+
+bool TraceSparseTree64(const SparseTree64& tree, const glm::vec3& origin, const glm::vec3& direction, float tMin,
+                       float tMax, VoxelGridHit& outHit)
+{
+    if (tree.Nodes.empty())
+        return false;
+
+    // Grid space, voxel v spans [v, v + 1]
+    const glm::vec3 start = origin + 0.5f;
+    const glm::vec3 invDir = 1.0f / direction;
+
+    // Clip the ray to the model like slabs() does. A parallel axis holds the ray like in WalkVoxels, with infinite
+    // distances instead of 0 * inf when the origin lies on a face.
+    glm::vec3 tLow;
+    glm::vec3 tHigh;
+    for (uint32_t a = 0; a < 3; a++)
+    {
+        if (direction[a] == 0.0f)
+        {
+            const bool inside = start[a] >= 0.0f && start[a] < (float)tree.Size[a];
+            tLow[a] = inside ? -INFINITY : INFINITY;
+            tHigh[a] = -tLow[a];
+        }
+        else
+        {
+            const float t0 = -start[a] * invDir[a];
+            const float t1 = ((float)tree.Size[a] - start[a]) * invDir[a];
+            tLow[a] = std::min(t0, t1);
+            tHigh[a] = std::max(t0, t1);
+        }
+    }
+
+    // The ray enters the model through a face of this axis
+    uint32_t axis = tLow.x > tLow.y ? (tLow.x > tLow.z ? 0 : 2) : (tLow.y > tLow.z ? 1 : 2);
+
+    float t = std::max(std::max(std::max(tLow.x, tLow.y), tLow.z), tMin);
+    const float tExit = std::min(std::min(std::min(tHigh.x, tHigh.y), tHigh.z), tMax);
+    if (t > tExit)
+        return false;
+
+    const glm::ivec3 last = glm::ivec3(tree.Size) - 1;
+    glm::ivec3 voxel = glm::clamp(glm::ivec3(glm::floor(start + t * direction)), glm::ivec3(0), last);
+
+    glm::ivec3 step;
+    for (uint32_t a = 0; a < 3; a++)
+        step[a] = invDir[a] >= 0.0f ? 1 : -1;
+
+    while (true)
+    {
+        // Descend to the largest empty cell that holds the voxel, or to the voxel itself
+        uint32_t node = 0;
+        uint32_t cellSize = 0;
+        for (uint32_t level = tree.NumLevels; level-- > 0;)
+        {
+            const uint32_t shift = 2 * level;
+            const uint32_t child = MortonCode30((glm::uvec3(voxel) >> shift) & 3u);
+            const uint64_t mask = tree.Nodes[node].GetChildMask();
+
+            if (!(mask & (1ull << child)))
+            {
+                cellSize = 1u << shift;
+                break;
+            }
+
+            const uint32_t index = tree.Nodes[node].FirstChild + std::popcount(mask & ((1ull << child) - 1));
+            if (level == 0)
+            {
+                outHit.T = t;
+                outHit.Voxel = glm::uvec3(voxel);
+                outHit.Normal = glm::vec3(0.0f);
+                outHit.Normal[axis] = (float)-step[axis];
+                outHit.ColorIndex = tree.Colors[index];
+                return true;
+            }
+
+            node = index;
+        }
+
+        // Leave the empty cell through the face the ray reaches first, the faces of a parallel axis are never reached
+        const glm::ivec3 cellMin = voxel & ~(int32_t)(cellSize - 1);
+
+        glm::vec3 tFace;
+        for (uint32_t a = 0; a < 3; a++)
+        {
+            const int32_t face = step[a] > 0 ? cellMin[a] + (int32_t)cellSize : cellMin[a];
+            tFace[a] = direction[a] == 0.0f ? INFINITY : ((float)face - start[a]) * invDir[a];
+        }
+
+        axis = tFace.x < tFace.y ? (tFace.x < tFace.z ? 0 : 2) : (tFace.y < tFace.z ? 1 : 2);
+        t = std::max(t, tFace[axis]);
+        if (t > tExit)
+            return false;
+
+        // The ray is still inside the cell on the other axes
+        for (uint32_t a = 0; a < 3; a++)
+        {
+            const int32_t inside = (int32_t)std::floor(start[a] + t * direction[a]);
+            voxel[a] = std::clamp(std::clamp(inside, cellMin[a], cellMin[a] + (int32_t)cellSize - 1), 0, last[a]);
+        }
+
+        voxel[axis] = step[axis] > 0 ? cellMin[axis] + (int32_t)cellSize : cellMin[axis] - 1;
+        if (voxel[axis] < 0 || voxel[axis] > last[axis])
+            return false;
+    }
+}
+
+uint64_t GetSparseTree64MemorySize(const SparseTree64& tree)
+{
+    return tree.Nodes.size() * sizeof(SparseTree64Node) + tree.Colors.size();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Core/ThreadPool.h"
+#include "Core/VoxelGrid.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Node of a sparse 64-tree, 12 bytes. A node covers 4x4x4 cells of the level below it, child i is the cell at
+// x0 | y0 << 1 | z0 << 2 | x1 << 3 | y1 << 4 | z1 << 5 with x0 and x1 the low and high bit of its x in the node and
+// so on, the Morton order of the cells.
+struct SparseTree64Node
+{
+    // Bit i is set if child i has filled voxels, split in two words to keep the node at 12 bytes
+    uint32_t ChildMask[2];
+    // The children follow each other from here in mask order. For the nodes of the lowest level the children are
+    // voxels and this indexes the tree's colors instead.
+    uint32_t FirstChild;
+
+    uint64_t GetChildMask() const { return ChildMask[0] | (uint64_t)ChildMask[1] << 32; }
+};
+
+// Sparse 64-tree of one model with all nodes in one array, the root first and every level after the one above it
+struct SparseTree64
+{
+    glm::uvec3 Size = glm::uvec3(0);
+    // Levels of nodes, the root spans 4^NumLevels voxels on each axis
+    uint32_t NumLevels = 0;
+
+    // An empty model has no nodes
+    std::vector<SparseTree64Node> Nodes;
+    // Color index of every filled voxel in Morton order
+    std::vector<uint8_t> Colors;
+};
+
+// Builds the tree bottom up from the filled voxels sorted by their Morton code, so every level is one pass over the
+// level below it in which the children of a node are already next to each other
+SparseTree64 BuildSparseTree64(const VoxelGrid& grid);
+
+// Builds the trees of all models on the pool's threads
+std::vector<SparseTree64> BuildSparseTrees64(std::span<const VoxelSceneView::Model> models, ThreadPool& pool);
+
+// Like TraceVoxelGrid, but whole empty cells of the tree are skipped at once instead of stepping voxel by voxel.
+// The ray is in model space.
+bool TraceSparseTree64(const SparseTree64& tree, const glm::vec3& origin, const glm::vec3& direction, float tMin,
+                       float tMax, VoxelGridHit& outHit);
+
+uint64_t GetSparseTree64MemorySize(const SparseTree64& tree);
@@ -0,0 +1,89 @@
+#include "Core/ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+{
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    mThreads.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; i++)
+        mThreads.emplace_back([this]() { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mMutex);
+        mStopping = true;
+    }
+    mTaskAvailable.notify_all();
+
+    for (auto& thread : mThreads)
+        thread.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(mMutex);
+        mTasks.push_back(std::move(task));
+        mPendingTasks++;
+    }
+    mTaskAvailable.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock lock(mMutex);
+    mTasksDone.wait(lock, [this]() { return mPendingTasks == 0; });
+}
+
+void ThreadPool::ParallelFor(uint64_t count, uint64_t grain, const std::function<void(uint64_t, uint64_t)>& fn)
+{
+    if (count == 0)
+        return;
+
+    // A few chunks per thread so uneven chunks still balance out
+    const uint64_t numChunks = std::max<uint64_t>(1, std::min<uint64_t>(count / std::max<uint64_t>(grain, 1),
+                                                                        (uint64_t)GetThreadCount() * 4));
+    const uint64_t chunkSize = (count + numChunks - 1) / numChunks;
+
+    for (uint64_t begin = 0; begin < count; begin += chunkSize)
+    {
+        const uint64_t end = std::min(count, begin + chunkSize);
+        Submit([&fn, begin, end]() { fn(begin, end); });
+    }
+
+    Wait();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mMutex);
+            mTaskAvailable.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+            if (mTasks.empty())
+                return;
+
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+
+        task();
+
+        bool done = false;
+        {
+            std::lock_guard lock(mMutex);
+            done = --mPendingTasks == 0;
+        }
+
+        if (done)
+            mTasksDone.notify_all();
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads sharing one task queue.
+// Tasks may submit more tasks, Wait() returns once the queue is drained and every task has finished.
+class ThreadPool
+{
+public:
+    // 0 uses one thread per hardware thread
+    explicit ThreadPool(uint32_t numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    void Submit(std::function<void()> task);
+
+    // Blocks until all submitted tasks have finished. Must not be called from a task.
+    void Wait();
+
+    // Splits [0, count) into chunks of at least grain elements, runs fn(begin, end) on each and waits.
+    // Must not be called from a task.
+    void ParallelFor(uint64_t count, uint64_t grain, const std::function<void(uint64_t, uint64_t)>& fn);
+
+    uint32_t GetThreadCount() const { return (uint32_t)mThreads.size(); }
+
+private:
+    void WorkerLoop();
+
+private:
+    std::vector<std::thread> mThreads;
+    std::deque<std::function<void()>> mTasks;
+
+    std::mutex mMutex;
+    std::condition_variable mTaskAvailable;
+    std::condition_variable mTasksDone;
+
+    uint64_t mPendingTasks = 0;
+    bool mStopping = false;
+};
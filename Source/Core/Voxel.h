@@ -0,0 +1,126 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Platform independent voxel types, shared by the D3D12 app and the CPU side tools.
+// The layouts of VoxAABB, VoxPacked and VoxMaterial are mirrored in the shaders, keep them in sync.
+
+struct VoxAABB
+{
+    glm::vec3 Min;
+    glm::vec3 Max;
+    uint32_t ColorIndex;
+    uint32_t Padding;
+};
+
+// Compact shading record of a box on the model's voxel grid, 8 bytes instead of the 32 of VoxAABB.
+// Position: x | y << 8 | z << 16 | ColorIndex << 24, Extent: (w - 1) | (h - 1) << 8 | (d - 1) << 16
+// .vox models are at most 256 voxels on each axis, so every box of a model fits.
+// Unmerged voxels are unit cubes, for them only the 4 byte Position is stored.
+struct VoxPacked
+{
+    uint32_t Position;
+    uint32_t Extent;
+};
+
+inline VoxPacked PackVoxAABB(const VoxAABB& aabb)
+{
+    // Boxes span [x - 0.5, x + w - 0.5] on each axis
+    const glm::uvec3 position = glm::uvec3(aabb.Min + 0.5f);
+    const glm::uvec3 extent = glm::uvec3(aabb.Max - aabb.Min + 0.5f) - 1u;
+
+    return VoxPacked {
+        .Position = position.x | position.y << 8 | position.z << 16 | aabb.ColorIndex << 24,
+        .Extent = extent.x | extent.y << 8 | extent.z << 16,
+    };
+}
+
+inline VoxAABB UnpackVoxAABB(const VoxPacked& packed)
+{
+    const glm::uvec3 position = glm::uvec3(packed.Position, packed.Position >> 8, packed.Position >> 16) & 0xFFu;
+    const glm::uvec3 extent = glm::uvec3(packed.Extent, packed.Extent >> 8, packed.Extent >> 16) & 0xFFu;
+
+    return VoxAABB {
+        .Min = glm::vec3(position) - 0.5f,
+        .Max = glm::vec3(position + extent) + 0.5f,
+        .ColorIndex = packed.Position >> 24,
+        .Padding = 0,
+    };
+}
+
+struct VoxMaterial
+{
+    uint32_t Color;
+    float Emissive;
+};
+
+// The AABBs of one .vox model, shared by every instance of it
+struct VoxelModel
+{
+    glm::vec3 Size;
+    std::vector<VoxAABB> AABBs;
+};
+
+struct VoxelInstance
+{
+    // Index into the scene's unique models
+    uint32_t ModelIndex;
+    // Row major object to world transform, the layout of D3D12_RAYTRACING_INSTANCE_DESC::Transform
+    glm::mat3x4 Transform;
+};
+
+// Order of the AABBs within a model's array
+enum class VoxelOrder
+{
+    // As extracted, x fastest then y then z
+    Linear,
+    // Sorted along a Z-order curve by their centers
+    Morton,
+    // Sorted along a Hilbert curve by their centers
+    Hilbert,
+};
+
+// Options for turning .vox models into AABBs, read from config.toml
+struct VoxelLoadSettings
+{
+    // Coalesce voxels of the same color into larger boxes
+    bool MergeVoxels = false;
+
+    // Drop voxels that are fully enclosed by their neighbours
+    bool CullInteriorVoxels = false;
+
+    // Order the boxes of every model are stored and uploaded in, the BLAS builds and the primitive fetches in the
+    // shaders both work on neighbouring boxes when they are close in memory
+    VoxelOrder AABBOrder = VoxelOrder::Linear;
+
+    // Threads used for the extraction, 0 uses all hardware threads
+    uint32_t NumThreads = 0;
+
+    // Load and store the extracted scene in a binary cache next to the .vox file
+    bool UseSceneCache = false;
+
+    // Shade from 8 byte VoxPacked records, the float AABBs only exist until the BLAS are built
+    bool CompactVoxels = false;
+
+    // Build the BLAS with ALLOW_COMPACTION and compact them after the build, ignored by the CPU tools
+    bool CompactBLAS = false;
+
+    // Upper bound of the scratch memory shared by the BLAS builds in bytes, 0 builds them all at once.
+    // Ignored by the CPU tools.
+    uint64_t ScratchBudget = 0;
+
+    // Upload a voxel grid per model and build its BLAS from the model's bounds alone, for Shaders/DDA.hlsl.
+    // Ignored by the CPU tools.
+    bool VoxelGrids = false;
+
+    // Upload the occupied 8x8x8 bricks of every model into one pool and build the BLAS from one AABB per brick, for
+    // Shaders/Brickmap.hlsl. Ignored by the CPU tools.
+    bool Bricks = false;
+
+    // Build a sparse 64-tree of every model on load and report its size, only the CPU traverses them so far.
+    // Ignored by the CPU tools.
+    bool SparseTrees = false;
+};
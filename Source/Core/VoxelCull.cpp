@@ -0,0 +1,39 @@
+#include "Core/VoxelCull.h"
+
+uint64_t FindInteriorVoxels(const uint8_t* voxels, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ,
+                            const VoxMaterial* palette, std::vector<bool>& outInterior)
+{
+    const uint64_t sliceSize = (uint64_t)sizeX * sizeY;
+
+    outInterior.assign(sliceSize * sizeZ, false);
+
+    uint64_t numCulled = 0;
+
+    // Border voxels are never interior, so only the inner part of the grid needs to be visited
+    for (uint32_t z = 1; z + 1 < sizeZ; z++)
+    {
+        for (uint32_t y = 1; y + 1 < sizeY; y++)
+        {
+            for (uint32_t x = 1; x + 1 < sizeX; x++)
+            {
+                const uint64_t index = x + y * sizeX + z * sliceSize;
+                const uint8_t color = voxels[index];
+
+                if (color == 0 || palette[color].Emissive > 0.0f)
+                    continue;
+
+                const bool occluded = voxels[index - 1] != 0 && voxels[index + 1] != 0 &&
+                                      voxels[index - sizeX] != 0 && voxels[index + sizeX] != 0 &&
+                                      voxels[index - sliceSize] != 0 && voxels[index + sliceSize] != 0;
+
+                if (occluded)
+                {
+                    outInterior[index] = true;
+                    numCulled++;
+                }
+            }
+        }
+    }
+
+    return numCulled;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Core/Voxel.h"
+
+// Finds the solid voxels that can never be hit by a ray: all six face neighbours are solid and inside the model.
+// Voxels on the model border are always kept since other instances don't occlude them, and so are voxels with an
+// emissive material, the renderer treats those as light sources.
+// outInterior is resized to the grid size and is true for every culled voxel. Returns the number of culled voxels.
+uint64_t FindInteriorVoxels(const uint8_t* voxels, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ,
+                            const VoxMaterial* palette, std::vector<bool>& outInterior);
@@ -0,0 +1,269 @@
+#include "Core/VoxelExtract.h"
+#include "Core/VoxelMerge.h"
+#include "Core/VoxelCull.h"
+#include "Core/MappedFile.h"
+#include "Core/MortonOrder.h"
+#include "Core/Profiler.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#define OGT_VOX_IMPLEMENTATION
+#include "ogt_vox.h"
+
+namespace
+{
+    // Target amount of grid cells per slab task, small models end up as a single slab
+    constexpr uint64_t SlabCellCount = 1 << 18;
+
+    struct ModelJob
+    {
+        const ogt_vox_model* Model = nullptr;
+        VoxelModel* Output = nullptr;
+
+        std::vector<bool> Interior;
+        uint64_t NumCulled = 0;
+        VoxelMergeStats MergeStats;
+
+        uint32_t SlabDepth = 0;
+        std::vector<uint64_t> SlabOffsets;
+    };
+
+    struct SlabJob
+    {
+        ModelJob* Job;
+        uint32_t Slab;
+    };
+
+    bool IsVisible(const ModelJob& job, uint64_t index)
+    {
+        return job.Model->voxel_data[index] != 0 && (job.Interior.empty() || !job.Interior[index]);
+    }
+
+    // Counts the visible voxels in a slab or writes their AABBs starting at outAABBs
+    uint64_t ProcessSlab(const ModelJob& job, uint32_t slab, VoxAABB* outAABBs)
+    {
+        const ogt_vox_model* model = job.Model;
+        const uint32_t sizeX = model->size_x;
+        const uint32_t sizeY = model->size_y;
+
+        const uint32_t zBegin = slab * job.SlabDepth;
+        const uint32_t zEnd = std::min(model->size_z, zBegin + job.SlabDepth);
+
+        uint64_t count = 0;
+        for (uint32_t z = zBegin; z < zEnd; z++)
+        {
+            for (uint32_t y = 0; y < sizeY; y++)
+            {
+                for (uint32_t x = 0; x < sizeX; x++)
+                {
+                    const uint64_t index = x + y * sizeX + (uint64_t)z * sizeX * sizeY;
+                    if (!IsVisible(job, index))
+                        continue;
+
+                    if (outAABBs != nullptr)
+                    {
+                        const float voxSize = 0.5;
+
+                        glm::vec3 mid = glm::vec3(x, y, z);
+
+                        VoxAABB& aabb = outAABBs[count];
+                        aabb.ColorIndex = model->voxel_data[index];
+                        aabb.Padding = 0;
+                        aabb.Max = mid + glm::vec3(voxSize);
+                        aabb.Min = mid - glm::vec3(voxSize);
+                    }
+
+                    count++;
+                }
+            }
+        }
+
+        return count;
+    }
+} // namespace
+
+VoxelSceneView MakeSceneView(const VoxelSceneData& scene)
+{
+    VoxelSceneView view;
+    view.Palette = scene.Palette;
+    view.Instances = scene.Instances;
+    view.NumVoxels = scene.NumVoxels;
+    view.NumAABBs = scene.NumAABBs;
+    view.NumCulledVoxels = scene.NumCulledVoxels;
+
+    view.Models.reserve(scene.Models.size());
+    for (auto& model : scene.Models)
+        view.Models.push_back({model.Size, model.AABBs});
+
+    return view;
+}
+
+const ogt_vox_scene* ReadVoxScene(const std::string& voxFile)
+{
+    MappedFile rawVox;
+    if (!rawVox.Open(voxFile))
+        return nullptr;
+
+    auto data = rawVox.GetData();
+    return ogt_vox_read_scene(data.data(), (uint32_t)data.size());
+}
+
+void ExtractVoxelModels(const ogt_vox_scene* voxScene, const VoxelLoadSettings& settings, ThreadPool& pool,
+                        VoxelSceneData& outScene)
+{
+    PROFILE_ZONE("ExtractVoxelModels");
+
+    outScene.Palette.resize(256);
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        // Type punning
+        outScene.Palette[i].Color = *(uint32_t*)&voxScene->palette.color[i];
+        outScene.Palette[i].Emissive = voxScene->materials.matl[i].emit;
+    }
+
+    // Map the .vox model indices to the models actually used by instances
+    std::vector<uint32_t> uniqueIndices(voxScene->num_models, UINT32_MAX);
+    std::vector<uint32_t> usedModels;
+
+    outScene.Instances.resize(voxScene->num_instances);
+
+    for (uint32_t i = 0; i < voxScene->num_instances; i++)
+    {
+        auto& instance = voxScene->instances[i];
+        auto& model = voxScene->models[instance.model_index];
+        auto& group = voxScene->groups[instance.group_index];
+
+        if (uniqueIndices[instance.model_index] == UINT32_MAX)
+        {
+            uniqueIndices[instance.model_index] = (uint32_t)usedModels.size();
+            usedModels.push_back(instance.model_index);
+        }
+
+        VoxelInstance& voxelInstance = outScene.Instances[i];
+        voxelInstance.ModelIndex = uniqueIndices[instance.model_index];
+
+        glm::mat4 instanceTransform = glm::make_mat4(&instance.transform.m00);
+        glm::mat4 groupTransform = glm::make_mat4(&group.transform.m00);
+
+        glm::mat4 modelTransform = instanceTransform * groupTransform;
+
+        glm::vec3 trans = -glm::vec3(model->size_x / 2.0, model->size_y / 2.0, model->size_z / 2.0);
+
+        modelTransform = glm::translate(modelTransform, trans);
+        voxelInstance.Transform = glm::transpose(modelTransform);
+    }
+
+    outScene.Models.resize(usedModels.size());
+    std::vector<ModelJob> jobs(usedModels.size());
+
+    for (uint32_t i = 0; i < usedModels.size(); i++)
+    {
+        auto& model = voxScene->models[usedModels[i]];
+
+        outScene.Models[i].Size = glm::vec3(model->size_x, model->size_y, model->size_z);
+
+        jobs[i].Model = model;
+        jobs[i].Output = &outScene.Models[i];
+    }
+
+    // Culling and merging work on whole models
+    for (auto& job : jobs)
+    {
+        pool.Submit([&job, &settings, &outScene]() {
+            PROFILE_ZONE("CullAndMergeModel");
+            const ogt_vox_model* model = job.Model;
+
+            if (settings.CullInteriorVoxels)
+            {
+                job.NumCulled = FindInteriorVoxels(model->voxel_data, model->size_x, model->size_y, model->size_z,
+                                                   outScene.Palette.data(), job.Interior);
+            }
+
+            if (settings.MergeVoxels)
+            {
+                const std::vector<bool>* pInterior = settings.CullInteriorVoxels ? &job.Interior : nullptr;
+                MergeVoxels(model->voxel_data, model->size_x, model->size_y, model->size_z, job.Output->AABBs,
+                            job.MergeStats, pInterior);
+                assert(ValidateMergedVoxels(model->voxel_data, model->size_x, model->size_y, model->size_z,
+                                            job.Output->AABBs, pInterior));
+            }
+        });
+    }
+    pool.Wait();
+
+    // Everything else is emitted one voxel per AABB, split into slabs along z
+    std::vector<SlabJob> slabs;
+    if (!settings.MergeVoxels)
+    {
+        for (auto& job : jobs)
+        {
+            const uint64_t sliceSize = (uint64_t)job.Model->size_x * job.Model->size_y;
+            job.SlabDepth = (uint32_t)std::clamp<uint64_t>(SlabCellCount / sliceSize, 1, job.Model->size_z);
+
+            const uint32_t numSlabs = (job.Model->size_z + job.SlabDepth - 1) / job.SlabDepth;
+            job.SlabOffsets.resize(numSlabs + 1, 0);
+
+            for (uint32_t s = 0; s < numSlabs; s++)
+                slabs.push_back({&job, s});
+        }
+
+        // Count pass, the counts are stored one slot ahead so the prefix sum turns them into offsets
+        for (auto& slab : slabs)
+        {
+            pool.Submit([slab]() {
+                PROFILE_ZONE("CountSlab");
+                slab.Job->SlabOffsets[slab.Slab + 1] = ProcessSlab(*slab.Job, slab.Slab, nullptr);
+            });
+        }
+        pool.Wait();
+
+        for (auto& job : jobs)
+        {
+            for (uint64_t s = 1; s < job.SlabOffsets.size(); s++)
+                job.SlabOffsets[s] += job.SlabOffsets[s - 1];
+
+            job.Output->AABBs.resize(job.SlabOffsets.back());
+        }
+
+        // Fill pass
+        for (auto& slab : slabs)
+        {
+            pool.Submit([slab]() {
+                PROFILE_ZONE("FillSlab");
+                VoxAABB* out = slab.Job->Output->AABBs.data() + slab.Job->SlabOffsets[slab.Slab];
+                ProcessSlab(*slab.Job, slab.Slab, out);
+            });
+        }
+        pool.Wait();
+    }
+
+    // Each sort is parallel on its own, so the models go one after the other
+    if (settings.AABBOrder != VoxelOrder::Linear)
+    {
+        PROFILE_ZONE("ReorderAABBs");
+        for (auto& model : outScene.Models)
+            ReorderAABBs(model.AABBs, settings.AABBOrder, pool);
+    }
+
+    for (auto& job : jobs)
+    {
+        outScene.NumCulledVoxels += job.NumCulled;
+        outScene.NumVoxels += job.NumCulled;
+
+        if (settings.MergeVoxels)
+        {
+            outScene.NumVoxels += job.MergeStats.VoxelsIn;
+            outScene.NumAABBs += job.MergeStats.BoxesOut;
+        }
+        else
+        {
+            outScene.NumVoxels += job.Output->AABBs.size();
+            outScene.NumAABBs += job.Output->AABBs.size();
+        }
+    }
+}
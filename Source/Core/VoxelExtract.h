@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Core/Voxel.h"
+#include "Core/ThreadPool.h"
+
+#include <span>
+#include <string>
+
+struct ogt_vox_scene;
+
+// CPU side result of turning a .vox scene into AABBs, before anything is uploaded to the GPU
+struct VoxelSceneData
+{
+    std::vector<VoxMaterial> Palette;
+
+    // One entry per model that is referenced by an instance
+    std::vector<VoxelModel> Models;
+    std::vector<VoxelInstance> Instances;
+
+    uint64_t NumVoxels = 0;
+    uint64_t NumAABBs = 0;
+    uint64_t NumCulledVoxels = 0;
+};
+
+// Read only view of a scene that is ready to be uploaded. It either points into a VoxelSceneData or into a
+// memory mapped scene cache, see SceneCache.h
+struct VoxelSceneView
+{
+    struct Model
+    {
+        glm::vec3 Size;
+        std::span<const VoxAABB> AABBs;
+    };
+
+    std::span<const VoxMaterial> Palette;
+    std::vector<Model> Models;
+    std::span<const VoxelInstance> Instances;
+
+    uint64_t NumVoxels = 0;
+    uint64_t NumAABBs = 0;
+    uint64_t NumCulledVoxels = 0;
+};
+
+// The view is only valid as long as the scene data is alive
+VoxelSceneView MakeSceneView(const VoxelSceneData& scene);
+
+// Reads and parses a .vox file, the returned scene must be freed with ogt_vox_destroy_scene
+const ogt_vox_scene* ReadVoxScene(const std::string& voxFile);
+
+// Extracts the AABBs of every model used by the scene's instances using the threads of the pool.
+// Each model is extracted once no matter how many instances reference it.
+// Models are processed in parallel and large models are additionally split into z slabs. The AABBs are counted
+// first, so every model's array is sized exactly once before it is filled.
+void ExtractVoxelModels(const ogt_vox_scene* voxScene, const VoxelLoadSettings& settings, ThreadPool& pool,
+                        VoxelSceneData& outScene);
@@ -0,0 +1,56 @@
+#include "Core/VoxelGrid.h"
+
+#include <cstring>
+
+VoxelGrid BuildVoxelGrid(const VoxelSceneView::Model& model)
+{
+    VoxelGrid grid;
+    grid.Size = glm::uvec3(model.Size);
+
+    const uint64_t numVoxels = (uint64_t)grid.Size.x * grid.Size.y * grid.Size.z;
+    grid.Words.resize((numVoxels + 3) / 4);
+
+    for (auto& aabb : model.AABBs)
+    {
+        // Boxes span [x - 0.5, x + w - 0.5] on each axis, see PackVoxAABB
+        const glm::uvec3 first = glm::uvec3(aabb.Min + 0.5f);
+        const glm::uvec3 last = glm::min(glm::uvec3(aabb.Max + 0.5f), grid.Size);
+
+        for (uint32_t z = first.z; z < last.z; z++)
+        {
+            for (uint32_t y = first.y; y < last.y; y++)
+            {
+                for (uint32_t x = first.x; x < last.x; x++)
+                {
+                    const uint64_t index = x + (uint64_t)y * grid.Size.x + (uint64_t)z * grid.Size.x * grid.Size.y;
+                    grid.Words[index / 4] |= (aabb.ColorIndex & 0xFF) << (8 * (index % 4));
+                }
+            }
+        }
+    }
+
+    return grid;
+}
+
+bool TraceVoxelGrid(const VoxelGrid& grid, const glm::vec3& origin, const glm::vec3& direction, float tMin,
+                    float tMax, VoxelGridHit& outHit)
+{
+    if (grid.Words.empty())
+        return false;
+
+    // Grid space, voxel v spans [v, v + 1]
+    return WalkVoxels(grid.Size, origin + 0.5f, direction, tMin, tMax,
+                      [&](const glm::uvec3& voxel) { return grid.GetColorIndex(voxel); }, outHit);
+}
+
+uint64_t GetVoxelGridBufferSize(const VoxelGrid& grid)
+{
+    return (1 + grid.Words.size()) * sizeof(uint32_t);
+}
+
+void WriteVoxelGridBuffer(const VoxelGrid& grid, uint32_t* outBuffer)
+{
+    const glm::uvec3 last = grid.Size - 1u;
+    outBuffer[0] = last.x | last.y << 8 | last.z << 16;
+    memcpy(outBuffer + 1, grid.Words.data(), grid.Words.size() * sizeof(uint32_t));
+}
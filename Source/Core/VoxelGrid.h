@@ -0,0 +1,129 @@
+#pragma once
+
+#include "Core/VoxelExtract.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Dense grid of one model's voxels, the layout of ogt_vox's voxel_data: x + y * sx + z * sx * sy.
+// Voxel v spans [v - 0.5, v + 0.5] in model space like its AABB, so the grid spans [-0.5, Size - 0.5].
+// Every voxel is its color index in one byte, 0 is empty. Four voxels are packed into each word.
+struct VoxelGrid
+{
+    glm::uvec3 Size = glm::uvec3(0);
+    std::vector<uint32_t> Words;
+
+    uint32_t GetColorIndex(const glm::uvec3& voxel) const
+    {
+        const uint64_t index = voxel.x + (uint64_t)voxel.y * Size.x + (uint64_t)voxel.z * Size.x * Size.y;
+        return (Words[index / 4] >> (8 * (index % 4))) & 0xFF;
+    }
+};
+
+struct VoxelGridHit
+{
+    // Distance along the ray to where it enters the voxel
+    float T;
+    glm::uvec3 Voxel;
+    // Model space normal of the face the ray enters through
+    glm::vec3 Normal;
+    uint32_t ColorIndex;
+};
+
+// Walks the voxels of a size sized grid that the ray passes in order with 3D-DDA (Amanatides and Woo) and returns the
+// first one within [tMin, tMax] for which getColorIndex isn't 0. The origin is in grid space where voxel v spans
+// [v, v + 1]. The direction doesn't have to be normalized, T is in units of it like RayTCurrent().
+template <typename GetColorIndex>
+bool WalkVoxels(const glm::uvec3& size, const glm::vec3& origin, const glm::vec3& direction, float tMin, float tMax,
+                const GetColorIndex& getColorIndex, VoxelGridHit& outHit)
+{
+    const glm::vec3 invDir = 1.0f / direction;
+
+    // Clip the ray to the grid like slabs() does. An axis the ray is parallel to holds it from 0 up to but excluding
+    // the size, its distances are infinite instead of 0 * inf when the origin lies on a face.
+    glm::vec3 tLow;
+    glm::vec3 tHigh;
+    for (uint32_t a = 0; a < 3; a++)
+    {
+        if (direction[a] == 0.0f)
+        {
+            const bool inside = origin[a] >= 0.0f && origin[a] < (float)size[a];
+            tLow[a] = inside ? -INFINITY : INFINITY;
+            tHigh[a] = -tLow[a];
+        }
+        else
+        {
+            const float t0 = -origin[a] * invDir[a];
+            const float t1 = ((float)size[a] - origin[a]) * invDir[a];
+            tLow[a] = std::min(t0, t1);
+            tHigh[a] = std::max(t0, t1);
+        }
+    }
+
+    // The ray enters the grid through a face of this axis
+    uint32_t axis = tLow.x > tLow.y ? (tLow.x > tLow.z ? 0 : 2) : (tLow.y > tLow.z ? 1 : 2);
+
+    float t = std::max(std::max(std::max(tLow.x, tLow.y), tLow.z), tMin);
+    const float tExit = std::min(std::min(std::min(tHigh.x, tHigh.y), tHigh.z), tMax);
+    if (t > tExit)
+        return false;
+
+    glm::ivec3 voxel = glm::clamp(glm::ivec3(glm::floor(origin + t * direction)), glm::ivec3(0), glm::ivec3(size) - 1);
+
+    // Axes the ray is parallel to are never crossed, the sign of the inverse keeps -0 directions from stepping
+    // towards a boundary at -inf
+    glm::ivec3 step;
+    glm::vec3 tNext;
+    for (uint32_t a = 0; a < 3; a++)
+    {
+        step[a] = invDir[a] >= 0.0f ? 1 : -1;
+        tNext[a] = direction[a] == 0.0f ? INFINITY
+                                        : ((float)voxel[a] + (step[a] > 0 ? 1.0f : 0.0f) - origin[a]) * invDir[a];
+    }
+    const glm::vec3 tDelta = glm::abs(invDir);
+
+    while (true)
+    {
+        const uint32_t colorIndex = getColorIndex(glm::uvec3(voxel));
+        if (colorIndex != 0)
+        {
+            outHit.T = t;
+            outHit.Voxel = glm::uvec3(voxel);
+            outHit.Normal = glm::vec3(0.0f);
+            outHit.Normal[axis] = (float)-step[axis];
+            outHit.ColorIndex = colorIndex;
+            return true;
+        }
+
+        // Step into the neighbour behind the closest boundary
+        axis = tNext.x < tNext.y ? (tNext.x < tNext.z ? 0 : 2) : (tNext.y < tNext.z ? 1 : 2);
+        t = tNext[axis];
+        if (t > tExit)
+            return false;
+
+        voxel[axis] += step[axis];
+        if (voxel[axis] < 0 || voxel[axis] >= (int32_t)size[axis])
+            return false;
+
+        tNext[axis] += tDelta[axis];
+    }
+}
+
+// Fills a grid from the model's boxes, merged boxes fill every voxel they cover.
+// Culled interior voxels stay empty, a ray always stops at the surface before it could reach them.
+VoxelGrid BuildVoxelGrid(const VoxelSceneView::Model& model);
+
+// WalkVoxels over the grid with the ray in model space, mirrors isect() in Shaders/DDA.hlsl
+bool TraceVoxelGrid(const VoxelGrid& grid, const glm::vec3& origin, const glm::vec3& direction, float tMin,
+                    float tMax, VoxelGridHit& outHit);
+
+// The grid as the shaders read it: the first word holds the size minus one, 8 bits per axis, the voxel words follow.
+// .vox models are at most 256 voxels on each axis, so the size always fits.
+uint64_t GetVoxelGridBufferSize(const VoxelGrid& grid);
+
+void WriteVoxelGridBuffer(const VoxelGrid& grid, uint32_t* outBuffer);
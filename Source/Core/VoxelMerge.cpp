@@ -0,0 +1,143 @@
+#include "Core/VoxelMerge.h"
+
+#include <cmath>
+
+void MergeVoxels(const uint8_t* voxels, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ,
+                 std::vector<VoxAABB>& outAABBs, VoxelMergeStats& stats, const std::vector<bool>* interior)
+{
+    const uint64_t sliceSize = (uint64_t)sizeX * sizeY;
+
+    // Voxels that are already part of a box
+    std::vector<bool> merged(sliceSize * sizeZ, false);
+
+    auto isInterior = [&](uint64_t index) { return interior != nullptr && (*interior)[index]; };
+
+    auto canMerge = [&](uint64_t index, uint8_t color) {
+        return isInterior(index) || (voxels[index] == color && !merged[index]);
+    };
+
+    for (uint32_t z = 0; z < sizeZ; z++)
+    {
+        for (uint32_t y = 0; y < sizeY; y++)
+        {
+            for (uint32_t x = 0; x < sizeX; x++)
+            {
+                const uint64_t start = x + y * sizeX + z * sliceSize;
+                const uint8_t color = voxels[start];
+
+                if (color == 0 || merged[start] || isInterior(start))
+                    continue;
+
+                // Grow along x
+                uint32_t w = 1;
+                while (x + w < sizeX && canMerge(start + w, color))
+                    w++;
+
+                // Grow along y while the whole row matches
+                uint32_t h = 1;
+                while (y + h < sizeY)
+                {
+                    const uint64_t row = start + h * sizeX;
+                    bool rowMatches = true;
+                    for (uint32_t i = 0; i < w && rowMatches; i++)
+                        rowMatches = canMerge(row + i, color);
+
+                    if (!rowMatches)
+                        break;
+                    h++;
+                }
+
+                // Grow along z while the whole slab matches
+                uint32_t d = 1;
+                while (z + d < sizeZ)
+                {
+                    const uint64_t slab = start + d * sliceSize;
+                    bool slabMatches = true;
+                    for (uint32_t j = 0; j < h && slabMatches; j++)
+                    {
+                        for (uint32_t i = 0; i < w && slabMatches; i++)
+                            slabMatches = canMerge(slab + j * sizeX + i, color);
+                    }
+
+                    if (!slabMatches)
+                        break;
+                    d++;
+                }
+
+                uint64_t numVisible = 0;
+                for (uint32_t k = 0; k < d; k++)
+                {
+                    for (uint32_t j = 0; j < h; j++)
+                    {
+                        const uint64_t row = start + k * sliceSize + j * sizeX;
+                        for (uint32_t i = 0; i < w; i++)
+                        {
+                            merged[row + i] = true;
+                            numVisible += isInterior(row + i) ? 0 : 1;
+                        }
+                    }
+                }
+
+                const float voxSize = 0.5;
+
+                auto& aabb = outAABBs.emplace_back();
+                aabb.ColorIndex = color;
+                aabb.Padding = 0;
+                aabb.Min = glm::vec3(x, y, z) - glm::vec3(voxSize);
+                aabb.Max = glm::vec3(x + w - 1, y + h - 1, z + d - 1) + glm::vec3(voxSize);
+
+                stats.VoxelsIn += numVisible;
+                stats.BoxesOut++;
+            }
+        }
+    }
+}
+
+bool ValidateMergedVoxels(const uint8_t* voxels, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ,
+                          const std::vector<VoxAABB>& aabbs, const std::vector<bool>* interior)
+{
+    const uint64_t sliceSize = (uint64_t)sizeX * sizeY;
+
+    // Rasterize the boxes back into a grid, overlaps are an error
+    std::vector<uint8_t> covered(sliceSize * sizeZ, 0);
+
+    for (const auto& aabb : aabbs)
+    {
+        const glm::vec3 min = aabb.Min + glm::vec3(0.5f);
+        const glm::vec3 max = aabb.Max - glm::vec3(0.5f);
+
+        if (min.x < 0.0f || min.y < 0.0f || min.z < 0.0f || max.x >= sizeX || max.y >= sizeY || max.z >= sizeZ)
+            return false;
+
+        for (uint32_t z = (uint32_t)std::lround(min.z); z <= (uint32_t)std::lround(max.z); z++)
+        {
+            for (uint32_t y = (uint32_t)std::lround(min.y); y <= (uint32_t)std::lround(max.y); y++)
+            {
+                for (uint32_t x = (uint32_t)std::lround(min.x); x <= (uint32_t)std::lround(max.x); x++)
+                {
+                    const uint64_t index = x + y * sizeX + z * sliceSize;
+                    if (voxels[index] == 0)
+                        return false;
+
+                    if (interior != nullptr && (*interior)[index])
+                        continue;
+
+                    if (covered[index] != 0 || voxels[index] != aabb.ColorIndex)
+                        return false;
+
+                    covered[index] = (uint8_t)aabb.ColorIndex;
+                }
+            }
+        }
+    }
+
+    // Every visible voxel must have been covered
+    for (uint64_t i = 0; i < covered.size(); i++)
+    {
+        const bool skip = interior != nullptr && (*interior)[i];
+        if (!skip && covered[i] != voxels[i])
+            return false;
+    }
+
+    return true;
+}
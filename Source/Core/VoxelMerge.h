@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Core/Voxel.h"
+
+struct VoxelMergeStats
+{
+    uint64_t VoxelsIn = 0;
+    uint64_t BoxesOut = 0;
+};
+
+// Greedily coalesces voxels of the same color index into maximal axis aligned boxes.
+// The grid is indexed x + y * sizeX + z * sizeX * sizeY like ogt_vox_model::voxel_data, 0 is empty.
+// Boxes are first grown along x, then the whole row along y and then the whole slab along z.
+// The output boxes use the same convention as the per voxel AABBs, voxel centers lie on integer coordinates.
+// Voxels flagged in interior (see FindInteriorVoxels) are invisible, they never start a box but any box may grow
+// through them, which lets culled models still merge into large boxes. VoxelsIn only counts the visible voxels.
+void MergeVoxels(const uint8_t* voxels, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ,
+                 std::vector<VoxAABB>& outAABBs, VoxelMergeStats& stats, const std::vector<bool>* interior = nullptr);
+
+// Checks that the boxes cover every visible voxel exactly once with the right color and no empty voxel.
+// Interior voxels may be covered by any number of boxes.
+bool ValidateMergedVoxels(const uint8_t* voxels, uint32_t sizeX, uint32_t sizeY, uint32_t sizeZ,
+                          const std::vector<VoxAABB>& aabbs, const std::vector<bool>* interior = nullptr);
@@ -1,8 +1,13 @@
 #pragma once
 
-#include "Common.h"
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
+#include <string>
+#include <vector>
 
+// Copies the whole file into outVector, the last element is zero padded if the file size is not a multiple of T.
+// Large files that are only read once should use MappedFile instead.
 template<typename T>
 bool FileRead(const std::string& filePath, std::vector<T>& outVector)
 {
@@ -19,7 +24,7 @@ bool FileRead(const std::string& filePath, std::vector<T>& outVector)
 
 	size_t fileSize = (size_t)file.tellg();
 	
-	uint32_t outVectorSize = 0;
+	size_t outVectorSize = 0;
 
 	// if the file size is not a multiple of the size of the type, we need to add one to the size of the vector,
 	// so in the case of a vector of uint32_t, if the file size is 5 bytes we need a vector of size 2 of uint32_t, which is 8 bytes
@@ -29,7 +34,7 @@ bool FileRead(const std::string& filePath, std::vector<T>& outVector)
 	else
 		outVectorSize = fileSize / sizeof(T);
 
-	outVector.resize(fileSize / sizeof(T));
+	outVector.resize(outVectorSize);
 
 		
 
@@ -1,5 +1,6 @@
 #include "ShaderCompiler.h"
 #include "FileRead.h"
+#include "Core/Profiler.h"
 #include <filesystem>
 #include <algorithm>
 
@@ -10,7 +11,8 @@ ShaderCompiler::ShaderCompiler()
     mUtils->CreateDefaultIncludeHandler(&mIncludeHandler);
 }
 
-ComPtr<IDxcBlob> ShaderCompiler::CompileFromSource(const std::vector<char>& source)
+ComPtr<IDxcBlob> ShaderCompiler::CompileFromSource(const std::vector<char>& source,
+                                                   const std::vector<std::wstring>& defines)
 {
     ComPtr<IDxcBlobEncoding> pSource;
     mUtils->CreateBlob(source.data(), source.size(), CP_UTF8, &pSource);
@@ -26,6 +28,12 @@ ComPtr<IDxcBlob> ShaderCompiler::CompileFromSource(const std::vector<char>& sour
 
     arguments.push_back(L"-enable-16bit-types");
 
+    for (auto& define : defines)
+    {
+        arguments.push_back(L"-D");
+        arguments.push_back(define.c_str());
+    }
+
     DxcBuffer sourceBuffer;
     sourceBuffer.Ptr = pSource->GetBufferPointer();
     sourceBuffer.Size = pSource->GetBufferSize();
@@ -56,11 +64,13 @@ ComPtr<IDxcBlob> ShaderCompiler::CompileFromSource(const std::vector<char>& sour
     return pDxil;
 }
 
-ComPtr<IDxcBlob> ShaderCompiler::CompileFromFile(const std::string& file)
+ComPtr<IDxcBlob> ShaderCompiler::CompileFromFile(const std::string& file, const std::vector<std::wstring>& defines)
 {
+    PROFILE_ZONE("CompileShader");
+
     std::vector<char> shaderCode;
     FileRead(file, shaderCode);
-    return CompileFromSource(shaderCode);
+    return CompileFromSource(shaderCode, defines);
 }
 
 ShaderCompiler::~ShaderCompiler()
@@ -10,8 +10,9 @@ public:
 
     ~ShaderCompiler();
 
-    ComPtr<IDxcBlob> CompileFromSource(const std::vector<char>& source);
-    ComPtr<IDxcBlob> CompileFromFile(const std::string& file);
+    // Defines are passed to DXC as -D, e.g. L"COMPACT_VOXELS" or L"NAME=1"
+    ComPtr<IDxcBlob> CompileFromSource(const std::vector<char>& source, const std::vector<std::wstring>& defines = {});
+    ComPtr<IDxcBlob> CompileFromFile(const std::string& file, const std::vector<std::wstring>& defines = {});
 private:
 
     ComPtr<IDxcUtils> mUtils;
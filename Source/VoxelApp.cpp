@@ -1,173 +1,590 @@
 #include "VoxelApp.h"
 #include "Common.h"
-#include "FileRead.h"
 #include "ogt_vox.h"
 #include "toml++/toml.hpp"
+#include "Core/VoxelExtract.h"
+#include "Core/SceneCache.h"
+#include "Core/MappedFile.h"
+#include "Core/VoxelGrid.h"
+#include "Core/Brickmap.h"
+#include "Core/SparseTree64.h"
+#include "Core/MortonOrder.h"
+#include "Core/ImageWriter.h"
+#include "Core/BenchmarkStats.h"
+#include "Core/Profiler.h"
+
+#include <filesystem>
+
+// Sum of the scene's GPU allocations that are currently alive
+static uint64_t GetResidentMemory(const VoxelScene& scene)
+{
+    uint64_t total = 0;
+    auto add = [&](const ComPtr<DMA::Allocation>& allocation) {
+        if (allocation != nullptr)
+            total += allocation->GetSize();
+    };
+
+    for (auto& buffer : scene.ModelBuffers)
+        add(buffer);
+    for (auto& buffer : scene.BuildInputBuffers)
+        add(buffer);
+    for (auto& blas : scene.BLAS)
+        add(blas);
+
+    add(scene.InstanceBuffer);
+    add(scene.ColorBuffer);
+    add(scene.TLAS);
+    add(scene.ScratchBufferBLAS);
+    add(scene.ScratchBufferTLAS);
+    add(scene.CompactedSizeBuffer);
+
+    return total;
+}
+
+// Uploads the bricks and their colors as the only two model buffers, Shaders/Brickmap.hlsl reads them at 4 and 5
+static void UploadBrickPools(DXR::Device& device, VoxelScene& scene, const std::vector<Brick>& bricks,
+                             std::vector<uint8_t>& colors)
+{
+    // The shaders read the colors four to a word
+    colors.resize(DXR_ALIGN(colors.size(), sizeof(uint32_t)));
+
+    auto upload = [&](const void* data, uint64_t size, uint64_t stride) {
+        auto desc = CD3DX12_RESOURCE_DESC::Buffer(size, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+        auto& buffer = scene.ModelBuffers.emplace_back(
+            device.AllocateResource(desc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_GPU_UPLOAD));
+        memcpy(device.MapAllocationForWrite(buffer), data, size);
+        scene.BuffersMemoryConsumption += buffer->GetSize();
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Buffer.FirstElement = 0;
+        srvDesc.Buffer.NumElements = size / stride;
+        srvDesc.Buffer.StructureByteStride = stride;
+        srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+        scene.AABBViews.push_back(srvDesc);
+    };
 
-std::shared_ptr<VoxelScene> LoadAsAABBs(std::shared_ptr<DXR::Device> device, const std::string& voxFile)
+    upload(bricks.data(), bricks.size() * sizeof(Brick), sizeof(Brick));
+    upload(colors.data(), colors.size(), sizeof(uint32_t));
+}
+
+std::shared_ptr<VoxelScene> LoadAsAABBs(std::shared_ptr<DXR::Device> device, const std::string& voxFile,
+                                        const VoxelLoadSettings& settings)
 {
     auto scene = std::make_shared<VoxelScene>();
 
-    std::vector<uint8_t> rawVox;
-    FileRead(voxFile, rawVox);
-    auto voxScene = ogt_vox_read_scene(rawVox.data(), rawVox.size());
-    rawVox.clear();
+    ProfileZone loadZone("LoadScene");
 
-    // Color Buffer for the voxels
-    auto colorBufferDesc =
-        CD3DX12_RESOURCE_DESC::Buffer(256 * sizeof(VoxMaterial), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-    scene->ColorBuffer =
-        device->AllocateResource(colorBufferDesc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_GPU_UPLOAD);
+    // Map the files instead of copying them, city scenes are hundreds of MB
+    MappedFile rawVox;
+    if (!rawVox.Open(voxFile))
+    {
+        std::cout << "Failed to open the scene " << voxFile << std::endl;
+        return nullptr;
+    }
+    auto voxData = rawVox.GetData();
 
-    // copy the colors to the buffer
-    VoxMaterial* colors = (VoxMaterial*)device->MapAllocationForWrite(scene->ColorBuffer);
-    for (uint32_t i = 0; i < 256; i++)
+    // The cache is keyed on the contents of the .vox, a full pass over the file that is only needed when the cache is
+    // read or written
+    const uint64_t sourceHash = settings.UseSceneCache ? HashBytes(voxData.data(), voxData.size()) : 0;
+    const std::string cacheFile = GetSceneCachePath(voxFile);
+
+    VoxelSceneData sceneData;
+    VoxelSceneView sceneView;
+    MappedFile cacheData;
+
+    if (settings.UseSceneCache && std::filesystem::exists(cacheFile))
     {
-        // Type punning
-        colors[i].Color = *(uint32_t*)&voxScene->palette.color[i];
-        colors[i].Emissive = voxScene->materials.matl[i].emit;
+        scene->LoadedFromCache =
+            cacheData.Open(cacheFile) && OpenSceneCache(cacheData.GetData(), sourceHash, settings, sceneView);
     }
 
-    std::vector<VoxelModel> models;
-    // Keep track of the total size needed for the buffer
-    for (uint32_t i = 0; i < voxScene->num_instances; i++)
+    if (!scene->LoadedFromCache)
     {
-        auto& instance = voxScene->instances[i];
-        auto& model = voxScene->models[instance.model_index];
-        auto& group = voxScene->groups[instance.group_index];
+        // A stale cache is rewritten below, it cannot be replaced while mapped on Windows
+        cacheData.Close();
+
+        const ogt_vox_scene* voxScene = nullptr;
+        {
+            PROFILE_ZONE("ParseVox");
+            voxScene = ogt_vox_read_scene(voxData.data(), (uint32_t)voxData.size());
+        }
 
-        VoxelModel& voxelModel = models.emplace_back();
+        if (voxScene == nullptr)
+        {
+            std::cout << "Failed to read the scene " << voxFile << std::endl;
+            return nullptr;
+        }
+
+        // Extract the AABBs on the CPU
+        {
+            ThreadPool pool(settings.NumThreads);
+            ExtractVoxelModels(voxScene, settings, pool, sceneData);
+        }
 
-        glm::mat4 instanceTransform = glm::make_mat4(&instance.transform.m00);
-        glm::mat4 groupTransform = glm::make_mat4(&group.transform.m00);
+        ogt_vox_destroy_scene(voxScene);
 
-        glm::mat4 modelTransform = instanceTransform * groupTransform;
+        sceneView = MakeSceneView(sceneData);
 
-        const uint32_t sizeX = model->size_x;
-        const uint32_t sizeY = model->size_y;
-        const uint32_t sizeZ = model->size_z;
+        if (settings.UseSceneCache && !WriteSceneCache(cacheFile, sourceHash, settings, sceneView))
+            std::cout << "Failed to write scene cache: " << cacheFile << std::endl;
+    }
 
-        voxelModel.Size = glm::vec3(sizeX, sizeY, sizeZ);
+    rawVox.Close();
 
-        glm::vec3 trans = -glm::vec3(sizeX / 2.0, sizeY / 2.0, sizeZ / 2.0);
+    scene->NumVoxels = sceneView.NumVoxels;
+    scene->NumAABBs = sceneView.NumAABBs;
+    scene->NumCulledVoxels = sceneView.NumCulledVoxels;
+    scene->NumModels = sceneView.Models.size();
+    scene->NumInstances = sceneView.Instances.size();
 
-        modelTransform = glm::translate(modelTransform, trans);
-        voxelModel.Transform = glm::transpose(modelTransform);
+    if (settings.SparseTrees)
+    {
+        ProfileZone treeZone("BuildSparseTrees");
 
-        // Iterate over the voxels in the model
-        for (uint32_t x = 0; x < sizeX; x++)
+        ThreadPool pool(settings.NumThreads);
+        for (auto& tree : BuildSparseTrees64(sceneView.Models, pool))
         {
-            for (uint32_t y = 0; y < sizeY; y++)
-            {
-                for (uint32_t z = 0; z < sizeZ; z++)
-                {
-                    uint8_t color = model->voxel_data[x + y * sizeX + z * sizeX * sizeY];
-                    if (color != 0)
-                    {
-                        const float voxSize = 0.5;
-
-                        glm::vec3 mid = glm::vec3(x, y, z);
-
-                        auto& aabb = voxelModel.AABBs.emplace_back();
-                        aabb.ColorIndex = color;
-                        aabb.Max = mid + glm::vec3(voxSize);
-                        aabb.Min = mid - glm::vec3(voxSize);
-
-                        scene->NumVoxels++;
-                    }
-                }
-            }
+            scene->NumSparseTreeNodes += tree.Nodes.size();
+            scene->NumSparseTreeVoxels += tree.Colors.size();
+            scene->SparseTreeMemoryConsumption += GetSparseTree64MemorySize(tree);
         }
+
+        scene->SparseTreeBuildTime = treeZone.GetElapsedMs();
     }
 
+    // Color Buffer for the voxels
+    auto colorBufferDesc =
+        CD3DX12_RESOURCE_DESC::Buffer(256 * sizeof(VoxMaterial), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    scene->ColorBuffer =
+        device->AllocateResource(colorBufferDesc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_GPU_UPLOAD);
+
+    // copy the colors to the buffer
+    VoxMaterial* colors = (VoxMaterial*)device->MapAllocationForWrite(scene->ColorBuffer);
+    memcpy(colors, sceneView.Palette.data(), sceneView.Palette.size() * sizeof(VoxMaterial));
+
+    auto& models = sceneView.Models;
+
+    // The bricks of all models share one pool
+    std::vector<Brick> brickPool;
+    std::vector<uint8_t> brickColorPool;
+
+    // One AABB buffer and BLAS per unique model, instances share them
     for (auto& model : models)
     {
-        // All the AABBs for the model
-        auto allocDesc = CD3DX12_RESOURCE_DESC::Buffer(model.AABBs.size() * sizeof(VoxAABB),
+        PROFILE_ZONE("UploadModel");
+
+        Brickmap brickmap;
+        if (settings.Bricks)
+            brickmap = BuildBrickmap(BuildVoxelGrid(model));
+
+        // All the AABBs for the model, only its bounds when the shaders walk a voxel grid or the bounds of its bricks.
+        // Outside of the default mode they only feed the BLAS build, the shaders read packed voxels, the grid or the
+        // bricks instead
+        const bool buildInputOnly = settings.CompactVoxels || settings.VoxelGrids || settings.Bricks;
+        const uint64_t numBuildAABBs = settings.VoxelGrids ? 1
+                                       : settings.Bricks   ? brickmap.Bounds.size()
+                                                           : model.AABBs.size();
+        const uint64_t aabbStride = buildInputOnly ? sizeof(D3D12_RAYTRACING_AABB) : sizeof(VoxAABB);
+        auto allocDesc = CD3DX12_RESOURCE_DESC::Buffer(numBuildAABBs * aabbStride,
                                                        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-        auto& modelBuffer = scene->ModelBuffers.emplace_back(
-            device->AllocateResource(allocDesc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_GPU_UPLOAD));
-
-        scene->BuffersMemoryConsumption += modelBuffer->GetSize();
+        auto aabbBuffer =
+            device->AllocateResource(allocDesc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_GPU_UPLOAD);
 
-        uint8_t* aabbs = (uint8_t*)device->MapAllocationForWrite(modelBuffer);
-        uint64_t gpuAddress = modelBuffer->GetResource()->GetGPUVirtualAddress();
+        uint8_t* aabbs = (uint8_t*)device->MapAllocationForWrite(aabbBuffer);
+        uint64_t gpuAddress = aabbBuffer->GetResource()->GetGPUVirtualAddress();
 
         auto& blas = scene->BLASDescs.emplace_back();
+        if (settings.CompactBLAS)
+            blas.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
         blas.Geometries.push_back(D3D12_RAYTRACING_GEOMETRY_DESC {
             .Type = D3D12_RAYTRACING_GEOMETRY_TYPE_PROCEDURAL_PRIMITIVE_AABBS,
             .Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE,
             .AABBs =
                 D3D12_RAYTRACING_GEOMETRY_AABBS_DESC {
-                    .AABBCount = model.AABBs.size(),
+                    .AABBCount = numBuildAABBs,
                     .AABBs = D3D12_GPU_VIRTUAL_ADDRESS_AND_STRIDE {.StartAddress = gpuAddress,
-                                                                   .StrideInBytes = sizeof(VoxAABB)}},
+                                                                   .StrideInBytes = aabbStride}},
         });
 
-        memcpy(aabbs, model.AABBs.data(), model.AABBs.size() * sizeof(VoxAABB));
+        scene->NumBLASAABBs += numBuildAABBs;
+
+        uint64_t shadingStride = sizeof(VoxAABB);
+        uint64_t numShadingElements = model.AABBs.size();
+
+        // Without merging every box is a unit cube, so the extent doesn't need to be stored
+        const bool unitVoxels = settings.CompactVoxels && !settings.MergeVoxels;
+
+        if (settings.VoxelGrids)
+        {
+            // The grid spans the model's voxels, see VoxelGrid.h
+            const glm::vec3 max = model.Size - 0.5f;
+            *(D3D12_RAYTRACING_AABB*)aabbs = {-0.5f, -0.5f, -0.5f, max.x, max.y, max.z};
+
+            scene->BuildInputMemoryConsumption += aabbBuffer->GetSize();
+            scene->BuildInputBuffers.push_back(aabbBuffer);
+
+            const VoxelGrid grid = BuildVoxelGrid(model);
+            shadingStride = sizeof(uint32_t);
+            numShadingElements = GetVoxelGridBufferSize(grid) / sizeof(uint32_t);
+
+            auto gridDesc = CD3DX12_RESOURCE_DESC::Buffer(GetVoxelGridBufferSize(grid),
+                                                          D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            auto& modelBuffer = scene->ModelBuffers.emplace_back(
+                device->AllocateResource(gridDesc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_GPU_UPLOAD));
+            WriteVoxelGridBuffer(grid, (uint32_t*)device->MapAllocationForWrite(modelBuffer));
+
+            scene->BuffersMemoryConsumption += modelBuffer->GetSize();
+        }
+        else if (settings.Bricks)
+        {
+            D3D12_RAYTRACING_AABB* buildAABBs = (D3D12_RAYTRACING_AABB*)aabbs;
+            for (uint64_t i = 0; i < brickmap.Bounds.size(); i++)
+            {
+                auto& bounds = brickmap.Bounds[i];
+                buildAABBs[i] = {bounds.Min.x, bounds.Min.y, bounds.Min.z, bounds.Max.x, bounds.Max.y, bounds.Max.z};
+            }
+
+            scene->BuildInputMemoryConsumption += aabbBuffer->GetSize();
+            scene->BuildInputBuffers.push_back(aabbBuffer);
+
+            // The primitive index of a brick is its index in the model, the instances point at the first one
+            scene->FirstBricks.push_back((uint32_t)brickPool.size());
+
+            const uint32_t firstColor = (uint32_t)brickColorPool.size();
+            for (Brick brick : brickmap.Bricks)
+            {
+                brick.FirstColor += firstColor;
+                brickPool.push_back(brick);
+            }
+            brickColorPool.insert(brickColorPool.end(), brickmap.Colors.begin(), brickmap.Colors.end());
+        }
+        else if (settings.CompactVoxels)
+        {
+            D3D12_RAYTRACING_AABB* buildAABBs = (D3D12_RAYTRACING_AABB*)aabbs;
+            for (uint64_t i = 0; i < model.AABBs.size(); i++)
+            {
+                auto& aabb = model.AABBs[i];
+                buildAABBs[i] = {aabb.Min.x, aabb.Min.y, aabb.Min.z, aabb.Max.x, aabb.Max.y, aabb.Max.z};
+            }
+
+            scene->BuildInputMemoryConsumption += aabbBuffer->GetSize();
+            scene->BuildInputBuffers.push_back(aabbBuffer);
+
+            // Packed voxels for the shaders
+            shadingStride = unitVoxels ? sizeof(uint32_t) : sizeof(VoxPacked);
+            auto packedDesc = CD3DX12_RESOURCE_DESC::Buffer(model.AABBs.size() * shadingStride,
+                                                            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            auto& modelBuffer = scene->ModelBuffers.emplace_back(
+                device->AllocateResource(packedDesc, D3D12_RESOURCE_STATE_COMMON, D3D12_HEAP_TYPE_GPU_UPLOAD));
+
+            if (unitVoxels)
+            {
+                uint32_t* positions = (uint32_t*)device->MapAllocationForWrite(modelBuffer);
+                for (uint64_t i = 0; i < model.AABBs.size(); i++)
+                    positions[i] = PackVoxAABB(model.AABBs[i]).Position;
+            }
+            else
+            {
+                VoxPacked* packed = (VoxPacked*)device->MapAllocationForWrite(modelBuffer);
+                for (uint64_t i = 0; i < model.AABBs.size(); i++)
+                    packed[i] = PackVoxAABB(model.AABBs[i]);
+            }
+
+            scene->BuffersMemoryConsumption += modelBuffer->GetSize();
+        }
+        else
+        {
+            memcpy(aabbs, model.AABBs.data(), model.AABBs.size() * sizeof(VoxAABB));
+
+            scene->BuffersMemoryConsumption += aabbBuffer->GetSize();
+            scene->ModelBuffers.push_back(aabbBuffer);
+        }
 
         // Create the BLAS
-        auto& allocBLAS = scene->BLAS.emplace_back(device->AllocateAccelerationStructure(blas));
-        scene->ASMemoryConsumption += allocBLAS->GetSize();
+        {
+            PROFILE_ZONE("AllocateBLAS");
+            auto& allocBLAS = scene->BLAS.emplace_back(device->AllocateAccelerationStructure(blas));
+            scene->ASMemoryConsumption += allocBLAS->GetSize();
+        }
+
+        // The pools get their views once every model is in them
+        if (settings.Bricks)
+            continue;
 
         // SRV for the AABB buffer
         D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
         srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
         srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
         srvDesc.Buffer.FirstElement = 0;
-        srvDesc.Buffer.NumElements = model.AABBs.size();
-        srvDesc.Buffer.StructureByteStride = sizeof(VoxAABB);
+        srvDesc.Buffer.NumElements = numShadingElements;
+        srvDesc.Buffer.StructureByteStride = shadingStride;
         srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
 
         scene->AABBViews.push_back(srvDesc);
     }
 
-    // Create TLAS for the models
-    scene->InstanceBuffer = device->AllocateInstanceBuffer(models.size(), D3D12_HEAP_TYPE_GPU_UPLOAD);
+    if (settings.Bricks)
+    {
+        // The instance ID only has 24 bits
+        if (brickPool.size() >= (1 << 24))
+        {
+            std::cout << "Too many bricks for the instance IDs to address (" << brickPool.size() << ") in the scene "
+                      << voxFile << std::endl;
+            return nullptr;
+        }
+
+        scene->NumBricks = brickPool.size();
+        UploadBrickPools(*device, *scene, brickPool, brickColorPool);
+    }
+
+    // Written by the BLAS builds, the instances are updated to the compacted BLAS before the TLAS is built
+    if (settings.CompactBLAS)
+        scene->CompactedSizeBuffer = device->AllocateAndAssignCompactedSizeBuffer(scene->BLASDescs);
+
+    auto& voxelInstances = sceneView.Instances;
+    scene->InstanceModels.reserve(voxelInstances.size());
+
+    // Create TLAS for the instances
+    scene->InstanceBuffer = device->AllocateInstanceBuffer(voxelInstances.size(), D3D12_HEAP_TYPE_GPU_UPLOAD);
     D3D12_RAYTRACING_INSTANCE_DESC* instances =
         (D3D12_RAYTRACING_INSTANCE_DESC*)device->MapAllocationForWrite(scene->InstanceBuffer);
 
     // Create the instances
-    for (uint32_t i = 0; i < models.size(); i++)
+    for (uint32_t i = 0; i < voxelInstances.size(); i++)
     {
-        auto& model = models[i];
+        auto& instance = voxelInstances[i];
+        scene->InstanceModels.push_back(instance.ModelIndex);
 
-        instances[i].InstanceID = i; // this is the buffer index
+        // The shaders use the instance ID to find the AABB buffer of the instance's model, or its first brick
+        instances[i].InstanceID = settings.Bricks ? scene->FirstBricks[instance.ModelIndex] : instance.ModelIndex;
         instances[i].InstanceContributionToHitGroupIndex = 0;
         instances[i].InstanceMask = 0xFF;
         instances[i].Flags = D3D12_RAYTRACING_INSTANCE_FLAG_FORCE_OPAQUE;
-        instances[i].AccelerationStructure = scene->BLAS[i]->GetResource()->GetGPUVirtualAddress();
-        memcpy(instances[i].Transform, glm::value_ptr(model.Transform), sizeof(FLOAT) * 12);
+        instances[i].AccelerationStructure = scene->BLAS[instance.ModelIndex]->GetResource()->GetGPUVirtualAddress();
+        memcpy(instances[i].Transform, glm::value_ptr(instance.Transform), sizeof(FLOAT) * 12);
     }
 
     scene->InstanceBuffer->GetResource()->Unmap(0, nullptr);
 
     // Create the TLAS
-    scene->TLASDesc.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-    scene->TLASDesc.vpInstanceDescs = scene->InstanceBuffer->GetResource()->GetGPUVirtualAddress();
-    scene->TLASDesc.NumInstanceDescs = models.size();
+    {
+        PROFILE_ZONE("AllocateTLAS");
 
-    scene->TLAS = device->AllocateAccelerationStructure(scene->TLASDesc);
-    scene->ASMemoryConsumption += scene->TLAS->GetSize();
+        scene->TLASDesc.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+        scene->TLASDesc.vpInstanceDescs = scene->InstanceBuffer->GetResource()->GetGPUVirtualAddress();
+        scene->TLASDesc.NumInstanceDescs = voxelInstances.size();
 
-    // Scratch buffer for BLAS
-    scene->ScratchBufferBLAS = device->AllocateAndAssignScratchBuffer(scene->BLASDescs);
+        scene->TLAS = device->AllocateAccelerationStructure(scene->TLASDesc);
+        scene->ASMemoryConsumption += scene->TLAS->GetSize();
+    }
 
-    // Scratch buffer for TLAS
-    scene->ScratchBufferTLAS = device->AllocateAndAssignScratchBuffer(scene->TLASDesc);
+    {
+        PROFILE_ZONE("AllocateScratch");
+
+        // Scratch buffer for BLAS
+        // The builds are split into batches within the scratch budget, they are assigned their scratch when recorded
+        std::vector<uint64_t> scratchSizes;
+        scratchSizes.reserve(scene->BLASDescs.size());
+        for (auto& blasDesc : scene->BLASDescs)
+            scratchSizes.push_back(blasDesc.GetScratchBufferSize());
+
+        scene->BLASBatches = PartitionScratchBatches(
+            scratchSizes, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT, settings.ScratchBudget);
+        scene->UnbatchedScratchSize = device->GetRequiredScratchBufferSize(scene->BLASDescs);
+        scene->ScratchBufferBLAS = device->AllocateScratchBuffer(GetPeakScratchSize(scene->BLASBatches));
+
+        // Scratch buffer for TLAS
+        scene->ScratchBufferTLAS = device->AllocateAndAssignScratchBuffer(scene->TLASDesc);
+    }
 
-    ogt_vox_destroy_scene(voxScene);
+    scene->LoadTime = loadZone.GetElapsedMs();
 
     return scene;
 }
 
+// Statistics of all allocations of the device's allocator that are currently alive
+static DMA::Statistics GetAllocationStatistics(DXR::Device& device)
+{
+    DMA::TotalStatistics statistics = {};
+    device.GetAllocator()->CalculateStatistics(&statistics);
+    return statistics.Total.Stats;
+}
+
+// Every combination of the matrix's scenes, shader files and resolutions. Lists that are missing or empty use the
+// single run's scene, shader file or resolution.
+static std::vector<BenchmarkRun> MakeBenchmarkRuns(toml::node_view<toml::node> matrix, const BenchmarkRun& single)
+{
+    auto readStrings = [&](std::string_view key, const std::string& fallback) {
+        std::vector<std::string> values;
+        if (auto* array = matrix[key].as_array())
+        {
+            for (auto& value : *array)
+            {
+                if (auto* string = value.as_string())
+                    values.push_back(string->get());
+            }
+        }
+        if (values.empty())
+            values.push_back(fallback);
+        return values;
+    };
+
+    const std::vector<std::string> scenes = readStrings("scenes", single.Scene);
+    const std::vector<std::string> shaderFiles = readStrings("shader_files", single.ShaderFile);
+
+    std::vector<std::pair<UINT32, UINT32>> resolutions;
+    if (auto* array = matrix["resolutions"].as_array())
+    {
+        for (auto& value : *array)
+        {
+            auto* resolution = value.as_array();
+            if (resolution == nullptr || resolution->size() != 2)
+                continue;
+
+            const UINT32 width = (*resolution)[0].value_or(0);
+            const UINT32 height = (*resolution)[1].value_or(0);
+            if (width != 0 && height != 0)
+                resolutions.emplace_back(width, height);
+        }
+    }
+    if (resolutions.empty())
+        resolutions.emplace_back(single.Width, single.Height);
+
+    std::vector<BenchmarkRun> runs;
+    for (auto& scene : scenes)
+    {
+        for (auto& shaderFile : shaderFiles)
+        {
+            for (auto [width, height] : resolutions)
+            {
+                const std::string name =
+                    scene + "-" + shaderFile + "-" + std::to_string(width) + "x" + std::to_string(height);
+                runs.push_back({scene, shaderFile, width, height, name});
+            }
+        }
+    }
+
+    return runs;
+}
+
 void AxisAlignedIntersection::Start()
 {
     auto config = toml::parse_file("Data/config.toml");
 
+    mLoadSettings.MergeVoxels = config["merge_voxels"].value_or(false);
+    mLoadSettings.CullInteriorVoxels = config["cull_interior_voxels"].value_or(false);
+    mLoadSettings.AABBOrder = ParseVoxelOrder(config["voxel_order"].value_or(""));
+    mLoadSettings.NumThreads = config["loader_threads"].value_or(0);
+    mLoadSettings.UseSceneCache = config["scene_cache"].value_or(false);
+    mLoadSettings.CompactVoxels = config["compact_voxels"].value_or(false);
+    mLoadSettings.CompactBLAS = config["compact_blas"].value_or(false);
+    mLoadSettings.ScratchBudget = (uint64_t)config["scratch_budget_mb"].value_or(0) * 1024 * 1024;
+    mLoadSettings.SparseTrees = config["sparse_trees"].value_or(false);
+
+    mReleaseBuildBuffers = config["release_build_buffers"].value_or(false);
+
+    mBenchmarkFrameCount = config["benchmark_frames"].value_or(UINT16_MAX);
+    mBenchmarkWarmupFrames = config["benchmark_warmup_frames"].value_or(0);
+
+    std::string_view cameraPath = config["camera_path"].value_or("none");
+    if (cameraPath == "play")
+        mCameraPathSetting = CameraPathMode::Play;
+    else if (cameraPath == "record")
+        mCameraPathSetting = CameraPathMode::Record;
+
+    BenchmarkRun single;
+    single.Scene = config["scene"].value_or("");
+    single.ShaderFile = config["shader_file"].value_or("");
+    single.Width = mWidth;
+    single.Height = mHeight;
+    single.Name = single.Scene + "-" + single.ShaderFile;
+
+    if (config["matrix"]["enabled"].value_or(false))
+        mRuns = MakeBenchmarkRuns(config["matrix"], single);
+    else
+        mRuns = {single};
+
+    // Get the timestamp frequency
+    UINT64 frequency;
+    THROW_IF_FAILED(mCommandQueue->GetTimestampFrequency(&frequency));
+    mTimestampFrequency = frequency;
+
+    // One slot of timestamps per frame in flight, the build timestamps after them
+    mTimestampRing = QueryRing(mFrameContext.GetNumFramesInFlight(), NumFrameTimestamps);
+
+    D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = mTimestampRing.GetNumQueries() + NumBuildTimestamps;
+    THROW_IF_FAILED(mDXDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&mTimestampHeap)));
+
+    auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(queryHeapDesc.Count * sizeof(UINT64));
+    mTimestampReadback =
+        mDevice->AllocateResource(readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_READBACK);
+
+    // Readback buffers may stay mapped while the GPU writes them, the CPU only reads slots it has waited for
+    const D3D12_RANGE readRange = {0, readbackDesc.Width};
+    THROW_IF_FAILED(mTimestampReadback->GetResource()->Map(0, &readRange, (void**)&mTimestamps));
+
+    mRunIndex = 0;
+    StartNextRun();
+}
+
+void AxisAlignedIntersection::StartNextRun()
+{
+    for (; mRunIndex < mRuns.size(); mRunIndex++)
+    {
+        if (StartRun(mRuns[mRunIndex]))
+            return;
+    }
+
+    RequestStop();
+}
+
+bool AxisAlignedIntersection::StartRun(const BenchmarkRun& run)
+{
+    PROFILE_ZONE("StartRun");
+
+    if (mRuns.size() > 1)
+        std::cout << "Run " << mRunIndex + 1 << "/" << mRuns.size() << ": " << run.Name << std::endl;
+
+    // Only headless runs change the resolution, the swapchain keeps the window's
+    if (run.Width != mWidth || run.Height != mHeight)
+        CreateOutputImages(run.Width, run.Height);
+
+    // Everything allocated from here on belongs to the run
+    mAllocationsBeforeRun = GetAllocationStatistics(*mDevice);
+
+    // The DDA shader walks a voxel grid per model instead of intersecting the voxel AABBs, the brickmap shader walks
+    // 8x8x8 bricks
+    const bool voxelGrids = run.ShaderFile == "DDA";
+    const bool bricks = run.ShaderFile == "Brickmap";
+    const bool compactVoxels = mLoadSettings.CompactVoxels;
+
+    // The scene is loaded first, a run whose scene fails to load has nothing to release
+    VoxelLoadSettings loadSettings = mLoadSettings;
+    loadSettings.VoxelGrids = voxelGrids;
+    loadSettings.Bricks = bricks;
+
+    mScene = LoadAsAABBs(mDevice, "Data/" + run.Scene + ".vox", loadSettings);
+    if (mScene == nullptr)
+    {
+        std::cout << "Skipping run " << run.Name << std::endl;
+        return false;
+    }
+
     // Create the pipeline
-    std::string_view file = config["shader_file"].value_or("");
-    auto dxil = mShaderCompiler.CompileFromFile("Shaders/" + std::string(file) + ".hlsl");
+    std::vector<std::wstring> shaderDefines;
+    if (compactVoxels)
+        shaderDefines.push_back(L"COMPACT_VOXELS");
+    if (compactVoxels && !mLoadSettings.MergeVoxels)
+        shaderDefines.push_back(L"UNIT_VOXELS");
+    if (mLoadSettings.MergeVoxels)
+        shaderDefines.push_back(L"MERGE_VOXELS");
+
+    auto dxil = mShaderCompiler.CompileFromFile("Shaders/" + run.ShaderFile + ".hlsl", shaderDefines);
     assert(dxil != nullptr);
     CD3DX12_SHADER_BYTECODE dxilCode {dxil->GetBufferPointer(), dxil->GetBufferSize()};
 
@@ -197,14 +614,12 @@ void AxisAlignedIntersection::Start()
 
     mDevice->CreateShaderTable(mShaderTable, D3D12_HEAP_TYPE_GPU_UPLOAD, mPipeline);
 
-    // Create AS
+    // Camera and performance file of the scene
     {
-        std::string_view scene = config["scene"].value_or("");
-        mScene = LoadAsAABBs(mDevice, "Data/" + std::string(scene) + ".vox");
-        mBenchmarkFrameCount = config["benchmark_frames"].value_or(UINT16_MAX);
+        mPerformanceData.clear();
         mPerformanceData.reserve(mBenchmarkFrameCount);
 
-        auto sceneConfig = toml::parse_file("Data/" + std::string(scene) + ".toml");
+        auto sceneConfig = toml::parse_file("Data/" + run.Scene + ".toml");
 
         mSceneLightIntensity = sceneConfig["Scene"]["light_intensity"].value_or(1.0);
         mSkyBrightness = sceneConfig["Scene"]["sky_brightness"].value_or(1.0);
@@ -220,52 +635,67 @@ void AxisAlignedIntersection::Start()
         mCamera.SetRotation(pitch, yaw, roll);
         mCamera.Speed = sceneConfig["Camera"]["speed"].value_or(25.0);
 
+        // The scene's camera path, played back from the first benchmark frame on or recorded until the app closes
+        mCameraPath = CameraPath();
+        mCameraPathMode = CameraPathMode::None;
+        mCameraPathFile = "Data/" + run.Scene + ".campath";
+        if (mCameraPathSetting == CameraPathMode::Play)
+        {
+            if (ReadCameraPath(mCameraPathFile, mCameraPath) && !mCameraPath.Keyframes.empty())
+            {
+                mCameraPathMode = CameraPathMode::Play;
+                std::cout << "Camera Path: " << mCameraPath.Keyframes.size() << " keyframes from " << mCameraPathFile
+                          << std::endl;
+            }
+            else
+            {
+                std::cout << "Failed to read the camera path " << mCameraPathFile << ", using the scene's camera"
+                          << std::endl;
+            }
+        }
+        else if (mCameraPathSetting == CameraPathMode::Record)
+        {
+            mCameraPathMode = CameraPathMode::Record;
+        }
+
         // Performance File
         // Write the header to the file
-        mPerformanceFile.open(std::string(scene) + "-" + std::string(file) + ".csv", std::ios::out);
-        mPerformanceFile << "Frame,FrameTime" << std::endl;
+        mSceneName = run.Scene;
+        mShaderFile = run.ShaderFile;
+        mRunName = run.Name;
+        mPerformanceFile.open(mRunName + ".csv", std::ios::out);
+        mPerformanceFile << "Frame,FrameTime,DispatchRaysTime,CopyTime" << std::endl;
     }
 
+    std::cout << "Scene Load Time: " << mScene->LoadTime << " ms" << (mScene->LoadedFromCache ? " (cached)" : "")
+              << std::endl;
+    std::cout << "Number of Models: " << mScene->NumModels << " unique, " << mScene->NumInstances << " instanced"
+              << std::endl;
     std::cout << "Number of Voxels: " << mScene->NumVoxels << std::endl;
-    std::cout << "Acceleration Structure Memory Consumption: " << mScene->ASMemoryConsumption << " Bytes" << std::endl;
-    std::cout << "Buffers Memory Consumption: " << mScene->BuffersMemoryConsumption << " Bytes" << std::endl;
-
-    // Build the acceleration structures
-    THROW_IF_FAILED(mCommandAllocators[mBackBufferIndex]->Reset());
-    THROW_IF_FAILED(mCommandList->Reset(mCommandAllocators[mBackBufferIndex].Get(), nullptr));
-
-    std::vector<D3D12_RESOURCE_BARRIER> barriers(mScene->BLAS.size());
-    for (uint32_t i = 0; i < mScene->BLAS.size(); i++)
+    if (mScene->NumSparseTreeVoxels != 0)
     {
-        auto& blasDesc = mScene->BLASDescs[i];
-        auto& blas = mScene->BLAS[i];
-        mDevice->BuildAccelerationStructure(blasDesc, mCommandList);
-        barriers[i] = CD3DX12_RESOURCE_BARRIER::UAV(blas->GetResource());
+        const double bytesPerVoxel = (double)mScene->SparseTreeMemoryConsumption / mScene->NumSparseTreeVoxels;
+        std::cout << "Sparse 64-Tree: " << mScene->NumSparseTreeNodes << " nodes, " << bytesPerVoxel
+                  << " bytes/voxel, built in " << mScene->SparseTreeBuildTime << " ms" << std::endl;
     }
+    std::cout << "Number of Culled Voxels: " << mScene->NumCulledVoxels << std::endl;
+    std::cout << "Number of AABBs: " << mScene->NumAABBs << std::endl;
+    std::cout << "Number of BLAS AABBs: " << mScene->NumBLASAABBs << (voxelGrids ? " (voxel grids)" : "") << std::endl;
+    if (bricks)
+        std::cout << "Number of Bricks: " << mScene->NumBricks << std::endl;
+    std::cout << "Acceleration Structure Memory Consumption: " << mScene->ASMemoryConsumption << " Bytes" << std::endl;
+    std::cout << "Buffers Memory Consumption: " << mScene->BuffersMemoryConsumption << " Bytes" << std::endl;
+    std::cout << "BLAS Scratch Memory: " << GetPeakScratchSize(mScene->BLASBatches) << " Bytes peak in "
+              << mScene->BLASBatches.size() << " batches, " << mScene->UnbatchedScratchSize << " Bytes unbatched"
+              << std::endl;
+    if (compactVoxels || voxelGrids || bricks)
+        std::cout << "BLAS Build Input Memory (freed after build): " << mScene->BuildInputMemoryConsumption
+                  << " Bytes" << std::endl;
 
-    // Barrier
-    mCommandList->ResourceBarrier(barriers.size(), barriers.data());
-
-    mDevice->BuildAccelerationStructure(mScene->TLASDesc, mCommandList);
-
-    mCommandList->Close();
-
-    ID3D12CommandList* ppCommandLists[] = {mCommandList.Get()};
-    mCommandQueue->ExecuteCommandLists(1, ppCommandLists);
-
-    mCommandQueue->Signal(mFence.Get(), ++mFenceValue);
-
-    // Wait for the command list to finish
-    mFence->SetEventOnCompletion(mFenceValue, mFenceEvent);
-    WaitForSingleObject(mFenceEvent, INFINITE);
-
-    // Create the output buffer
-    auto allocDesc = CD3DX12_RESOURCE_DESC::Buffer(sizeof(UINT64) * 2);
+    // The frames of the run start from the first slot again
+    mTimestampRing = QueryRing(mFrameContext.GetNumFramesInFlight(), NumFrameTimestamps);
 
-    // Get the timestamp frequency
-    UINT64 frequency;
-    THROW_IF_FAILED(mCommandQueue->GetTimestampFrequency(&frequency));
-    mTimestampFrequency = frequency;
+    BuildAccelerationStructures();
 
     CD3DX12_CPU_DESCRIPTOR_HANDLE cpuHandle(mResourceHeap->GetCPUDescriptorHandleForHeapStart());
     cpuHandle.Offset(3, mResourceDescriptorSize);
@@ -291,6 +721,158 @@ void AxisAlignedIntersection::Start()
         mDXDevice->CreateShaderResourceView(modelBuffer->GetResource(), &srvDesc, cpuHandle);
         cpuHandle.Offset(1, mResourceDescriptorSize);
     }
+
+    // The run's frames count from 0, the time and the accumulation start over
+    mFrameCount = 0;
+    mPassiveFrameCount = 0;
+
+    return true;
+}
+
+void AxisAlignedIntersection::BuildAccelerationStructures()
+{
+    PROFILE_ZONE("BuildAccelerationStructures");
+
+    const UINT32 buildQueries = mTimestampRing.GetNumQueries();
+
+    // Build the acceleration structures
+    THROW_IF_FAILED(mCommandAllocators[mFrameIndex]->Reset());
+    THROW_IF_FAILED(mCommandList->Reset(mCommandAllocators[mFrameIndex].Get(), nullptr));
+
+    WriteTimestamp(buildQueries + BLASBuildBegin);
+
+    const D3D12_GPU_VIRTUAL_ADDRESS scratchAddress = mScene->ScratchBufferBLAS->GetResource()->GetGPUVirtualAddress();
+
+    std::vector<D3D12_RESOURCE_BARRIER> barriers(mScene->BLAS.size());
+    for (auto& batch : mScene->BLASBatches)
+    {
+        // The previous batch has to be done with the scratch memory before it is reused
+        if (batch.First != 0)
+        {
+            auto scratchBarrier = CD3DX12_RESOURCE_BARRIER::UAV(mScene->ScratchBufferBLAS->GetResource());
+            mCommandList->ResourceBarrier(1, &scratchBarrier);
+        }
+
+        UINT64 scratchOffset = 0;
+        for (uint32_t i = batch.First; i < batch.First + batch.Count; i++)
+        {
+            auto& blasDesc = mScene->BLASDescs[i];
+            auto& blas = mScene->BLAS[i];
+
+            blasDesc.SetScratchBuffer(scratchAddress + scratchOffset);
+            scratchOffset += DXR_ALIGN(blasDesc.GetScratchBufferSize(),
+                                       D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+
+            mDevice->BuildAccelerationStructure(blasDesc, mCommandList);
+            barriers[i] = CD3DX12_RESOURCE_BARRIER::UAV(blas->GetResource());
+        }
+    }
+
+    // Barrier
+    mCommandList->ResourceBarrier(barriers.size(), barriers.data());
+
+    WriteTimestamp(buildQueries + BLASBuildEnd);
+
+    if (mLoadSettings.CompactBLAS)
+        CompactBLAS();
+
+    WriteTimestamp(buildQueries + TLASBuildBegin);
+    mDevice->BuildAccelerationStructure(mScene->TLASDesc, mCommandList);
+    WriteTimestamp(buildQueries + TLASBuildEnd);
+
+    mCommandList->ResolveQueryData(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, buildQueries, NumBuildTimestamps,
+                                   mTimestampReadback->GetResource(), buildQueries * sizeof(UINT64));
+
+    ExecuteAndWait();
+
+    mBLASBuildTime = GetTimestampMs(buildQueries + BLASBuildBegin, buildQueries + BLASBuildEnd);
+    mTLASBuildTime = GetTimestampMs(buildQueries + TLASBuildBegin, buildQueries + TLASBuildEnd);
+    std::cout << "BLAS Build GPU Time: " << mBLASBuildTime << " ms" << std::endl;
+    std::cout << "TLAS Build GPU Time: " << mTLASBuildTime << " ms" << std::endl;
+
+    if (mLoadSettings.CompactBLAS)
+    {
+        mScene->ASMemoryConsumptionCompacted += mScene->TLAS->GetSize();
+        std::cout << "Acceleration Structure Memory Consumption (compacted): "
+                  << mScene->ASMemoryConsumptionCompacted << " Bytes" << std::endl;
+    }
+
+    const uint64_t memoryBeforeRelease = GetResidentMemory(*mScene);
+
+    // The BLAS are built and never rebuilt, the float AABBs aren't needed anymore
+    mScene->BuildInputBuffers.clear();
+
+    // Neither is anything else that was only read by the builds
+    if (mReleaseBuildBuffers)
+    {
+        mScene->ScratchBufferBLAS.Reset();
+        mScene->ScratchBufferTLAS.Reset();
+        mScene->InstanceBuffer.Reset();
+    }
+
+    const uint64_t memoryAfterRelease = GetResidentMemory(*mScene);
+    std::cout << "Scene Memory Before Release: " << memoryBeforeRelease << " Bytes" << std::endl;
+    std::cout << "Scene Memory After Release: " << memoryAfterRelease << " Bytes" << std::endl;
+}
+
+void AxisAlignedIntersection::CompactBLAS()
+{
+    PROFILE_ZONE("CompactBLAS");
+
+    // The compacted sizes are only known once the builds have executed, read them back
+    auto readbackDesc = CD3DX12_RESOURCE_DESC::Buffer(mScene->CompactedSizeBuffer->GetSize());
+    auto readback = mDevice->AllocateResource(readbackDesc, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_HEAP_TYPE_READBACK);
+
+    auto toCopySource = CD3DX12_RESOURCE_BARRIER::Transition(mScene->CompactedSizeBuffer->GetResource(),
+                                                             D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                                             D3D12_RESOURCE_STATE_COPY_SOURCE);
+    mCommandList->ResourceBarrier(1, &toCopySource);
+    mCommandList->CopyResource(readback->GetResource(), mScene->CompactedSizeBuffer->GetResource());
+
+    ExecuteAndWait();
+
+    const D3D12_RANGE readRange = {0, mScene->BLAS.size() * sizeof(UINT64)};
+    UINT64* compactedSizes = nullptr;
+    THROW_IF_FAILED(readback->GetResource()->Map(0, &readRange, (void**)&compactedSizes));
+
+    THROW_IF_FAILED(mCommandAllocators[mFrameIndex]->Reset());
+    THROW_IF_FAILED(mCommandList->Reset(mCommandAllocators[mFrameIndex].Get(), nullptr));
+
+    // Copy every BLAS into a right sized allocation
+    std::vector<ComPtr<DMA::Allocation>> originalBLAS;
+    std::vector<D3D12_RESOURCE_BARRIER> barriers;
+    for (uint32_t i = 0; i < mScene->BLAS.size(); i++)
+    {
+        auto& blas = mScene->BLAS[i];
+        originalBLAS.push_back(
+            mDevice->CompactAccelerationStructure(mScene->BLASDescs[i], blas, compactedSizes[i], mCommandList));
+        barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(blas->GetResource()));
+
+        mScene->ASMemoryConsumptionCompacted += blas->GetSize();
+    }
+
+    const D3D12_RANGE writeRange = {0, 0};
+    readback->GetResource()->Unmap(0, &writeRange);
+
+    mCommandList->ResourceBarrier(barriers.size(), barriers.data());
+
+    // The TLAS is built from the compacted BLAS
+    D3D12_RAYTRACING_INSTANCE_DESC* instances =
+        (D3D12_RAYTRACING_INSTANCE_DESC*)mDevice->MapAllocationForWrite(mScene->InstanceBuffer);
+    for (uint32_t i = 0; i < mScene->InstanceModels.size(); i++)
+    {
+        const uint32_t modelIndex = mScene->InstanceModels[i];
+        instances[i].AccelerationStructure = mScene->BLAS[modelIndex]->GetResource()->GetGPUVirtualAddress();
+    }
+    mScene->InstanceBuffer->GetResource()->Unmap(0, nullptr);
+
+    // The original BLAS are read by the copies, keep them until those have executed
+    ExecuteAndWait();
+
+    THROW_IF_FAILED(mCommandAllocators[mFrameIndex]->Reset());
+    THROW_IF_FAILED(mCommandList->Reset(mCommandAllocators[mFrameIndex].Get(), nullptr));
+
+    mScene->CompactedSizeBuffer.Reset();
 }
 
 void AxisAlignedIntersection::Update()
@@ -302,53 +884,281 @@ void AxisAlignedIntersection::Update()
     mCommandList->SetComputeRootShaderResourceView(0, mScene->TLAS->GetResource()->GetGPUVirtualAddress());
 
     D3D12_DISPATCH_RAYS_DESC desc = mShaderTable.GetRaysDesc(0, mWidth, mHeight);
+    WriteTimestamp(mTimestampRing.GetQueryIndex(DispatchRaysBegin));
     mCommandList->DispatchRays(&desc);
+    WriteTimestamp(mTimestampRing.GetQueryIndex(DispatchRaysEnd));
 
-    // Copy the output image to the back buffer
-    D3D12_RESOURCE_BARRIER barriers[] = {
-        CD3DX12_RESOURCE_BARRIER::Transition(mBackBuffers[mBackBufferIndex].Get(), D3D12_RESOURCE_STATE_PRESENT,
-                                             D3D12_RESOURCE_STATE_COPY_DEST),
-        CD3DX12_RESOURCE_BARRIER::Transition(mOutputImage->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
-                                             D3D12_RESOURCE_STATE_COPY_SOURCE),
-    };
-    mCommandList->ResourceBarrier(2, barriers);
+    // Copy the output image to the back buffer, headless runs only keep the output image and time an empty pass
+    WriteTimestamp(mTimestampRing.GetQueryIndex(CopyBegin));
+    if (!mHeadless)
+    {
+        D3D12_RESOURCE_BARRIER barriers[] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(mBackBuffers[mBackBufferIndex].Get(), D3D12_RESOURCE_STATE_PRESENT,
+                                                 D3D12_RESOURCE_STATE_COPY_DEST),
+            CD3DX12_RESOURCE_BARRIER::Transition(mOutputImage->GetResource(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+                                                 D3D12_RESOURCE_STATE_COPY_SOURCE),
+        };
+        mCommandList->ResourceBarrier(2, barriers);
+
+        mCommandList->CopyResource(mBackBuffers[mBackBufferIndex].Get(), mOutputImage->GetResource());
+
+        barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(
+            mBackBuffers[mBackBufferIndex].Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PRESENT);
+        barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(
+            mOutputImage->GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        mCommandList->ResourceBarrier(2, barriers);
+    }
+    WriteTimestamp(mTimestampRing.GetQueryIndex(CopyEnd));
+
+    const UINT32 slot = mTimestampRing.GetSlot();
+    mCommandList->ResolveQueryData(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+                                   mTimestampRing.GetFirstQuery(slot), NumFrameTimestamps,
+                                   mTimestampReadback->GetResource(), mTimestampRing.GetResultOffset(slot));
+}
+
+void AxisAlignedIntersection::WriteTimestamp(UINT32 query)
+{
+    mCommandList->EndQuery(mTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+}
+
+DOUBLE AxisAlignedIntersection::GetTimestampMs(UINT32 beginQuery, UINT32 endQuery) const
+{
+    return (DOUBLE)(mTimestamps[endQuery] - mTimestamps[beginQuery]) * 1000.0 / mTimestampFrequency;
+}
 
-    mCommandList->CopyResource(mBackBuffers[mBackBufferIndex].Get(), mOutputImage->GetResource());
+void AxisAlignedIntersection::ReadFrameTimestamps(const QueryRingFrame& frame)
+{
+    const UINT32 first = mTimestampRing.GetFirstQuery(frame.Slot);
 
-    barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(mBackBuffers[mBackBufferIndex].Get(),
-                                                       D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PRESENT);
-    barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(mOutputImage->GetResource(), D3D12_RESOURCE_STATE_COPY_SOURCE,
-                                                       D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-    mCommandList->ResourceBarrier(2, barriers);
+    PerformanceData& data = mPerformanceData[frame.Frame];
+    data.DispatchRaysTime = GetTimestampMs(first + DispatchRaysBegin, first + DispatchRaysEnd);
+    data.CopyTime = GetTimestampMs(first + CopyBegin, first + CopyEnd);
 }
 
 void AxisAlignedIntersection::WritePerformanceData()
 {
-    for (auto& data : mPerformanceData) { mPerformanceFile << data.Frame << "," << data.FrameTime << std::endl; }
+    for (auto& data : mPerformanceData)
+    {
+        mPerformanceFile << data.Frame << "," << data.FrameTime << "," << data.DispatchRaysTime << ","
+                         << data.CopyTime << std::endl;
+    }
 }
 
-void AxisAlignedIntersection::Stop()
+void AxisAlignedIntersection::WriteImages()
+{
+    const std::vector<uint8_t> output = ReadbackImage(mOutputImage->GetResource(), 4);
+
+    // The shaders leave the alpha at 0
+    std::vector<uint8_t> rgba(output.begin(), output.end());
+    for (uint64_t i = 3; i < rgba.size(); i += 4)
+        rgba[i] = 255;
+
+    const std::string pngFile = mRunName + ".png";
+    if (WritePNG(pngFile, mWidth, mHeight, rgba.data()))
+        std::cout << "Output Image: " << pngFile << std::endl;
+    else
+        std::cout << "Failed to write " << pngFile << std::endl;
+
+    // The accumulation image holds the sum of every frame's radiance since the camera last moved
+    const std::vector<uint8_t> accumulation = ReadbackImage(mAccumulationImage->GetResource(), sizeof(glm::vec4));
+
+    std::vector<glm::vec4> radiance(accumulation.size() / sizeof(glm::vec4));
+    memcpy(radiance.data(), accumulation.data(), accumulation.size());
+    for (auto& pixel : radiance)
+        pixel /= (float)std::max<UINT64>(mPassiveFrameCount, 1);
+
+    const std::string pfmFile = mRunName + ".pfm";
+    if (WritePFM(pfmFile, mWidth, mHeight, radiance.data()))
+        std::cout << "Accumulated Image: " << pfmFile << std::endl;
+    else
+        std::cout << "Failed to write " << pfmFile << std::endl;
+}
+
+BenchmarkReport AxisAlignedIntersection::WriteBenchmarkReport()
+{
+    std::vector<double> frameTimes;
+    std::vector<double> dispatchRaysTimes;
+    std::vector<double> copyTimes;
+    for (auto& data : mPerformanceData)
+    {
+        frameTimes.push_back(data.FrameTime);
+        dispatchRaysTimes.push_back(data.DispatchRaysTime);
+        copyTimes.push_back(data.CopyTime);
+    }
+
+    // The first frame has no frame time, it's always skipped
+    const uint64_t numWarmup = std::max<uint64_t>(mBenchmarkWarmupFrames, 1);
+
+    BenchmarkReport report;
+    report.Properties = {
+        {"scene", mSceneName},
+        {"shader_file", mShaderFile},
+    };
+    report.Values = {
+        {"width", (double)mWidth},
+        {"height", (double)mHeight},
+        {"voxels", (double)mScene->NumVoxels},
+        {"aabbs", (double)mScene->NumAABBs},
+        {"blas_aabbs", (double)mScene->NumBLASAABBs},
+        {"as_memory_bytes", (double)mScene->ASMemoryConsumption},
+        {"as_memory_compacted_bytes", (double)mScene->ASMemoryConsumptionCompacted},
+        {"buffers_memory_bytes", (double)mScene->BuffersMemoryConsumption},
+        {"load_time_ms", mScene->LoadTime},
+        {"blas_build_gpu_ms", mBLASBuildTime},
+        {"tlas_build_gpu_ms", mTLASBuildTime},
+    };
+    report.Stats = {
+        {"frame_time_ms", ComputeSampleStats(frameTimes, numWarmup)},
+        {"dispatch_rays_gpu_ms", ComputeSampleStats(dispatchRaysTimes, numWarmup)},
+        {"copy_gpu_ms", ComputeSampleStats(copyTimes, numWarmup)},
+    };
+
+    std::cout << "Benchmark: " << frameTimes.size() << " frames, " << numWarmup << " warmup" << std::endl;
+    PrintSampleStats(std::cout, "Frame Time (ms)", report.Stats[0].second);
+    PrintSampleStats(std::cout, "DispatchRays GPU Time (ms)", report.Stats[1].second);
+    PrintSampleStats(std::cout, "Copy GPU Time (ms)", report.Stats[2].second);
+
+    const std::string reportFile = mRunName + ".json";
+    if (!WriteBenchmarkJson(reportFile, report))
+        std::cout << "Failed to write " << reportFile << std::endl;
+
+    return report;
+}
+
+void AxisAlignedIntersection::FinishRun()
 {
+    PROFILE_ZONE("FinishRun");
+
+    if (mCameraPathMode == CameraPathMode::Record)
+    {
+        if (WriteCameraPath(mCameraPathFile, mCameraPath))
+            std::cout << "Camera Path: " << mCameraPath.Keyframes.size() << " keyframes recorded to " << mCameraPathFile
+                      << std::endl;
+        else
+            std::cout << "Failed to write the camera path " << mCameraPathFile << std::endl;
+    }
+
+    // The GPU is idle, the timestamps of the last frames are resolved
+    for (auto& frame : mTimestampRing.Drain())
+        ReadFrameTimestamps(frame);
+
     // Write the performance data to the file
     WritePerformanceData();
     mPerformanceFile.close();
+
+    const BenchmarkReport report = WriteBenchmarkReport();
+
+    if (mHeadless)
+        WriteImages();
+
+    BenchmarkResult& result = mResults.emplace_back();
+    result.Run = mRuns[mRunIndex];
+    result.NumVoxels = mScene->NumVoxels;
+    result.ASMemoryConsumption = mScene->ASMemoryConsumption;
+    result.LoadTime = mScene->LoadTime;
+    result.BLASBuildTime = mBLASBuildTime;
+    result.TLASBuildTime = mTLASBuildTime;
+    result.FrameTime = report.Stats[0].second;
+    result.DispatchRaysTime = report.Stats[1].second;
+
+    // The descriptors of the scene stay in the heap until the next run overwrites them, they're never used again
+    mScene.reset();
+    mShaderTable = DXR::ShaderTable();
+    mPipeline.Reset();
+    mRootSig.Reset();
+
+    const DMA::Statistics allocations = GetAllocationStatistics(*mDevice);
+    if (allocations.AllocationCount > mAllocationsBeforeRun.AllocationCount)
+    {
+        std::cout << "Leaked " << allocations.AllocationCount - mAllocationsBeforeRun.AllocationCount
+                  << " allocations, " << allocations.AllocationBytes - mAllocationsBeforeRun.AllocationBytes
+                  << " Bytes, of run " << mRunName << std::endl;
+    }
 }
 
-void AxisAlignedIntersection::EndFrame()
+void AxisAlignedIntersection::WriteMatrixResults()
 {
-    Application::EndFrame();
+    const std::ios::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+
+    std::cout << std::endl
+              << std::left << std::setw(40) << "Run" << std::setw(12) << "Voxels" << std::setw(10) << "AS (MB)"
+              << std::setw(12) << "Load (ms)" << std::setw(12) << "BLAS (ms)" << std::setw(14) << "Frame (ms)"
+              << std::setw(12) << "p95 (ms)" << "DispatchRays (ms)" << std::endl;
+
+    std::ofstream file("Matrix.csv", std::ios::out);
+    file << "Scene,ShaderFile,Width,Height,Voxels,ASMemory,LoadTime,BLASBuildTime,TLASBuildTime,FrameTimeMean,"
+            "FrameTimeMedian,FrameTimeP95,FrameTimeStdDev,DispatchRaysTimeMean,DispatchRaysTimeMedian"
+         << std::endl;
 
-    if (mFrameCount >= mBenchmarkFrameCount)
+    for (auto& result : mResults)
     {
-        glfwSetWindowShouldClose(mWindow, true);
+        std::cout << std::left << std::setw(40) << result.Run.Name << std::setw(12) << result.NumVoxels << std::fixed
+                  << std::setprecision(2) << std::setw(10) << result.ASMemoryConsumption / (1024.0 * 1024.0)
+                  << std::setw(12) << result.LoadTime << std::setw(12) << result.BLASBuildTime << std::setw(14)
+                  << result.FrameTime.Mean << std::setw(12) << result.FrameTime.P95 << result.DispatchRaysTime.Mean
+                  << std::endl;
+
+        file << result.Run.Scene << "," << result.Run.ShaderFile << "," << result.Run.Width << ","
+             << result.Run.Height << "," << result.NumVoxels << "," << result.ASMemoryConsumption << ","
+             << result.LoadTime << "," << result.BLASBuildTime << "," << result.TLASBuildTime << ","
+             << result.FrameTime.Mean << "," << result.FrameTime.Median << "," << result.FrameTime.P95 << ","
+             << result.FrameTime.StdDev << "," << result.DispatchRaysTime.Mean << ","
+             << result.DispatchRaysTime.Median << std::endl;
     }
 
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+
+    std::cout << "Matrix Results: Matrix.csv" << std::endl;
+}
+
+void AxisAlignedIntersection::Stop()
+{
+    // No run is active when the scenes of the last runs failed to load
+    if (mScene != nullptr)
+        FinishRun();
+
+    if (mResults.size() > 1)
+        WriteMatrixResults();
+}
+
+void AxisAlignedIntersection::BeginFrame()
+{
+    // Waits for the frame that last used this frame's slot, its timestamps are resolved
+    Application::BeginFrame();
+
+    QueryRingFrame completed;
+    if (mTimestampRing.BeginFrame(mFrameCount, completed))
+        ReadFrameTimestamps(completed);
+}
+
+void AxisAlignedIntersection::EndFrame()
+{
+    Application::EndFrame();
+
     // Calculate the time taken
     PerformanceData data;
     data.Frame = mFrameCount;
     // First frame doesn't have a delta time
     data.FrameTime = mFrameCount == 1 ? 0.0 : DeltaTime * 1000.0;
     mPerformanceData.push_back(data);
+
+    if (mFrameCount < mBenchmarkFrameCount)
+        return;
+
+    // The next run of the matrix starts once the GPU is done with this one, the last one ends the loop
+    if (mRunIndex + 1 < mRuns.size())
+    {
+        CleanUp();
+        FinishRun();
+        mRunIndex++;
+        StartNextRun();
+    }
+    else
+    {
+        RequestStop();
+    }
 }
 
 int main()
@@ -356,9 +1166,28 @@ int main()
     // Create the application, start it, run it and stop it, boierplate code, eg initialising vulkan, glfw, etc
     // that is the same for every application is handled by the Application class
     // it can be found in the Base folder
-    Application* app = new AxisAlignedIntersection();
+    // Headless runs render benchmark_frames frames without a window and write the final image, so do the runs of the
+    // matrix as their resolutions differ from the window's
+    auto config = toml::parse_file("Data/config.toml");
+    const bool headless = config["headless"].value_or(false) || config["matrix"]["enabled"].value_or(false);
+    const uint32_t framesInFlight = config["frames_in_flight"].value_or(2);
+    Application* app = new AxisAlignedIntersection(headless, framesInFlight);
+
+    // Scoped CPU zones of the load, the builds and every frame, written as a Chrome trace once the app has stopped
+    const bool cpuProfile = config["cpu_profile"].value_or(false);
+    if (cpuProfile)
+        EnableProfiler();
 
     app->Run();
 
+    if (cpuProfile)
+    {
+        DisableProfiler();
+        if (WriteChromeTrace("CpuProfile.json", CollectProfilerZones()))
+            std::cout << "CPU Profile: CpuProfile.json" << std::endl;
+        else
+            std::cout << "Failed to write CpuProfile.json" << std::endl;
+    }
+
     delete app;
 }
@@ -1,37 +1,45 @@
 #include "Common.h"
 #include "ShaderCompiler.h"
 #include "Application.h"
+#include "Core/Voxel.h"
+#include "Core/ScratchBatching.h"
+#include "Core/QueryRing.h"
+#include "Core/BenchmarkStats.h"
 
 struct PerformanceData
 {
     uint32_t Frame;
     DOUBLE FrameTime;
+    // GPU time of the passes, from timestamp queries
+    DOUBLE DispatchRaysTime = 0.0;
+    DOUBLE CopyTime = 0.0;
 };
 
-struct VoxAABB
+// Timestamps written every frame, two per pass
+enum FrameTimestamp : uint32_t
 {
-    glm::vec3 Min;
-    glm::vec3 Max;
-    uint32_t ColorIndex;
-    uint32_t Padding;
+    DispatchRaysBegin,
+    DispatchRaysEnd,
+    CopyBegin,
+    CopyEnd,
+    NumFrameTimestamps,
 };
 
-struct VoxMaterial
+// Timestamps written once around the acceleration structure builds, after those of the frames in the query heap
+enum BuildTimestamp : uint32_t
 {
-    uint32_t Color;
-    float Emissive;
-};
-
-struct VoxelModel
-{
-    glm::vec3 Size;
-    glm::mat3x4 Transform;
-    std::vector<VoxAABB> AABBs;
+    BLASBuildBegin,
+    BLASBuildEnd,
+    TLASBuildBegin,
+    TLASBuildEnd,
+    NumBuildTimestamps,
 };
 
 struct VoxelScene
 {
     std::vector<ComPtr<DMA::Allocation>> ModelBuffers;
+    // Float AABBs that are only read by the BLAS builds when the model buffers hold packed voxels
+    std::vector<ComPtr<DMA::Allocation>> BuildInputBuffers;
     ComPtr<DMA::Allocation> InstanceBuffer;
 
     ComPtr<DMA::Allocation> SizeBuffer;
@@ -46,11 +54,64 @@ struct VoxelScene
     ComPtr<DMA::Allocation> ScratchBufferBLAS;
     ComPtr<DMA::Allocation> ScratchBufferTLAS;
 
+    // The BLAS are built in batches that take turns using ScratchBufferBLAS
+    std::vector<ScratchBatch> BLASBatches;
+    std::uint64_t UnbatchedScratchSize = 0;
+
+    // Receives the compacted BLAS sizes when the BLAS are built with compaction
+    ComPtr<DMA::Allocation> CompactedSizeBuffer;
+
+    // Model index of each instance, to point the instances at the BLAS again after compaction
+    std::vector<uint32_t> InstanceModels;
+
+    // Index of every model's first brick in the brick pool when the scene is loaded as bricks
+    std::vector<uint32_t> FirstBricks;
+
     std::vector<D3D12_SHADER_RESOURCE_VIEW_DESC> AABBViews;
 
+    std::uint64_t NumModels = 0;
+    std::uint64_t NumInstances = 0;
     std::uint64_t NumVoxels = 0;
+    std::uint64_t NumAABBs = 0;
+    std::uint64_t NumBLASAABBs = 0;
+    std::uint64_t NumBricks = 0;
+    std::uint64_t NumSparseTreeNodes = 0;
+    std::uint64_t NumSparseTreeVoxels = 0;
+    std::uint64_t SparseTreeMemoryConsumption = 0;
+    std::uint64_t NumCulledVoxels = 0;
     std::uint64_t ASMemoryConsumption = 0;
+    std::uint64_t ASMemoryConsumptionCompacted = 0;
     std::uint64_t BuffersMemoryConsumption = 0;
+    std::uint64_t BuildInputMemoryConsumption = 0;
+
+    DOUBLE LoadTime = 0.0;
+    DOUBLE SparseTreeBuildTime = 0.0;
+    bool LoadedFromCache = false;
+};
+
+// A scene rendered with a shader file at a resolution for benchmark_frames frames
+struct BenchmarkRun
+{
+    std::string Scene;
+    std::string ShaderFile;
+    UINT32 Width = 0;
+    UINT32 Height = 0;
+
+    // Name of the run's performance data, report and images
+    std::string Name;
+};
+
+// A run's row in the results of the matrix
+struct BenchmarkResult
+{
+    BenchmarkRun Run;
+    std::uint64_t NumVoxels = 0;
+    std::uint64_t ASMemoryConsumption = 0;
+    DOUBLE LoadTime = 0.0;
+    DOUBLE BLASBuildTime = 0.0;
+    DOUBLE TLASBuildTime = 0.0;
+    SampleStats FrameTime;
+    SampleStats DispatchRaysTime;
 };
 
 struct SceneConfig
@@ -64,15 +125,52 @@ struct SceneConfig
 class AxisAlignedIntersection : public Application
 {
 public:
+    using Application::Application;
+
     virtual void Start() override;
     virtual void Update() override;
     virtual void Stop() override;
 
+    virtual void BeginFrame() override;
     virtual void EndFrame() override;
 
 private:
+    // Starts the current run or the first one after it whose scene loads, stops the loop when there is none
+    void StartNextRun();
+
+    // Loads the run's scene, compiles its shader, builds the acceleration structures and resets the frame counts.
+    // Returns false without allocating anything when the scene fails to load.
+    bool StartRun(const BenchmarkRun& run);
+
+    // Records the BLAS and TLAS builds, executes them and frees what only the builds read
+    void BuildAccelerationStructures();
+
+    // Writes the run's results and releases everything StartRun allocated, the GPU must be idle
+    void FinishRun();
+
+    // Prints the results of all runs as one table and writes them to Matrix.csv
+    void WriteMatrixResults();
+
     void WritePerformanceData();
 
+    // Records a timestamp into the query heap at the given index
+    void WriteTimestamp(UINT32 query);
+
+    // Milliseconds between two resolved timestamps
+    DOUBLE GetTimestampMs(UINT32 beginQuery, UINT32 endQuery) const;
+
+    // Stores the resolved pass times of a frame in its performance data
+    void ReadFrameTimestamps(const QueryRingFrame& frame);
+
+    // Prints the statistics of the frame and pass times and writes them with the scene's numbers to <run name>.json
+    BenchmarkReport WriteBenchmarkReport();
+
+    // Reads back the output and the accumulated radiance and writes them next to the performance data
+    void WriteImages();
+
+    // Replaces the built BLAS with compacted copies and updates the instances, records into the open command list
+    void CompactBLAS();
+
 public:
     ShaderCompiler mShaderCompiler;
 
@@ -84,8 +182,46 @@ public:
 
     DOUBLE mTimestampFrequency = 0.0;
 
+    // The frames' timestamps are resolved into a persistently mapped readback buffer and read when their slot comes
+    // around again, once BeginFrame has waited for the frame that wrote them. One slot per frame in flight.
+    ComPtr<ID3D12QueryHeap> mTimestampHeap;
+    ComPtr<DMA::Allocation> mTimestampReadback;
+    const UINT64* mTimestamps = nullptr;
+    QueryRing mTimestampRing;
+
     uint32_t mBenchmarkFrameCount = UINT16_MAX;
+    // Frames at the start that the statistics leave out
+    uint32_t mBenchmarkWarmupFrames = 0;
+
+    // GPU time of the acceleration structure builds in ms
+    DOUBLE mBLASBuildTime = 0.0;
+    DOUBLE mTLASBuildTime = 0.0;
 
     std::vector<PerformanceData> mPerformanceData;
     std::ofstream mPerformanceFile;
+
+    std::string mSceneName;
+    std::string mShaderFile;
+
+    // <scene>-<shader_file>, the name of the performance data and the headless images. Matrix runs append the
+    // resolution.
+    std::string mRunName;
+
+    // The load settings of config.toml, the shader file of the run selects voxel grids or bricks
+    VoxelLoadSettings mLoadSettings;
+    bool mReleaseBuildBuffers = false;
+
+    // camera_path of config.toml, a run without a readable path to play uses the scene's camera
+    CameraPathMode mCameraPathSetting = CameraPathMode::None;
+
+    // The single run of scene and shader_file, or every combination of the matrix
+    std::vector<BenchmarkRun> mRuns;
+    uint64_t mRunIndex = 0;
+    std::vector<BenchmarkResult> mResults;
+
+    // Allocations alive when the current run started, those of the run have to be gone again when it's finished
+    DMA::Statistics mAllocationsBeforeRun = {};
+
+    // Data/<scene>.campath
+    std::string mCameraPathFile;
 };
@@ -0,0 +1,154 @@
+#include "Check.h"
+#include "Core/BenchmarkStats.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+    bool Near(double a, double b)
+    {
+        return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(b));
+    }
+
+    void TestEmpty()
+    {
+        CHECK(GetPercentile({}, 50.0) == 0.0);
+
+        const SampleStats stats = ComputeSampleStats({}, 0);
+        CHECK(stats.Count == 0 && stats.NumWarmup == 0 && stats.NumOutliers == 0);
+        CHECK(stats.Mean == 0.0 && stats.StdDev == 0.0 && stats.Median == 0.0 && stats.MeanWithoutOutliers == 0.0);
+    }
+
+    // A warmup that covers every sample leaves nothing to summarize, it is clamped to the number of samples
+    void TestWarmupCoversSamples()
+    {
+        const std::vector<double> samples = {5.0, 6.0, 7.0};
+
+        const SampleStats all = ComputeSampleStats(samples, 3);
+        CHECK(all.Count == 0 && all.NumWarmup == 3);
+        CHECK(all.Mean == 0.0 && all.Max == 0.0);
+
+        const SampleStats more = ComputeSampleStats(samples, 10);
+        CHECK(more.Count == 0 && more.NumWarmup == 3);
+
+        // Only the samples after the warmup count
+        const SampleStats last = ComputeSampleStats(samples, 2);
+        CHECK(last.Count == 1 && last.NumWarmup == 2 && last.Mean == 7.0);
+    }
+
+    void TestSingleSample()
+    {
+        const std::vector<double> samples = {4.25};
+        const SampleStats stats = ComputeSampleStats(samples, 0);
+        CHECK(stats.Count == 1);
+        CHECK(stats.Mean == 4.25 && stats.StdDev == 0.0);
+        CHECK(stats.Min == 4.25 && stats.Max == 4.25);
+        CHECK(stats.Median == 4.25 && stats.P1 == 4.25 && stats.P99 == 4.25);
+        CHECK(stats.NumOutliers == 0 && stats.MeanWithoutOutliers == 4.25);
+    }
+
+    void TestKnownValues()
+    {
+        // Interpolated between the closest ranks, p is clamped to [0, 100]
+        const std::vector<double> four = {10.0, 20.0, 30.0, 40.0};
+        CHECK(Near(GetPercentile(four, 50.0), 25.0));
+        CHECK(Near(GetPercentile(four, 0.0), 10.0));
+        CHECK(Near(GetPercentile(four, 100.0), 40.0));
+        CHECK(Near(GetPercentile(four, 25.0), 17.5));
+        CHECK(GetPercentile(four, -5.0) == 10.0 && GetPercentile(four, 150.0) == 40.0);
+
+        // 0 to 100 in reverse order, percentile p is p itself
+        std::vector<double> samples;
+        for (int i = 100; i >= 0; i--)
+            samples.push_back(i);
+
+        const SampleStats stats = ComputeSampleStats(samples, 0);
+        CHECK(stats.Count == 101);
+        CHECK(Near(stats.Mean, 50.0));
+        CHECK(stats.Min == 0.0 && stats.Max == 100.0);
+        CHECK(Near(stats.Median, 50.0) && Near(stats.P1, 1.0) && Near(stats.P5, 5.0));
+        CHECK(Near(stats.P95, 95.0) && Near(stats.P99, 99.0));
+
+        // Sample standard deviation, divided by n - 1
+        const std::vector<double> spread = {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+        const SampleStats spreadStats = ComputeSampleStats(spread, 0);
+        CHECK(Near(spreadStats.Mean, 5.0));
+        CHECK(Near(spreadStats.StdDev, std::sqrt(32.0 / 7.0)));
+    }
+
+    void TestOutliers()
+    {
+        // 0 to 100 has the quartiles 25 and 75, so the fences are at -50 and 150
+        std::vector<double> samples;
+        for (int i = 0; i <= 100; i++)
+            samples.push_back(i);
+
+        CHECK(ComputeSampleStats(samples, 0).NumOutliers == 0);
+
+        // Far out on both sides, the quartiles hardly move
+        samples.push_back(1000.0);
+        samples.push_back(-1000.0);
+        samples.push_back(2000.0);
+        const SampleStats stats = ComputeSampleStats(samples, 0);
+        CHECK(stats.NumOutliers == 3);
+        CHECK(Near(stats.MeanWithoutOutliers, 50.0));
+        CHECK(stats.Min == -1000.0 && stats.Max == 2000.0);
+
+        // Exactly on a fence is still inside
+        const std::vector<double> fence = {0.0, 0.0, 0.0, 1.0, 1.0, 1.0, 2.5, -1.5};
+        const SampleStats fenceStats = ComputeSampleStats(fence, 0);
+        CHECK(Near(GetPercentile(std::vector<double> {-1.5, 0.0, 0.0, 0.0, 1.0, 1.0, 1.0, 2.5}, 25.0), 0.0));
+        CHECK(fenceStats.NumOutliers == 0);
+
+        // Identical samples have no spread, anything else is an outlier
+        const std::vector<double> flat = {3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.0, 3.5};
+        const SampleStats flatStats = ComputeSampleStats(flat, 0);
+        CHECK(flatStats.NumOutliers == 1 && flatStats.MeanWithoutOutliers == 3.0);
+
+        // Warmup samples are never outliers
+        const std::vector<double> warm = {500.0, 1.0, 2.0, 3.0, 4.0};
+        CHECK(ComputeSampleStats(warm, 1).NumOutliers == 0);
+    }
+
+    void TestJson()
+    {
+        BenchmarkReport report;
+        report.Properties.push_back({"scene", "a \"quoted\" name"});
+        report.Values.push_back({"voxels", 42.0});
+        report.Values.push_back({"broken", NAN});
+        report.Stats.push_back({"frame_time", ComputeSampleStats(std::vector<double> {1.0, 2.0, 3.0}, 0)});
+
+        const std::filesystem::path path = std::filesystem::temp_directory_path() / "BenchmarkStatsTest.json";
+        CHECK(WriteBenchmarkJson(path.string(), report));
+
+        std::ifstream file(path);
+        std::stringstream json;
+        json << file.rdbuf();
+        file.close();
+        std::filesystem::remove(path);
+
+        const std::string text = json.str();
+        CHECK(text.find("\"scene\": \"a \\\"quoted\\\" name\"") != std::string::npos);
+        CHECK(text.find("\"voxels\": 42") != std::string::npos);
+        CHECK(text.find("\"broken\": 0") != std::string::npos);
+        CHECK(text.find("\"frame_time\": {\"count\": 3, ") != std::string::npos);
+        CHECK(text.find("\"median\": 2, ") != std::string::npos);
+    }
+} // namespace
+
+int main()
+{
+    TestEmpty();
+    TestWarmupCoversSamples();
+    TestSingleSample();
+    TestKnownValues();
+    TestOutliers();
+    TestJson();
+
+    return ReportChecks("BenchmarkStatsTest");
+}
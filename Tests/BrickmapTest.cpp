@@ -0,0 +1,223 @@
+#include "Check.h"
+#include "RayReference.h"
+#include "TestModel.h"
+#include "Core/Brickmap.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Every brick whose bounds the ray overlaps gets walked and the closest hit wins, in any order like the BLAS
+    // calls isect. Later walks are clipped to the closest hit so far like RayTCurrent().
+    bool TraceBrickmap(const Brickmap& brickmap, const glm::vec3& origin, const glm::vec3& direction, float tMin,
+                       float tMax, VoxelGridHit& outHit)
+    {
+        bool found = false;
+
+        for (uint64_t i = 0; i < brickmap.Bricks.size(); i++)
+        {
+            ReferenceHit bounds;
+            if (!IntersectBoxes({&brickmap.Bounds[i], 1}, origin, direction, tMin, tMax, bounds))
+                continue;
+
+            VoxelGridHit hit;
+            if (TraceBrick(brickmap.Bricks[i], brickmap.Colors, origin, direction, tMin, tMax, hit))
+            {
+                tMax = hit.T;
+                outHit = hit;
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    // The bricks find the voxel the walk over the whole grid finds, and both agree with the slab test over the boxes.
+    // Rays that start in a filled voxel have no entry face, their normal is left out.
+    bool MatchesGrid(const TestModel& model, const VoxelGrid& grid, const Brickmap& brickmap, const glm::vec3& origin,
+                     const glm::vec3& direction)
+    {
+        const float tMax = 1000.0f;
+
+        VoxelGridHit gridHit;
+        const bool hitGrid = TraceVoxelGrid(grid, origin, direction, 0.0f, tMax, gridHit);
+
+        VoxelGridHit brickHit;
+        const bool hitBricks = TraceBrickmap(brickmap, origin, direction, 0.0f, tMax, brickHit);
+
+        ReferenceHit expected;
+        const bool hitBoxes = IntersectBoxes(model.AABBs, origin, direction, 0.0f, tMax, expected);
+
+        if (hitGrid != hitBricks || hitBricks != hitBoxes)
+            return false;
+
+        return !hitBricks || (NearlyEqual(brickHit.T, gridHit.T) && NearlyEqual(brickHit.T, expected.T) &&
+                              brickHit.Voxel == gridHit.Voxel && brickHit.ColorIndex == gridHit.ColorIndex &&
+                              (brickHit.T == 0.0f || brickHit.Normal == gridHit.Normal));
+    }
+
+    // Sizes that aren't multiples of the brick size leave the last bricks of every axis partially inside the model
+    TestModel MakeRandomModel(const glm::uvec3& size, uint32_t density, std::mt19937& rng)
+    {
+        TestModel model(size);
+        for (uint32_t z = 0; z < size.z; z++)
+            for (uint32_t y = 0; y < size.y; y++)
+                for (uint32_t x = 0; x < size.x; x++)
+                    if (rng() % density == 0)
+                        model.Fill(x, y, z, 1 + rng() % 255);
+
+        return model;
+    }
+
+    void TestBuild()
+    {
+        std::mt19937 rng(1234);
+        const TestModel model = MakeRandomModel(glm::uvec3(13, 9, 17), 5, rng);
+        const VoxelGrid grid = model.Build();
+        const Brickmap brickmap = BuildBrickmap(grid);
+
+        CHECK(brickmap.Bricks.size() == brickmap.Bounds.size());
+        CHECK(brickmap.Colors.size() == model.AABBs.size());
+
+        // Every filled voxel is in its brick with its color, the bounds hold exactly the filled voxels
+        uint64_t numFilled = 0;
+        for (uint64_t i = 0; i < brickmap.Bricks.size(); i++)
+        {
+            const Brick& brick = brickmap.Bricks[i];
+            const glm::uvec3 offset =
+                (glm::uvec3(brick.Position, brick.Position >> 8, brick.Position >> 16) & 0xFFu) * BrickSize;
+
+            glm::uvec3 filledMin(UINT32_MAX);
+            glm::uvec3 filledMax(0);
+            uint32_t color = brick.FirstColor;
+            for (uint32_t z = 0; z < BrickSize; z++)
+            {
+                for (uint32_t bit = 0; bit < BrickSize * BrickSize; bit++)
+                {
+                    if (!(brick.Occupancy[z] & (1ull << bit)))
+                        continue;
+
+                    const glm::uvec3 voxel = offset + glm::uvec3(bit % BrickSize, bit / BrickSize, z);
+                    CHECK(voxel.x < grid.Size.x && voxel.y < grid.Size.y && voxel.z < grid.Size.z);
+                    CHECK(grid.GetColorIndex(voxel) == brickmap.Colors[color++]);
+
+                    filledMin = glm::min(filledMin, voxel);
+                    filledMax = glm::max(filledMax, voxel + 1u);
+                    numFilled++;
+                }
+            }
+
+            CHECK(brickmap.Bounds[i].Min == glm::vec3(filledMin) - 0.5f);
+            CHECK(brickmap.Bounds[i].Max == glm::vec3(filledMax) - 0.5f);
+        }
+        CHECK(numFilled == model.AABBs.size());
+    }
+
+    void TestPartialEdgeBricks()
+    {
+        // Only the voxels in the last, partial bricks of every axis are filled
+        TestModel model(glm::uvec3(11, 10, 9));
+        for (uint32_t z = 8; z < 9; z++)
+            for (uint32_t y = 8; y < 10; y++)
+                for (uint32_t x = 8; x < 11; x++)
+                    model.Fill(x, y, z, 1 + x + y);
+        model.Fill(10, 0, 0, 200);
+        const VoxelGrid grid = model.Build();
+        const Brickmap brickmap = BuildBrickmap(grid);
+        CHECK(brickmap.Bricks.size() == 2);
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> around(-4.0f, 14.0f);
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            const glm::vec3 origin(around(rng), around(rng), around(rng));
+            const glm::vec3 direction(unit(rng), unit(rng), unit(rng));
+            CHECK(MatchesGrid(model, grid, brickmap, origin, direction));
+        }
+
+        // The far corner voxel is hit at its face, the ray never leaves the last brick's valid part
+        VoxelGridHit hit;
+        CHECK(TraceBrickmap(brickmap, glm::vec3(20.0f, 9.0f, 8.0f), glm::vec3(-1.0f, 0.0f, 0.0f), 0.0f, 100.0f, hit));
+        CHECK(hit.T == 9.5f && hit.Voxel == glm::uvec3(10, 9, 8) && hit.Normal == glm::vec3(1.0f, 0.0f, 0.0f));
+    }
+
+    // Rays along every axis in both directions through voxel centers and along the faces between voxels and bricks,
+    // with +0 and -0 in the other components
+    void TestAxisParallel()
+    {
+        std::mt19937 rng(1234);
+        const TestModel model = MakeRandomModel(glm::uvec3(19, 12, 10), 4, rng);
+        const VoxelGrid grid = model.Build();
+        const Brickmap brickmap = BuildBrickmap(grid);
+
+        const float zeros[] = {0.0f, -0.0f};
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const uint32_t u = (axis + 1) % 3;
+            const uint32_t v = (axis + 2) % 3;
+
+            for (float sign : {1.0f, -1.0f})
+            {
+                for (float position = -1.0f; position <= (float)model.Size[u]; position += 0.5f)
+                {
+                    for (float other = -1.0f; other <= (float)model.Size[v]; other += 0.5f)
+                    {
+                        glm::vec3 origin;
+                        origin[axis] = sign > 0.0f ? -2.0f : model.Size[axis] + 2.0f;
+                        origin[u] = position;
+                        origin[v] = other;
+
+                        for (uint32_t i = 0; i < 4; i++)
+                        {
+                            glm::vec3 direction;
+                            direction[axis] = sign;
+                            direction[u] = zeros[i % 2];
+                            direction[v] = zeros[i / 2];
+                            CHECK(MatchesGrid(model, grid, brickmap, origin, direction));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void TestRandomGrids()
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for (uint32_t i = 0; i < 30; i++)
+        {
+            const glm::uvec3 size(1 + rng() % 30, 1 + rng() % 30, 1 + rng() % 30);
+            const TestModel model = MakeRandomModel(size, 2 + rng() % 30, rng);
+            const VoxelGrid grid = model.Build();
+            const Brickmap brickmap = BuildBrickmap(grid);
+
+            const glm::vec3 extent = glm::vec3(size);
+            const glm::vec3 center = extent * 0.5f - 0.5f;
+            auto randomPoint = [&]() { return glm::vec3(unit(rng), unit(rng), unit(rng)) * extent - 0.5f; };
+
+            for (uint32_t r = 0; r < 200; r++)
+            {
+                // Half the rays start inside the model, the others on a sphere around it
+                glm::vec3 origin = randomPoint();
+                if (r % 2 == 0)
+                    origin = center + glm::normalize(randomPoint() - center + 0.01f) * glm::length(extent);
+
+                CHECK(MatchesGrid(model, grid, brickmap, origin, randomPoint() - origin));
+            }
+        }
+    }
+} // namespace
+
+int main()
+{
+    TestBuild();
+    TestPartialEdgeBricks();
+    TestAxisParallel();
+    TestRandomGrids();
+
+    return ReportChecks("BrickmapTest");
+}
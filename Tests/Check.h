@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Every Tests/*.cpp is its own executable and ctest test. CHECK records a failure and carries on, so one run reports
+// every broken case, main returns the result of ReportChecks.
+inline int& GetCheckFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                                               \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            GetCheckFailures()++;                                                                                      \
+            std::cout << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl;                 \
+        }                                                                                                              \
+    } while (false)
+
+// Prints the number of failed checks, the exit code of the test
+inline int ReportChecks(const char* testName)
+{
+    const int failures = GetCheckFailures();
+    std::cout << testName << ": " << (failures == 0 ? "passed" : "failed") << ", " << failures << " failed checks"
+              << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+#include "Check.h"
+#include "Core/CpuTracer.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    // One model with a long merged box along x and a unit box below its far end, instanced without a transform.
+    // A ray down through the long box's far end enters it first, but the unit box's min corner is closer to the origin.
+    struct TestScene
+    {
+        std::vector<VoxMaterial> Palette = {{0xFFFFFFFF, 0.0f}};
+        std::vector<VoxAABB> AABBs = {
+            {glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(7.5f, 0.5f, 0.5f), 1, 0},
+            {glm::vec3(6.5f, -3.5f, -0.5f), glm::vec3(7.5f, -2.5f, 0.5f), 2, 0},
+        };
+        std::vector<VoxelInstance> Instances = {{0, glm::mat3x4(1.0f)}};
+
+        VoxelSceneView MakeView() const
+        {
+            VoxelSceneView view;
+            view.Palette = Palette;
+            view.Models.push_back({glm::vec3(8.0f, 4.0f, 1.0f), AABBs});
+            view.Instances = Instances;
+            return view;
+        }
+    };
+
+    bool Trace(const CpuTracer& tracer, const glm::vec3& origin, const glm::vec3& direction, CpuTracer::Hit& outHit)
+    {
+        return tracer.Intersect({origin, direction, 0.1f, 10000.0f}, outHit);
+    }
+
+    // Merged boxes report their entry distance, the closest entry wins
+    void TestMergedEntryDistance()
+    {
+        ThreadPool pool(1);
+        const TestScene scene;
+
+        for (BvhLayout layout : {BvhLayout::Binary, BvhLayout::Wide})
+        {
+            const CpuTracer tracer(scene.MakeView(), pool, BvhBuildSettings(), layout, true);
+
+            CpuTracer::Hit hit;
+            CHECK(Trace(tracer, glm::vec3(7.0f, 5.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), hit));
+            CHECK(hit.T == 4.5f && hit.Voxel == &scene.AABBs[0]);
+
+            // Off the long box the unit box is entered at its top face
+            CHECK(Trace(tracer, glm::vec3(7.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), hit));
+            CHECK(hit.T == 1.5f && hit.Voxel == &scene.AABBs[1]);
+
+            // Rays that start inside a box have a negative entry distance and don't report it
+            CHECK(!Trace(tracer, glm::vec3(3.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), hit));
+
+            CHECK(!Trace(tracer, glm::vec3(7.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), hit));
+        }
+    }
+
+    // Unit voxels report the distance to the min corner, which picks the unit box here
+    void TestUnitCornerDistance()
+    {
+        ThreadPool pool(1);
+        const TestScene scene;
+        const CpuTracer tracer(scene.MakeView(), pool);
+
+        CpuTracer::Hit hit;
+        CHECK(Trace(tracer, glm::vec3(7.0f, 5.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), hit));
+        CHECK(hit.Voxel == &scene.AABBs[1]);
+        CHECK(hit.T == glm::distance(glm::vec3(7.0f, 5.0f, 0.0f), scene.AABBs[1].Min));
+    }
+} // namespace
+
+int main()
+{
+    TestMergedEntryDistance();
+    TestUnitCornerDistance();
+
+    return ReportChecks("CpuTracerTest");
+}
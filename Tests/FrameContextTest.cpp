@@ -0,0 +1,135 @@
+#include "Check.h"
+#include "Core/FrameContext.h"
+
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // A queue whose submissions complete in order, some time after they were submitted
+    struct SimulatedQueue
+    {
+        uint64_t Completed = 0;
+        std::deque<uint64_t> Pending;
+
+        void Signal(uint64_t value) { Pending.push_back(value); }
+
+        void Wait(uint64_t value)
+        {
+            while (Completed < value)
+                Progress();
+        }
+
+        void Progress()
+        {
+            Completed = Pending.front();
+            Pending.pop_front();
+        }
+    };
+
+    void TestClamping()
+    {
+        CHECK(FrameContext().GetNumFramesInFlight() == FrameContext::MinFramesInFlight);
+        CHECK(FrameContext(0).GetNumFramesInFlight() == 2);
+        CHECK(FrameContext(1).GetNumFramesInFlight() == 2);
+        CHECK(FrameContext(3).GetNumFramesInFlight() == 3);
+        CHECK(FrameContext(4).GetNumFramesInFlight() == 4);
+        CHECK(FrameContext(9).GetNumFramesInFlight() == FrameContext::MaxFramesInFlight);
+    }
+
+    void TestSlots()
+    {
+        for (uint32_t numFrames = FrameContext::MinFramesInFlight; numFrames <= FrameContext::MaxFramesInFlight;
+             numFrames++)
+        {
+            FrameContext context(numFrames);
+            for (uint64_t frame = 0; frame < 50; frame++)
+            {
+                CHECK(context.BeginFrame(frame) == frame % numFrames);
+                CHECK(context.GetSlot() == frame % numFrames);
+                context.EndFrame();
+            }
+
+            // The frame count starts over with every benchmark run
+            CHECK(context.BeginFrame(0) == 0);
+            CHECK(context.BeginFrame(UINT64_MAX) == UINT64_MAX % numFrames);
+        }
+    }
+
+    // Frame N waits for the value frame N - NumFramesInFlight signaled, values outside of the frames don't change that
+    void TestFenceValues()
+    {
+        for (uint32_t numFrames = FrameContext::MinFramesInFlight; numFrames <= FrameContext::MaxFramesInFlight;
+             numFrames++)
+        {
+            FrameContext context(numFrames);
+            CHECK(context.GetLastFenceValue() == 0);
+
+            std::vector<uint64_t> frameValues;
+            uint64_t last = 0;
+            for (uint64_t frame = 0; frame < 40; frame++)
+            {
+                context.BeginFrame(frame);
+                CHECK(context.GetWaitValue() == (frame < numFrames ? 0 : frameValues[frame - numFrames]));
+
+                // Uploads waited for right away
+                if (frame % 7 == 3)
+                {
+                    const uint64_t value = context.NextFenceValue();
+                    CHECK(value == last + 1 && context.GetLastFenceValue() == value);
+                    last = value;
+                }
+
+                const uint64_t value = context.EndFrame();
+                CHECK(value == last + 1 && context.GetLastFenceValue() == value);
+                last = value;
+                frameValues.push_back(value);
+            }
+        }
+    }
+
+    // With a GPU that lags behind by a random amount, a slot is only reused once its last frame completed and the CPU
+    // is never more than NumFramesInFlight frames ahead
+    void TestSimulatedQueue()
+    {
+        std::mt19937 rng(1234);
+
+        for (uint32_t numFrames = FrameContext::MinFramesInFlight; numFrames <= FrameContext::MaxFramesInFlight;
+             numFrames++)
+        {
+            FrameContext context(numFrames);
+            SimulatedQueue queue;
+            std::vector<uint64_t> slotValues(numFrames, 0);
+
+            for (uint64_t frame = 0; frame < 1000; frame++)
+            {
+                const uint32_t slot = context.BeginFrame(frame);
+                queue.Wait(context.GetWaitValue());
+
+                CHECK(queue.Completed >= slotValues[slot]);
+                CHECK(queue.Pending.size() < numFrames);
+
+                slotValues[slot] = context.EndFrame();
+                queue.Signal(slotValues[slot]);
+
+                for (uint32_t i = rng() % 3; i > 0 && !queue.Pending.empty(); i--)
+                    queue.Progress();
+            }
+
+            // Waiting for the last value leaves the GPU idle
+            queue.Wait(context.GetLastFenceValue());
+            CHECK(queue.Pending.empty());
+        }
+    }
+} // namespace
+
+int main()
+{
+    TestClamping();
+    TestSlots();
+    TestFenceValues();
+    TestSimulatedQueue();
+
+    return ReportChecks("FrameContextTest");
+}
@@ -0,0 +1,105 @@
+#include "Check.h"
+#include "Core/QueryRing.h"
+
+#include <vector>
+
+namespace
+{
+    void TestLayout()
+    {
+        const QueryRing ring(3, 4);
+        CHECK(ring.GetQueriesPerFrame() == 4);
+        CHECK(ring.GetNumQueries() == 12);
+        CHECK(ring.GetFirstQuery(2) == 8);
+        CHECK(ring.GetResultOffset(2) == 8 * sizeof(uint64_t));
+    }
+
+    // Frame N writes slot N % NumSlots and gets back the frame that used the slot before it
+    void TestSlotReuse()
+    {
+        QueryRing ring(3, 4);
+        QueryRingFrame completed;
+
+        for (uint64_t frame = 0; frame < 3; frame++)
+        {
+            CHECK(!ring.BeginFrame(frame, completed));
+            CHECK(ring.GetSlot() == frame);
+            CHECK(ring.GetQueryIndex(1) == frame * 4 + 1);
+        }
+
+        for (uint64_t frame = 3; frame < 20; frame++)
+        {
+            CHECK(ring.BeginFrame(frame, completed));
+            CHECK(ring.GetSlot() == frame % 3);
+            CHECK(completed.Frame == frame - 3 && completed.Slot == ring.GetSlot());
+            CHECK(ring.GetQueryIndex(3) == ring.GetSlot() * 4 + 3);
+        }
+
+        // A single slot hands out the previous frame every frame
+        QueryRing single(1, 2);
+        CHECK(!single.BeginFrame(0, completed));
+        CHECK(single.BeginFrame(1, completed) && completed.Frame == 0 && completed.Slot == 0);
+        CHECK(single.BeginFrame(2, completed) && completed.Frame == 1 && completed.Slot == 0);
+    }
+
+    // With N frames in flight, every frame up to the current one minus N has been handed out exactly once by
+    // BeginFrame and Drain hands out the rest in order
+    void TestReadableFrames()
+    {
+        for (uint32_t framesInFlight = 1; framesInFlight <= 4; framesInFlight++)
+        {
+            for (uint64_t numFrames = 0; numFrames < 12; numFrames++)
+            {
+                QueryRing ring(framesInFlight, 2);
+                std::vector<uint64_t> read;
+
+                for (uint64_t frame = 0; frame < numFrames; frame++)
+                {
+                    QueryRingFrame completed;
+                    if (ring.BeginFrame(frame, completed))
+                        read.push_back(completed.Frame);
+
+                    // The frames still in flight are the current one and the N - 1 before it
+                    CHECK(read.size() == (frame + 1 > framesInFlight ? frame + 1 - framesInFlight : 0));
+                }
+
+                for (uint64_t i = 0; i < read.size(); i++)
+                    CHECK(read[i] == i);
+
+                const std::vector<QueryRingFrame> drained = ring.Drain();
+                CHECK(read.size() + drained.size() == numFrames);
+                for (uint64_t i = 0; i < drained.size(); i++)
+                {
+                    CHECK(drained[i].Frame == read.size() + i);
+                    CHECK(drained[i].Slot == drained[i].Frame % framesInFlight);
+                }
+
+                CHECK(ring.Drain().empty());
+            }
+        }
+    }
+
+    // A ring that was drained starts over, the next run's frames count from 0 again
+    void TestRestart()
+    {
+        QueryRing ring(2, 1);
+        QueryRingFrame completed;
+        for (uint64_t frame = 0; frame < 5; frame++)
+            ring.BeginFrame(frame, completed);
+        CHECK(ring.Drain().size() == 2);
+
+        CHECK(!ring.BeginFrame(0, completed));
+        CHECK(!ring.BeginFrame(1, completed));
+        CHECK(ring.BeginFrame(2, completed) && completed.Frame == 0);
+    }
+} // namespace
+
+int main()
+{
+    TestLayout();
+    TestSlotReuse();
+    TestReadableFrames();
+    TestRestart();
+
+    return ReportChecks("QueryRingTest");
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Core/Voxel.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+struct ReferenceHit
+{
+    float T = 0.0f;
+    uint32_t ColorIndex = 0;
+};
+
+// Closest box the ray overlaps within [tMin, tMax], brute force over every box with the slab test. The traversals are
+// checked against it. On an axis the ray is parallel to, a box spans [Min, Max) like voxel v spans [v, v + 1) on a
+// grid, so a ray on the face between two voxels runs through the upper one.
+inline bool IntersectBoxes(std::span<const VoxAABB> boxes, const glm::vec3& origin, const glm::vec3& direction,
+                           float tMin, float tMax, ReferenceHit& outHit)
+{
+    bool found = false;
+
+    for (auto& box : boxes)
+    {
+        float tNear = tMin;
+        float tFar = tMax;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            if (direction[axis] == 0.0f)
+            {
+                if (origin[axis] < box.Min[axis] || origin[axis] >= box.Max[axis])
+                    tFar = -INFINITY;
+                continue;
+            }
+
+            const float t0 = (box.Min[axis] - origin[axis]) / direction[axis];
+            const float t1 = (box.Max[axis] - origin[axis]) / direction[axis];
+            tNear = std::max(tNear, std::min(t0, t1));
+            tFar = std::min(tFar, std::max(t0, t1));
+        }
+
+        if (tNear <= tFar)
+        {
+            tMax = tNear;
+            outHit.T = tNear;
+            outHit.ColorIndex = box.ColorIndex;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// The traversals accumulate their distances, so random rays allow for a little drift
+inline bool NearlyEqual(float a, float b)
+{
+    return std::abs(a - b) <= 1e-3f * std::max(1.0f, std::abs(b));
+}
@@ -0,0 +1,110 @@
+#include "Check.h"
+#include "Core/ScratchBatching.h"
+
+#include <random>
+
+namespace
+{
+    // The batches are consecutive, cover every build once and sum up the aligned sizes of their builds
+    bool CoversInOrder(const std::vector<uint64_t>& sizes, uint64_t alignment, const std::vector<ScratchBatch>& batches)
+    {
+        uint32_t next = 0;
+        for (auto& batch : batches)
+        {
+            if (batch.First != next || batch.Count == 0)
+                return false;
+
+            uint64_t scratchSize = 0;
+            for (uint32_t i = batch.First; i < batch.First + batch.Count; i++)
+                scratchSize += (sizes[i] + alignment - 1) / alignment * alignment;
+            if (scratchSize != batch.ScratchSize)
+                return false;
+
+            next += batch.Count;
+        }
+        return next == sizes.size();
+    }
+
+    void TestEmpty()
+    {
+        const auto batches = PartitionScratchBatches({}, 256, 1024);
+        CHECK(batches.empty());
+        CHECK(GetPeakScratchSize(batches) == 0);
+    }
+
+    void TestUnlimitedBudget()
+    {
+        const std::vector<uint64_t> sizes = {100, 5000, 1, 1 << 20};
+        const auto batches = PartitionScratchBatches(sizes, 256, 0);
+        CHECK(batches.size() == 1);
+        CHECK(CoversInOrder(sizes, 256, batches));
+        CHECK(GetPeakScratchSize(batches) == 256 + 5120 + 256 + (1 << 20));
+    }
+
+    void TestAlignmentPadding()
+    {
+        // 1 and 256 both take one 256 byte slot, 257 takes two
+        const std::vector<uint64_t> sizes = {1, 256, 257, 0};
+        const auto batches = PartitionScratchBatches(sizes, 256, 0);
+        CHECK(batches.size() == 1);
+        CHECK(batches[0].ScratchSize == 256 + 256 + 512);
+
+        // Unaligned the first three would fit in 768 bytes, aligned the third needs a batch of its own
+        const auto budgeted = PartitionScratchBatches(sizes, 256, 768);
+        CHECK(budgeted.size() == 2);
+        CHECK(budgeted[0].First == 0 && budgeted[0].Count == 2 && budgeted[0].ScratchSize == 512);
+        CHECK(budgeted[1].First == 2 && budgeted[1].Count == 2 && budgeted[1].ScratchSize == 512);
+        CHECK(CoversInOrder(sizes, 256, budgeted));
+    }
+
+    void TestBuildLargerThanBudget()
+    {
+        const std::vector<uint64_t> sizes = {100, 4096, 100, 100};
+        const auto batches = PartitionScratchBatches(sizes, 256, 1024);
+        CHECK(batches.size() == 3);
+        CHECK(batches[0].First == 0 && batches[0].Count == 1);
+        CHECK(batches[1].First == 1 && batches[1].Count == 1 && batches[1].ScratchSize == 4096);
+        CHECK(batches[2].First == 2 && batches[2].Count == 2);
+        CHECK(CoversInOrder(sizes, 256, batches));
+
+        // The oversized build is the only one allowed to go over the budget
+        CHECK(GetPeakScratchSize(batches) == 4096);
+    }
+
+    void TestPeakWithinBudget()
+    {
+        std::mt19937 rng(1234);
+        for (uint32_t i = 0; i < 100; i++)
+        {
+            const uint64_t alignment = 1ull << (rng() % 10);
+            const uint64_t budget = alignment * (1 + rng() % 64);
+
+            // Every build fits the budget on its own once aligned
+            std::vector<uint64_t> sizes(rng() % 200);
+            for (auto& size : sizes)
+                size = rng() % (budget + 1);
+
+            const auto batches = PartitionScratchBatches(sizes, alignment, budget);
+            CHECK(CoversInOrder(sizes, alignment, batches));
+            CHECK(GetPeakScratchSize(batches) <= budget);
+
+            // Batches are greedy, the first build of a batch didn't fit into the previous one
+            for (uint32_t b = 1; b < batches.size(); b++)
+            {
+                const uint64_t first = (sizes[batches[b].First] + alignment - 1) / alignment * alignment;
+                CHECK(batches[b - 1].ScratchSize + first > budget);
+            }
+        }
+    }
+} // namespace
+
+int main()
+{
+    TestEmpty();
+    TestUnlimitedBudget();
+    TestAlignmentPadding();
+    TestBuildLargerThanBudget();
+    TestPeakWithinBudget();
+
+    return ReportChecks("ScratchBatchingTest");
+}
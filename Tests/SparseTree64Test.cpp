@@ -0,0 +1,157 @@
+#include "Check.h"
+#include "RayReference.h"
+#include "TestModel.h"
+#include "Core/SparseTree64.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    // The tree finds the voxel the walk over the whole grid finds, the distances only differ in rounding since the
+    // tree works from the voxel corner. Rays that start in a filled voxel have no entry face, their normal is left out.
+    bool MatchesGrid(const VoxelGrid& grid, const SparseTree64& tree, const glm::vec3& origin,
+                     const glm::vec3& direction, float tMin, float tMax)
+    {
+        VoxelGridHit gridHit;
+        const bool hitGrid = TraceVoxelGrid(grid, origin, direction, tMin, tMax, gridHit);
+
+        VoxelGridHit treeHit;
+        const bool hitTree = TraceSparseTree64(tree, origin, direction, tMin, tMax, treeHit);
+
+        if (hitGrid != hitTree)
+            return false;
+
+        return !hitTree || (NearlyEqual(treeHit.T, gridHit.T) && treeHit.Voxel == gridHit.Voxel &&
+                            treeHit.ColorIndex == gridHit.ColorIndex &&
+                            (treeHit.T == 0.0f || treeHit.Normal == gridHit.Normal));
+    }
+
+    // Filled voxels in a few clusters, so the tree has empty cells of every level to skip
+    TestModel MakeClusteredModel(const glm::uvec3& size, uint32_t numClusters, std::mt19937& rng)
+    {
+        TestModel model(size);
+        for (uint32_t c = 0; c < numClusters; c++)
+        {
+            const glm::uvec3 center(rng() % size.x, rng() % size.y, rng() % size.z);
+            const uint32_t radius = 1 + rng() % 4;
+            for (uint32_t z = 0; z < size.z; z++)
+            {
+                for (uint32_t y = 0; y < size.y; y++)
+                {
+                    for (uint32_t x = 0; x < size.x; x++)
+                    {
+                        const glm::ivec3 d = glm::ivec3(x, y, z) - glm::ivec3(center);
+                        if ((uint32_t)(d.x * d.x + d.y * d.y + d.z * d.z) <= radius * radius && rng() % 3 != 0)
+                            model.Fill(x, y, z, 1 + rng() % 255);
+                    }
+                }
+            }
+        }
+
+        return model;
+    }
+
+    void TestBuild()
+    {
+        CHECK(BuildSparseTree64(TestModel(glm::uvec3(4, 4, 4)).Build()).Nodes.empty());
+
+        // The root spans 4^NumLevels voxels
+        CHECK(BuildSparseTree64(TestModel(glm::uvec3(1, 1, 1)).Build()).NumLevels == 1);
+        CHECK(BuildSparseTree64(TestModel(glm::uvec3(4, 2, 3)).Build()).NumLevels == 1);
+        CHECK(BuildSparseTree64(TestModel(glm::uvec3(5, 2, 3)).Build()).NumLevels == 2);
+        CHECK(BuildSparseTree64(TestModel(glm::uvec3(3, 16, 3)).Build()).NumLevels == 2);
+        CHECK(BuildSparseTree64(TestModel(glm::uvec3(3, 3, 17)).Build()).NumLevels == 3);
+
+        std::mt19937 rng(1234);
+        const TestModel model = MakeClusteredModel(glm::uvec3(37, 21, 18), 4, rng);
+        const SparseTree64 tree = BuildSparseTree64(model.Build());
+        CHECK(tree.Colors.size() == model.AABBs.size());
+
+        VoxelGridHit hit;
+        CHECK(!TraceSparseTree64(SparseTree64(), glm::vec3(-2.0f), glm::vec3(1.0f), 0.0f, 100.0f, hit));
+    }
+
+    // Rays along every axis in both directions through voxel centers and along the faces between voxels, 4^1 and 4^2
+    // cells and the model's bounds, with +0 and -0 in the other components
+    void TestAxisParallel()
+    {
+        std::mt19937 rng(1234);
+        const TestModel model = MakeClusteredModel(glm::uvec3(37, 21, 18), 6, rng);
+        const VoxelGrid grid = model.Build();
+        const SparseTree64 tree = BuildSparseTree64(grid);
+
+        const float zeros[] = {0.0f, -0.0f};
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const uint32_t u = (axis + 1) % 3;
+            const uint32_t v = (axis + 2) % 3;
+
+            for (float sign : {1.0f, -1.0f})
+            {
+                for (float position = -1.0f; position <= (float)model.Size[u]; position += 0.5f)
+                {
+                    for (float other = -1.0f; other <= (float)model.Size[v]; other += 0.5f)
+                    {
+                        glm::vec3 origin;
+                        origin[u] = position;
+                        origin[v] = other;
+
+                        for (uint32_t i = 0; i < 4; i++)
+                        {
+                            glm::vec3 direction;
+                            direction[axis] = sign;
+                            direction[u] = zeros[i % 2];
+                            direction[v] = zeros[i / 2];
+
+                            // From outside the model and from the inside, starting on a face
+                            origin[axis] = sign > 0.0f ? -2.0f : model.Size[axis] + 2.0f;
+                            CHECK(MatchesGrid(grid, tree, origin, direction, 0.0f, 1000.0f));
+                            origin[axis] = 3.5f;
+                            CHECK(MatchesGrid(grid, tree, origin, direction, 0.0f, 1000.0f));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void TestRandomGrids()
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for (uint32_t i = 0; i < 40; i++)
+        {
+            // Sizes that aren't powers of 4 leave the root partially outside the model
+            const glm::uvec3 size(1 + rng() % 40, 1 + rng() % 40, 1 + rng() % 40);
+            const TestModel model = MakeClusteredModel(size, 1 + rng() % 6, rng);
+            const VoxelGrid grid = model.Build();
+            const SparseTree64 tree = BuildSparseTree64(grid);
+
+            const glm::vec3 extent = glm::vec3(size);
+            const glm::vec3 center = extent * 0.5f - 0.5f;
+            auto randomPoint = [&]() { return glm::vec3(unit(rng), unit(rng), unit(rng)) * extent - 0.5f; };
+
+            for (uint32_t r = 0; r < 200; r++)
+            {
+                // Half the rays start inside the model, the others on a sphere around it
+                glm::vec3 origin = randomPoint();
+                if (r % 2 == 0)
+                    origin = center + glm::normalize(randomPoint() - center + 0.01f) * glm::length(extent);
+
+                const float tMin = r % 4 == 1 ? unit(rng) : 0.0f;
+                CHECK(MatchesGrid(grid, tree, origin, randomPoint() - origin, tMin, 1000.0f));
+            }
+        }
+    }
+} // namespace
+
+int main()
+{
+    TestBuild();
+    TestAxisParallel();
+    TestRandomGrids();
+
+    return ReportChecks("SparseTree64Test");
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Core/VoxelGrid.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Hand made model of unit voxels, voxel v spans [v - 0.5, v + 0.5] like the boxes of the extraction
+struct TestModel
+{
+    glm::uvec3 Size;
+    std::vector<VoxAABB> AABBs;
+
+    explicit TestModel(const glm::uvec3& size) : Size(size) {}
+
+    void Fill(uint32_t x, uint32_t y, uint32_t z, uint32_t colorIndex)
+    {
+        const glm::vec3 center = glm::vec3(glm::uvec3(x, y, z));
+        AABBs.push_back({center - 0.5f, center + 0.5f, colorIndex, 0});
+    }
+
+    VoxelGrid Build() const { return BuildVoxelGrid({glm::vec3(Size), AABBs}); }
+};
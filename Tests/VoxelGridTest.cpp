@@ -0,0 +1,262 @@
+#include "Check.h"
+#include "RayReference.h"
+#include "TestModel.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // The walk finds the same closest voxel as the slab test over every box
+    bool MatchesReference(const TestModel& model, const VoxelGrid& grid, const glm::vec3& origin,
+                          const glm::vec3& direction, float tMin, float tMax)
+    {
+        ReferenceHit expected;
+        const bool boxHit = IntersectBoxes(model.AABBs, origin, direction, tMin, tMax, expected);
+
+        VoxelGridHit hit;
+        const bool gridHit = TraceVoxelGrid(grid, origin, direction, tMin, tMax, hit);
+
+        if (gridHit != boxHit)
+            return false;
+
+        return !gridHit || (NearlyEqual(hit.T, expected.T) && hit.ColorIndex == expected.ColorIndex &&
+                            grid.GetColorIndex(hit.Voxel) == hit.ColorIndex);
+    }
+
+    void TestEmptyGrid()
+    {
+        VoxelGridHit hit;
+        CHECK(!TraceVoxelGrid(VoxelGrid(), glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f, 100.0f, hit));
+
+        const TestModel model(glm::uvec3(4, 4, 4));
+        CHECK(!TraceVoxelGrid(model.Build(), glm::vec3(-2.0f, 1.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f, 100.0f,
+                              hit));
+    }
+
+    void TestStartInside()
+    {
+        TestModel model(glm::uvec3(5, 5, 5));
+        model.Fill(2, 2, 2, 7);
+        model.Fill(4, 2, 2, 8);
+        const VoxelGrid grid = model.Build();
+
+        // Starting in a filled voxel hits it right away
+        VoxelGridHit hit;
+        CHECK(TraceVoxelGrid(grid, glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f, 100.0f, hit));
+        CHECK(hit.T == 0.0f && hit.Voxel == glm::uvec3(2, 2, 2) && hit.ColorIndex == 7);
+
+        // Unless tMin is past it, x = 3 is in the empty voxel between the two
+        CHECK(TraceVoxelGrid(grid, glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(1.0f, 0.0f, 0.0f), 1.0f, 100.0f, hit));
+        CHECK(hit.T == 1.5f && hit.Voxel == glm::uvec3(4, 2, 2) && hit.ColorIndex == 8);
+        CHECK(hit.Normal == glm::vec3(-1.0f, 0.0f, 0.0f));
+
+        // Starting in an empty voxel walks to the next filled one
+        CHECK(TraceVoxelGrid(grid, glm::vec3(0.0f, 2.0f, 2.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f, 100.0f, hit));
+        CHECK(hit.T == 1.5f && hit.Voxel == glm::uvec3(2, 2, 2));
+
+        CHECK(TraceVoxelGrid(grid, glm::vec3(2.0f, 0.25f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, 100.0f, hit));
+        CHECK(hit.T == 1.25f && hit.Voxel == glm::uvec3(2, 2, 2) && hit.Normal == glm::vec3(0.0f, -1.0f, 0.0f));
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> inside(-0.5f, 4.5f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        for (uint32_t i = 0; i < 1000; i++)
+        {
+            const glm::vec3 origin(inside(rng), inside(rng), inside(rng));
+            const glm::vec3 direction(unit(rng), unit(rng), unit(rng));
+            CHECK(MatchesReference(model, grid, origin, direction, 0.0f, 100.0f));
+        }
+    }
+
+    // Rays that run along the faces of a voxel or pass its edges just inside or outside. Rays that only touch an edge
+    // or a corner are left out, the walk passes them on one side or the other depending on its tie break.
+    void TestGrazing()
+    {
+        TestModel model(glm::uvec3(4, 4, 4));
+        model.Fill(1, 1, 1, 3);
+        const VoxelGrid grid = model.Build();
+
+        const glm::vec3 direction(1.0f, 0.0f, 0.0f);
+        VoxelGridHit hit;
+
+        // The voxel spans [0.5, 1.5) on the axes the ray is parallel to
+        CHECK(TraceVoxelGrid(grid, glm::vec3(-2.0f, 0.5f, 1.0f), direction, 0.0f, 100.0f, hit));
+        CHECK(hit.T == 2.5f && hit.Voxel == glm::uvec3(1, 1, 1));
+        CHECK(!TraceVoxelGrid(grid, glm::vec3(-2.0f, 1.5f, 1.0f), direction, 0.0f, 100.0f, hit));
+        CHECK(TraceVoxelGrid(grid, glm::vec3(-2.0f, 0.5f, 0.5f), direction, 0.0f, 100.0f, hit));
+        CHECK(!TraceVoxelGrid(grid, glm::vec3(-2.0f, 0.5f, 1.5f), direction, 0.0f, 100.0f, hit));
+
+        for (float offset : {-1e-3f, 1e-3f})
+        {
+            for (float face : {0.5f, 1.5f})
+            {
+                CHECK(MatchesReference(model, grid, glm::vec3(-2.0f, face + offset, 1.0f), direction, 0.0f, 100.0f));
+                CHECK(MatchesReference(model, grid, glm::vec3(-2.0f, 1.0f, face + offset), direction, 0.0f, 100.0f));
+            }
+
+            // Diagonals past the edge at x = 1.5, y = 0.5 and the corner at the grid's min
+            CHECK(MatchesReference(model, grid, glm::vec3(-1.0f, -2.0f + offset, 1.0f), glm::vec3(1.0f, 1.0f, 0.0f),
+                                   0.0f, 100.0f));
+            CHECK(MatchesReference(model, grid, glm::vec3(-2.0f + offset, -1.0f, 1.0f), glm::vec3(1.0f, 1.0f, 0.0f),
+                                   0.0f, 100.0f));
+        }
+
+        TestModel full(glm::uvec3(4, 4, 4));
+        for (uint32_t z = 0; z < 4; z++)
+            for (uint32_t y = 0; y < 4; y++)
+                for (uint32_t x = 0; x < 4; x++)
+                    full.Fill(x, y, z, 1 + x);
+        const VoxelGrid fullGrid = full.Build();
+
+        // Along the outside of the grid's faces and past its corners at a shallow angle
+        for (float offset : {-1e-3f, 1e-3f})
+        {
+            CHECK(MatchesReference(full, fullGrid, glm::vec3(-2.0f, -0.5f + offset, 1.0f), direction, 0.0f, 100.0f));
+            CHECK(MatchesReference(full, fullGrid, glm::vec3(-2.0f, 3.5f + offset, 1.0f), direction, 0.0f, 100.0f));
+            CHECK(MatchesReference(full, fullGrid, glm::vec3(-10.0f, -0.5f + offset, 1.0f),
+                                   glm::vec3(1.0f, 0.01f, 0.0f), 0.0f, 100.0f));
+            CHECK(MatchesReference(full, fullGrid, glm::vec3(-10.0f, 3.6f + offset, 1.0f),
+                                   glm::vec3(1.0f, -0.01f, 0.0f), 0.0f, 100.0f));
+        }
+    }
+
+    // Axis parallel rays with every combination of +0 and -0 in the other components, from voxel centers and from the
+    // faces between voxels
+    void TestZeroComponents()
+    {
+        TestModel model(glm::uvec3(4, 4, 4));
+        for (uint32_t z = 0; z < 4; z++)
+            for (uint32_t y = 0; y < 4; y++)
+                for (uint32_t x = 0; x < 4; x++)
+                    if ((x + y + z) % 3 == 0 && x != 1)
+                        model.Fill(x, y, z, 1 + (x + 2 * y + 3 * z) % 255);
+        const VoxelGrid grid = model.Build();
+
+        const float zeros[] = {0.0f, -0.0f};
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const uint32_t u = (axis + 1) % 3;
+            const uint32_t v = (axis + 2) % 3;
+
+            for (float sign : {1.0f, -1.0f})
+            {
+                for (float position = -1.0f; position <= 4.0f; position += 0.5f)
+                {
+                    for (float other = -1.0f; other <= 4.0f; other += 0.5f)
+                    {
+                        glm::vec3 origin;
+                        origin[axis] = sign > 0.0f ? -2.0f : 6.0f;
+                        origin[u] = position;
+                        origin[v] = other;
+
+                        bool firstHit = false;
+                        VoxelGridHit first = {};
+                        for (uint32_t i = 0; i < 4; i++)
+                        {
+                            glm::vec3 direction;
+                            direction[axis] = sign;
+                            direction[u] = zeros[i % 2];
+                            direction[v] = zeros[i / 2];
+                            CHECK(MatchesReference(model, grid, origin, direction, 0.0f, 100.0f));
+
+                            // The sign of a zero doesn't change the voxel that is hit
+                            VoxelGridHit hit;
+                            const bool gridHit = TraceVoxelGrid(grid, origin, direction, 0.0f, 100.0f, hit);
+                            if (i == 0)
+                            {
+                                firstHit = gridHit;
+                                first = hit;
+                            }
+                            else
+                            {
+                                CHECK(gridHit == firstHit);
+                                CHECK(!gridHit || (hit.T == first.T && hit.Voxel == first.Voxel));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Hits exactly at tMin and tMax count, the distances are exact in binary so the walk has no drift
+    void TestRangeEdges()
+    {
+        TestModel model(glm::uvec3(8, 1, 1));
+        model.Fill(5, 0, 0, 4);
+        const VoxelGrid grid = model.Build();
+
+        const glm::vec3 forward(1.0f, 0.0f, 0.0f);
+        const glm::vec3 origin(-2.0f, 0.0f, 0.0f);
+        VoxelGridHit hit;
+
+        // The ray enters voxel 5 at x = 4.5
+        CHECK(TraceVoxelGrid(grid, origin, forward, 0.0f, 6.5f, hit) && hit.T == 6.5f);
+        CHECK(!TraceVoxelGrid(grid, origin, forward, 0.0f, std::nextafter(6.5f, 0.0f), hit));
+        CHECK(TraceVoxelGrid(grid, origin, forward, 6.5f, 100.0f, hit) && hit.T == 6.5f);
+        CHECK(TraceVoxelGrid(grid, origin, forward, 7.0f, 100.0f, hit) && hit.T == 7.0f);
+        CHECK(TraceVoxelGrid(grid, origin, forward, 7.0f, 7.0f, hit) && hit.T == 7.0f);
+        CHECK(!TraceVoxelGrid(grid, origin, forward, 8.0f, 100.0f, hit));
+
+        // T is in units of the direction
+        CHECK(TraceVoxelGrid(grid, origin, 2.0f * forward, 0.0f, 3.25f, hit) && hit.T == 3.25f);
+        CHECK(!TraceVoxelGrid(grid, origin, 2.0f * forward, 0.0f, std::nextafter(3.25f, 0.0f), hit));
+
+        // And from the other side through x = 5.5
+        const glm::vec3 back(-1.0f, 0.0f, 0.0f);
+        CHECK(TraceVoxelGrid(grid, glm::vec3(10.0f, 0.0f, 0.0f), back, 0.0f, 4.5f, hit) && hit.T == 4.5f);
+        CHECK(hit.Normal == glm::vec3(1.0f, 0.0f, 0.0f));
+        CHECK(!TraceVoxelGrid(grid, glm::vec3(10.0f, 0.0f, 0.0f), back, 0.0f, std::nextafter(4.5f, 0.0f), hit));
+        CHECK(TraceVoxelGrid(grid, glm::vec3(10.0f, 0.0f, 0.0f), back, 4.5f, 100.0f, hit) && hit.T == 4.5f);
+
+        // An empty range past the voxel misses
+        CHECK(!TraceVoxelGrid(grid, origin, forward, 20.0f, 10.0f, hit));
+    }
+
+    void TestRandomGrids()
+    {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        for (uint32_t i = 0; i < 50; i++)
+        {
+            TestModel model(glm::uvec3(1 + rng() % 20, 1 + rng() % 20, 1 + rng() % 20));
+            const uint32_t density = 2 + rng() % 16;
+            for (uint32_t z = 0; z < model.Size.z; z++)
+                for (uint32_t y = 0; y < model.Size.y; y++)
+                    for (uint32_t x = 0; x < model.Size.x; x++)
+                        if (rng() % density == 0)
+                            model.Fill(x, y, z, 1 + rng() % 255);
+            const VoxelGrid grid = model.Build();
+
+            const glm::vec3 size = glm::vec3(model.Size);
+            const glm::vec3 center = size * 0.5f - 0.5f;
+            auto randomPoint = [&]() { return glm::vec3(unit(rng), unit(rng), unit(rng)) * size - 0.5f; };
+
+            for (uint32_t r = 0; r < 200; r++)
+            {
+                // Half the rays start inside the grid, the others on a sphere around it
+                glm::vec3 origin = randomPoint();
+                if (r % 2 == 0)
+                    origin = center + glm::normalize(randomPoint() - center + 0.01f) * glm::length(size);
+
+                const glm::vec3 direction = randomPoint() - origin;
+                CHECK(MatchesReference(model, grid, origin, direction, 0.0f, 1000.0f));
+            }
+        }
+    }
+} // namespace
+
+int main()
+{
+    TestEmptyGrid();
+    TestStartInside();
+    TestGrazing();
+    TestZeroComponents();
+    TestRangeEdges();
+    TestRandomGrids();
+
+    return ReportChecks("VoxelGridTest");
+}
@@ -0,0 +1,173 @@
+#include "Check.h"
+#include "Core/VoxelMerge.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    // Hand made occupancy grid, indexed like ogt_vox_model::voxel_data
+    struct Grid
+    {
+        uint32_t SizeX;
+        uint32_t SizeY;
+        uint32_t SizeZ;
+        std::vector<uint8_t> Voxels;
+
+        Grid(uint32_t x, uint32_t y, uint32_t z) : SizeX(x), SizeY(y), SizeZ(z), Voxels((uint64_t)x * y * z, 0) {}
+
+        uint8_t& At(uint32_t x, uint32_t y, uint32_t z) { return Voxels[x + y * SizeX + (uint64_t)z * SizeX * SizeY]; }
+    };
+
+    // Independent of ValidateMergedVoxels: every filled voxel is covered by exactly one box of its color and no empty
+    // voxel by any box
+    bool CoversExactly(const Grid& grid, const std::vector<VoxAABB>& boxes)
+    {
+        std::vector<uint32_t> coverage(grid.Voxels.size(), 0);
+        for (auto& box : boxes)
+        {
+            const glm::ivec3 min = glm::ivec3(std::lround(box.Min.x + 0.5f), std::lround(box.Min.y + 0.5f),
+                                              std::lround(box.Min.z + 0.5f));
+            const glm::ivec3 max = glm::ivec3(std::lround(box.Max.x - 0.5f), std::lround(box.Max.y - 0.5f),
+                                              std::lround(box.Max.z - 0.5f));
+            if (min.x < 0 || min.y < 0 || min.z < 0 || max.x >= (int)grid.SizeX || max.y >= (int)grid.SizeY ||
+                max.z >= (int)grid.SizeZ || min.x > max.x || min.y > max.y || min.z > max.z)
+                return false;
+
+            for (int z = min.z; z <= max.z; z++)
+            {
+                for (int y = min.y; y <= max.y; y++)
+                {
+                    for (int x = min.x; x <= max.x; x++)
+                    {
+                        const uint64_t index = x + y * grid.SizeX + (uint64_t)z * grid.SizeX * grid.SizeY;
+                        if (grid.Voxels[index] != box.ColorIndex)
+                            return false;
+                        coverage[index]++;
+                    }
+                }
+            }
+        }
+
+        for (uint64_t i = 0; i < grid.Voxels.size(); i++)
+        {
+            if (coverage[i] != (grid.Voxels[i] != 0 ? 1u : 0u))
+                return false;
+        }
+        return true;
+    }
+
+    std::vector<VoxAABB> Merge(const Grid& grid, VoxelMergeStats& stats)
+    {
+        std::vector<VoxAABB> boxes;
+        MergeVoxels(grid.Voxels.data(), grid.SizeX, grid.SizeY, grid.SizeZ, boxes, stats);
+        return boxes;
+    }
+
+    void TestEmpty()
+    {
+        Grid grid(4, 4, 4);
+        VoxelMergeStats stats;
+        const auto boxes = Merge(grid, stats);
+        CHECK(boxes.empty());
+        CHECK(stats.VoxelsIn == 0);
+    }
+
+    void TestSingleVoxel()
+    {
+        Grid grid(5, 6, 7);
+        grid.At(2, 3, 4) = 9;
+
+        VoxelMergeStats stats;
+        const auto boxes = Merge(grid, stats);
+        CHECK(boxes.size() == 1);
+        CHECK(stats.VoxelsIn == 1 && stats.BoxesOut == 1);
+        CHECK(CoversExactly(grid, boxes));
+        if (boxes.size() == 1)
+        {
+            CHECK(boxes[0].Min == glm::vec3(1.5f, 2.5f, 3.5f));
+            CHECK(boxes[0].Max == glm::vec3(2.5f, 3.5f, 4.5f));
+            CHECK(boxes[0].ColorIndex == 9);
+        }
+    }
+
+    void TestColorBoundaries()
+    {
+        // Two halves of different colors never share a box
+        Grid halves(8, 4, 4);
+        for (uint32_t z = 0; z < 4; z++)
+            for (uint32_t y = 0; y < 4; y++)
+                for (uint32_t x = 0; x < 8; x++)
+                    halves.At(x, y, z) = x < 3 ? 1 : 2;
+
+        VoxelMergeStats stats;
+        auto boxes = Merge(halves, stats);
+        CHECK(boxes.size() == 2);
+        CHECK(CoversExactly(halves, boxes));
+
+        // A checkerboard can't merge at all
+        Grid checker(6, 6, 6);
+        for (uint32_t z = 0; z < 6; z++)
+            for (uint32_t y = 0; y < 6; y++)
+                for (uint32_t x = 0; x < 6; x++)
+                    checker.At(x, y, z) = (x + y + z) % 2 ? 3 : 4;
+
+        boxes = Merge(checker, stats);
+        CHECK(boxes.size() == checker.Voxels.size());
+        CHECK(CoversExactly(checker, boxes));
+    }
+
+    void TestFullSlabs()
+    {
+        // The largest .vox model, filled with one color, is one box
+        Grid full(256, 256, 256);
+        std::fill(full.Voxels.begin(), full.Voxels.end(), 7);
+
+        VoxelMergeStats stats;
+        auto boxes = Merge(full, stats);
+        CHECK(boxes.size() == 1);
+        CHECK(stats.VoxelsIn == full.Voxels.size());
+        CHECK(CoversExactly(full, boxes));
+
+        // One layer in another color splits it into three slabs
+        for (uint32_t y = 0; y < 256; y++)
+            for (uint32_t x = 0; x < 256; x++)
+                full.At(x, y, 100) = 8;
+
+        boxes = Merge(full, stats);
+        CHECK(boxes.size() == 3);
+        CHECK(CoversExactly(full, boxes));
+    }
+
+    void TestRandomGrids()
+    {
+        std::mt19937 rng(1234);
+        for (uint32_t i = 0; i < 50; i++)
+        {
+            Grid grid(1 + rng() % 24, 1 + rng() % 24, 1 + rng() % 24);
+
+            // Few colors and mostly filled so boxes grow across many voxels and stop at color changes
+            const uint32_t numColors = 1 + rng() % 3;
+            for (auto& voxel : grid.Voxels)
+                voxel = rng() % 4 == 0 ? 0 : 1 + rng() % numColors;
+
+            VoxelMergeStats stats;
+            const auto boxes = Merge(grid, stats);
+            CHECK(CoversExactly(grid, boxes));
+            CHECK(ValidateMergedVoxels(grid.Voxels.data(), grid.SizeX, grid.SizeY, grid.SizeZ, boxes));
+            CHECK(stats.BoxesOut == boxes.size());
+        }
+    }
+} // namespace
+
+int main()
+{
+    TestEmpty();
+    TestSingleVoxel();
+    TestColorBoundaries();
+    TestFullSlabs();
+    TestRandomGrids();
+
+    return ReportChecks("VoxelMergeTest");
+}